@@ -0,0 +1,302 @@
+#ifndef ASSET_ARCHIVE_HPP
+#define ASSET_ARCHIVE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Lz4.hpp"
+#include "MappedFile.hpp"
+
+namespace assets
+{
+    // what an entry holds, an asset path can have one of each
+    enum EntryType : uint32_t
+    {
+        Mesh = 1,  // ModelSource::writePacked: lods, bounds, interleaved vertices and the bvh
+        Image = 2, // the decoded pixels, rows already in the order they're uploaded in, then an ImageInfo
+        Text = 3,  // shader sources, as they are on disk
+    };
+
+    enum EntryFlags : uint32_t
+    {
+        Compressed = 1 << 0, // lz4 block, storedSize bytes that unpack to size
+    };
+
+    // at the end of an Image entry, so the pixels start the entry and can be used (or freed) from there
+    struct ImageInfo
+    {
+        int32_t width;
+        int32_t height;
+        int32_t channels;
+        uint32_t flipped; // rows bottom up, the way model textures are loaded
+    };
+
+    // one archive (Assets.pak, made by Tools/Pack.cpp) holding everything the game loads from disk. it's mapped
+    // rather than read: the table of contents is used in place, stored entries are handed out as pointers into
+    // the mapping and go to GL from there, compressed ones unpack straight into the memory that gets uploaded.
+    // loaders ask it first and fall back to the loose files when it isn't open or doesn't have something
+    class AssetArchive
+    {
+    public:
+        static constexpr uint32_t magic = 0x4b504447; // "GDPK"
+        static constexpr uint32_t version = 1;
+        static constexpr size_t alignment = 64; // every entry starts on a cache line
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t namesOffset;
+            uint32_t namesBytes;
+            uint32_t padding[3];
+        };
+
+        // the table of contents follows the header, sorted by name hash then type
+        struct Entry
+        {
+            uint64_t nameHash;
+            uint32_t nameOffset; // into the names block
+            uint32_t type;
+            uint64_t offset;     // from the start of the file
+            uint64_t storedSize; // bytes in the file
+            uint64_t size;       // bytes once unpacked
+            uint32_t flags;
+            uint32_t padding;
+        };
+
+    private:
+        MappedFile file;
+        const Entry *entries = nullptr;
+        uint32_t entryCount = 0;
+        const char *names = nullptr;
+
+    public:
+        static AssetArchive &get()
+        {
+            static AssetArchive archive;
+            return archive;
+        }
+
+        bool open(const std::string &path)
+        {
+            close();
+            if (!file.open(path))
+                return false;
+
+            const unsigned char *data = file.data();
+            Header header;
+            if (file.size() < sizeof(header))
+                return fail(path);
+            std::memcpy(&header, data, sizeof(header));
+
+            size_t tocEnd = sizeof(Header) + size_t(header.entryCount) * sizeof(Entry);
+            if (header.magic != magic || header.version != version || tocEnd > file.size() ||
+                size_t(header.namesOffset) + header.namesBytes > file.size() || header.namesBytes == 0 ||
+                data[header.namesOffset + header.namesBytes - 1] != '\0')
+                return fail(path);
+
+            entries = (const Entry *)(data + sizeof(Header));
+            entryCount = header.entryCount;
+            names = (const char *)data + header.namesOffset;
+            for (uint32_t i = 0; i < entryCount; i++)
+            {
+                const Entry &entry = entries[i];
+                if (entry.offset > file.size() || entry.storedSize > file.size() - entry.offset || entry.nameOffset >= header.namesBytes ||
+                    (!(entry.flags & Compressed) && entry.storedSize != entry.size))
+                    return fail(path);
+            }
+
+            std::cout << "mapped " << path << " (" << entryCount << " assets, " << file.size() / 1024 << " KB)" << std::endl;
+            return true;
+        }
+
+        void close()
+        {
+            file.close();
+            entries = nullptr;
+            entryCount = 0;
+            names = nullptr;
+        }
+
+        bool isOpen() const { return file.isOpen(); }
+        uint32_t getEntryCount() const { return entryCount; }
+        const Entry &getEntry(uint32_t index) const { return entries[index]; }
+        const char *getName(const Entry &entry) const { return names + entry.nameOffset; }
+
+        // nullptr when it isn't in the archive (or the archive isn't open)
+        const Entry *find(const std::string &name, uint32_t type) const
+        {
+            if (!entries)
+                return nullptr;
+
+            uint64_t nameHash = hashName(name);
+            const Entry *found = std::lower_bound(entries, entries + entryCount, nameHash, [](const Entry &entry, uint64_t value)
+                                                  { return entry.nameHash < value; });
+            for (; found != entries + entryCount && found->nameHash == nameHash; found++)
+            {
+                if (found->type == type && name == getName(*found))
+                    return found;
+            }
+            return nullptr;
+        }
+
+        // an uncompressed entry's bytes, in place in the mapping
+        const unsigned char *getMapped(const Entry &entry) const
+        {
+            return entry.flags & Compressed ? nullptr : file.data() + entry.offset;
+        }
+
+        // an entry's bytes into destination (entry.size of them), for compressed entries or when a copy is wanted
+        bool unpack(const Entry &entry, unsigned char *destination) const
+        {
+            const unsigned char *stored = file.data() + entry.offset;
+            if (!(entry.flags & Compressed))
+            {
+                std::memcpy(destination, stored, entry.size);
+                return true;
+            }
+            if (!lz4::decompress(stored, entry.storedSize, destination, entry.size))
+            {
+                std::cout << "Error unpacking " << getName(entry) << " from the asset archive!" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // fnv-1a of the path as the loaders spell it
+        static uint64_t hashName(const std::string &name)
+        {
+            uint64_t h = 14695981039346656037ull;
+            for (unsigned char c : name)
+            {
+                h ^= c;
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+    private:
+        bool fail(const std::string &path)
+        {
+            std::cout << "Error loading asset archive! " << path << " isn't one (or is from another version)" << std::endl;
+            close();
+            return false;
+        }
+    };
+
+    // collects entries for an archive and writes it out, used by Tools/Pack.cpp
+    class ArchiveWriter
+    {
+    private:
+        struct Pending
+        {
+            std::string name;
+            uint32_t type;
+            uint32_t flags;
+            uint64_t size;
+            std::vector<unsigned char> bytes;
+        };
+
+        std::vector<Pending> pending;
+
+    public:
+        // compress only keeps the lz4 block when it saves at least an eighth, otherwise decoding isn't worth it
+        void add(const std::string &name, uint32_t type, const void *data, size_t size, bool compress)
+        {
+            Pending entry{name, type, 0, size, {}};
+            const unsigned char *bytes = (const unsigned char *)data;
+            if (compress && size > 0)
+            {
+                lz4::compress(bytes, size, entry.bytes);
+                if (entry.bytes.size() <= size - size / 8)
+                    entry.flags |= Compressed;
+                else
+                    entry.bytes.clear();
+            }
+            if (!(entry.flags & Compressed))
+                entry.bytes.assign(bytes, bytes + size);
+            pending.push_back(std::move(entry));
+        }
+
+        size_t getEntryCount() const { return pending.size(); }
+
+        bool contains(const std::string &name, uint32_t type) const
+        {
+            for (const Pending &entry : pending)
+            {
+                if (entry.type == type && entry.name == name)
+                    return true;
+            }
+            return false;
+        }
+
+        // bytes written, 0 if it failed
+        uint64_t write(const std::string &path) const
+        {
+            std::vector<AssetArchive::Entry> toc(pending.size());
+            std::string names;
+            for (size_t i = 0; i < pending.size(); i++)
+            {
+                toc[i] = {AssetArchive::hashName(pending[i].name), uint32_t(names.size()), pending[i].type, 0,
+                          pending[i].bytes.size(), pending[i].size, pending[i].flags, 0};
+                names.append(pending[i].name).push_back('\0');
+            }
+
+            // entries keep the order they were added in the file, the table is sorted for lookups
+            uint64_t offset = align(sizeof(AssetArchive::Header) + toc.size() * sizeof(AssetArchive::Entry) + names.size());
+            for (size_t i = 0; i < toc.size(); i++)
+            {
+                toc[i].offset = offset;
+                offset = align(offset + toc[i].storedSize);
+            }
+            std::vector<size_t> order(toc.size());
+            for (size_t i = 0; i < order.size(); i++)
+                order[i] = i;
+            std::sort(order.begin(), order.end(), [&toc](size_t a, size_t b)
+                      { return toc[a].nameHash != toc[b].nameHash ? toc[a].nameHash < toc[b].nameHash : toc[a].type < toc[b].type; });
+
+            AssetArchive::Header header{AssetArchive::magic, AssetArchive::version, uint32_t(toc.size()),
+                                        uint32_t(sizeof(AssetArchive::Header) + toc.size() * sizeof(AssetArchive::Entry)), uint32_t(names.size()), {}};
+
+            std::string tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                file.write((const char *)&header, sizeof(header));
+                for (size_t index : order)
+                    file.write((const char *)&toc[index], sizeof(AssetArchive::Entry));
+                file.write(names.data(), names.size());
+
+                static const char zeros[AssetArchive::alignment] = {};
+                uint64_t written = sizeof(header) + toc.size() * sizeof(AssetArchive::Entry) + names.size();
+                for (size_t i = 0; i < pending.size(); i++)
+                {
+                    file.write(zeros, toc[i].offset - written);
+                    file.write((const char *)pending[i].bytes.data(), pending[i].bytes.size());
+                    written = toc[i].offset + toc[i].storedSize;
+                }
+                if (!file)
+                    return 0;
+                offset = written;
+            }
+
+            std::error_code error;
+            std::filesystem::rename(tempPath, path, error);
+            return error ? 0 : offset;
+        }
+
+    private:
+        static uint64_t align(uint64_t offset)
+        {
+            return (offset + AssetArchive::alignment - 1) & ~uint64_t(AssetArchive::alignment - 1);
+        }
+    };
+} // namespace assets
+
+#endif // !ASSET_ARCHIVE_HPP
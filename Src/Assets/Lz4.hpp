@@ -0,0 +1,170 @@
+#ifndef LZ4_HPP
+#define LZ4_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace assets
+{
+    // the lz4 block format (the same bytes lz4's LZ4_compress_default/LZ4_decompress_safe use), small enough to
+    // keep here instead of pulling in the library. greedy matching through a hash of the next 4 bytes:
+    // nowhere near the best ratio, but decoding is little more than memcpy, which is what loading wants
+    namespace lz4
+    {
+        static const int minMatch = 4;
+        static const int lastLiterals = 5;  // the format ends every block with at least this many literals
+        static const int matchSafeEnd = 12; // and no match may start closer than this to the end
+        static const int hashBits = 14;
+        static const size_t maxOffset = 65535;
+
+        inline size_t compressBound(size_t size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        inline uint32_t read32(const uint8_t *p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        inline uint32_t hash(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - hashBits);
+        }
+
+        // length past the 15 a token nibble holds, as a run of 255s and a final byte
+        inline void writeLength(std::vector<uint8_t> &out, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                out.push_back(255);
+            out.push_back(uint8_t(length));
+        }
+
+        // appends the compressed block to out
+        inline void compress(const uint8_t *source, size_t size, std::vector<uint8_t> &out)
+        {
+            out.reserve(out.size() + compressBound(size));
+            std::vector<uint32_t> table(size_t(1) << hashBits, 0); // position + 1 of the last time each hash was seen
+
+            size_t anchor = 0; // first literal not written yet
+            size_t i = 0;
+            size_t matchLimit = size > size_t(matchSafeEnd) ? size - matchSafeEnd : 0;
+
+            while (i < matchLimit)
+            {
+                uint32_t sequence = read32(source + i);
+                uint32_t &slot = table[hash(sequence)];
+                size_t candidate = slot;
+                slot = uint32_t(i + 1);
+
+                if (candidate == 0 || i - (candidate - 1) > maxOffset || read32(source + candidate - 1) != sequence)
+                {
+                    i++;
+                    continue;
+                }
+                candidate--;
+
+                // extend the match as far as it goes, stopping where the block's literal tail starts
+                size_t matchEnd = i + minMatch;
+                size_t limit = size - lastLiterals;
+                while (matchEnd < limit && source[matchEnd] == source[candidate + (matchEnd - i)])
+                    matchEnd++;
+
+                size_t literalLength = i - anchor;
+                size_t matchLength = matchEnd - i - minMatch;
+                out.push_back(uint8_t((literalLength >= 15 ? 15 : literalLength) << 4 | (matchLength >= 15 ? 15 : matchLength)));
+                if (literalLength >= 15)
+                    writeLength(out, literalLength - 15);
+                out.insert(out.end(), source + anchor, source + i);
+
+                size_t offset = i - candidate;
+                out.push_back(uint8_t(offset));
+                out.push_back(uint8_t(offset >> 8));
+                if (matchLength >= 15)
+                    writeLength(out, matchLength - 15);
+
+                i = anchor = matchEnd;
+            }
+
+            // whatever is left goes out as literals
+            size_t literalLength = size - anchor;
+            out.push_back(uint8_t((literalLength >= 15 ? 15 : literalLength) << 4));
+            if (literalLength >= 15)
+                writeLength(out, literalLength - 15);
+            out.insert(out.end(), source + anchor, source + size);
+        }
+
+        // false on anything that would read or write out of bounds or doesn't fill destination exactly
+        inline bool decompress(const uint8_t *source, size_t sourceSize, uint8_t *destination, size_t destinationSize)
+        {
+            const uint8_t *in = source;
+            const uint8_t *inEnd = source + sourceSize;
+            uint8_t *out = destination;
+            uint8_t *outEnd = destination + destinationSize;
+
+            auto readLength = [&in, inEnd](size_t &length)
+            {
+                uint8_t byte;
+                do
+                {
+                    if (in >= inEnd)
+                        return false;
+                    byte = *in++;
+                    length += byte;
+                } while (byte == 255);
+                return true;
+            };
+
+            while (in < inEnd)
+            {
+                uint8_t token = *in++;
+
+                size_t literalLength = token >> 4;
+                if (literalLength == 15 && !readLength(literalLength))
+                    return false;
+                if (literalLength > size_t(inEnd - in) || literalLength > size_t(outEnd - out))
+                    return false;
+                if (literalLength)
+                    std::memcpy(out, in, literalLength);
+                in += literalLength;
+                out += literalLength;
+
+                // the last sequence has no match
+                if (in == inEnd)
+                    break;
+
+                if (inEnd - in < 2)
+                    return false;
+                size_t offset = size_t(in[0]) | size_t(in[1]) << 8;
+                in += 2;
+                if (offset == 0 || offset > size_t(out - destination))
+                    return false;
+
+                size_t matchLength = token & 15;
+                if (matchLength == 15 && !readLength(matchLength))
+                    return false;
+                matchLength += minMatch;
+                if (matchLength > size_t(outEnd - out))
+                    return false;
+
+                // matches may overlap what they're writing (offset < length repeats a pattern), so copy forwards
+                const uint8_t *match = out - offset;
+                if (offset >= matchLength)
+                    std::memcpy(out, match, matchLength);
+                else
+                {
+                    for (size_t b = 0; b < matchLength; b++)
+                        out[b] = match[b];
+                }
+                out += matchLength;
+            }
+            return out == outEnd;
+        }
+    } // namespace lz4
+} // namespace assets
+
+#endif // !LZ4_HPP
@@ -0,0 +1,111 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace assets
+{
+    // a whole file mapped read only. pages come in from disk (or the page cache) as they're first touched,
+    // nothing is read up front and nothing is copied into our own memory
+    class MappedFile
+    {
+    private:
+        const unsigned char *bytes = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#endif
+
+    public:
+        MappedFile() = default;
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile() { close(); }
+
+        bool open(const std::string &path)
+        {
+            close();
+#ifdef _WIN32
+            file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+            {
+                close();
+                return false;
+            }
+            length = size_t(fileSize.QuadPart);
+
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping)
+                bytes = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+            int descriptor = ::open(path.c_str(), O_RDONLY);
+            if (descriptor < 0)
+                return false;
+
+            struct stat status;
+            if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+            {
+                length = size_t(status.st_size);
+                void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+                if (mapped != MAP_FAILED)
+                    bytes = (const unsigned char *)mapped;
+            }
+            ::close(descriptor); // the mapping keeps the file alive
+#endif
+            if (!bytes)
+            {
+                std::cout << "couldn't map " << path << std::endl;
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close()
+        {
+#ifdef _WIN32
+            if (bytes)
+                UnmapViewOfFile(bytes);
+            if (mapping)
+                CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+            mapping = NULL;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (bytes)
+                munmap((void *)bytes, length);
+#endif
+            bytes = nullptr;
+            length = 0;
+        }
+
+        const unsigned char *data() const { return bytes; }
+        size_t size() const { return length; }
+        bool isOpen() const { return bytes != nullptr; }
+    };
+} // namespace assets
+
+#endif // !MAPPED_FILE_HPP
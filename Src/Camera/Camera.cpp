@@ -2,34 +2,85 @@
 
 using namespace gd;
 
-Camera::Camera(vec3 pos, vec3 rot, vec3 dir) : position(pos), rotation(rot), direction(dir)
+Camera::Camera(vec3 pos, vec3 rot, vec3 dir) : position(pos), rotation(rot), direction(dir), cachedRotation(rot)
 {
-    // initialize the right vector of the camera (it changes as the camera rotates)
-    cameraRight = glm::vec3(
-            sin(glm::radians(rotation.x) - 3.14f / 2.0f),
-            0.f,
-            cos(glm::radians(rotation.x) - 3.14f / 2.0f));
+    orientation.set(getYawPitch(rotation));
+    cameraRight = -orientation.getAxis(0);
+}
+
+quat Camera::getYawPitch(const vec3 &degrees)
+{
+    // yaw turns about world up, pitch about the camera's own x (positive looks up)
+    return angleAxis(glm::radians(degrees.x), vec3(0.f, 1.f, 0.f)) * angleAxis(glm::radians(-degrees.y), vec3(1.f, 0.f, 0.f));
+}
+
+void Camera::syncOrientation()
+{
+    if (rotation == cachedRotation)
+        return;
+
+    orientation.set(getYawPitch(rotation));
+    cachedRotation = rotation;
+    viewDirty = true;
+}
+
+void Camera::setOrientation(const quat &value)
+{
+    orientation.set(value);
+    cachedRotation = rotation;
+    viewDirty = true;
+}
+
+const vec3 &Camera::getForward()
+{
+    syncOrientation();
+    return orientation.getAxis(2);
 }
 
 mat4 Camera::generateViewMatrix()
 {
-    // calculate the camera's facing direction
-    direction = normalize(glm::vec3(
-        cos(glm::radians(rotation.y)) * sin(glm::radians(rotation.x)),
-        sin(glm::radians(rotation.y)),
-        cos(glm::radians(rotation.y)) * cos(glm::radians(rotation.x))));
-
-    // Recalculate the right vector relative to camera view
-    cameraRight = normalize(glm::vec3(
-        sin(glm::radians(rotation.x) - 3.14f / 2.0f),
-        0,
-        cos(glm::radians(rotation.x) - 3.14f / 2.0f)));
-
-    // world Up : perpendicular to look direction and world right
-    glm::vec3 cameraUp = normalize(glm::cross(cameraRight, direction));
-    // glm::vec3 cameraUp = glm::normalize(glm::vec3(0, 1.f, 0));
-    glm::vec3 cameraCenter = position + direction; // camera position combined with its face direction
-
-    // GLFW function for generating a view matrix with our variables
-    return glm::lookAt(position, cameraCenter, cameraUp);
+    // the facing direction, right and up vectors are the orientation's basis, no trig needed
+    direction = orientation.getAxis(2);
+    cameraRight = -orientation.getAxis(0);
+    vec3 cameraUp = orientation.getAxis(1);
+
+    // the matrix glm::lookAt would make: the camera axes as rows, then the position moved into them
+    mat4 viewMatrix(1.f);
+    for (int i = 0; i < 3; i++)
+    {
+        viewMatrix[i][0] = cameraRight[i];
+        viewMatrix[i][1] = cameraUp[i];
+        viewMatrix[i][2] = -direction[i];
+    }
+    viewMatrix[3][0] = -dot(cameraRight, position);
+    viewMatrix[3][1] = -dot(cameraUp, position);
+    viewMatrix[3][2] = dot(direction, position);
+    return viewMatrix;
+}
+
+void Camera::update()
+{
+    syncOrientation();
+    bool viewChanged = viewDirty || position != cachedPosition;
+    bool projChanged = projectionChanged() || projectionDirty;
+
+    if (!viewChanged && !projChanged)
+        return;
+
+    if (viewChanged)
+    {
+        view = generateViewMatrix();
+        cachedPosition = position;
+        viewDirty = false;
+    }
+
+    if (projChanged)
+    {
+        projection = generateProjectionMatrix();
+        projectionDirty = false;
+    }
+
+    viewProjection = projection * view;
+    inverseViewProjection = inverse(viewProjection);
+    frustum.extract(viewProjection);
 }
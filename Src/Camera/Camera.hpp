@@ -6,6 +6,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "../Core/Orientation.hpp"
+#include "Frustum.hpp"
+
 namespace gd
 {
     using namespace glm;
@@ -13,19 +16,60 @@ namespace gd
     {
     public:
         vec3 position = vec3(0.f, 0.f, -10.f);
-        vec3 rotation = vec3(0.f);
+        vec3 rotation = vec3(0.f); // yaw (x) and pitch (y) in degrees, or use setOrientation
         vec3 direction = vec3(0.f);
     
     protected:
         vec3 cameraRight;
 
+        // the camera's frame: x to its left, y up, z where it looks. the view matrix is built from this
+        Orientation orientation;
+
+    private: // matrices cached by update(), shared by everything that renders or culls this frame
+        mat4 view = mat4(1.f);
+        mat4 projection = mat4(1.f);
+        mat4 viewProjection = mat4(1.f);
+        mat4 inverseViewProjection = mat4(1.f);
+        Frustum frustum;
+
+        // inputs the cached view matrix was built from
+        vec3 cachedPosition;
+        vec3 cachedRotation; // the euler angles orientation was last made from
+        bool viewDirty = true;
+        bool projectionDirty = true;
+
     public:
         Camera(vec3 pos = vec3(0.f, 0.f, -10.f), vec3 rot = vec3(0.f), vec3 dir = vec3(0.f));
         mat4 generateViewMatrix();
 
+        // aim with a quaternion (e.g. from a scene graph node) instead of the euler angles, which are
+        // ignored until they change again
+        void setOrientation(const quat &value);
+
+        // where the camera looks, up to date with rotation even before update()
+        const vec3 &getForward();
+
         // pure virtual function for the perspective or orthographic projection matrix 
         virtual mat4 generateProjectionMatrix() = 0;
+
+        // rebuild the cached matrices and frustum, only if position, rotation or the projection changed
+        // call once per frame before anything reads them
+        void update();
+
+        const mat4 &getViewMatrix() const { return view; }
+        const mat4 &getProjectionMatrix() const { return projection; }
+        const mat4 &getViewProjectionMatrix() const { return viewProjection; }
+        const mat4 &getInverseViewProjectionMatrix() const { return inverseViewProjection; }
+        const Frustum &getFrustum() const { return frustum; }
+
+    protected:
+        // rebuild the orientation if the euler angles changed since it was made
+        void syncOrientation();
+        static quat getYawPitch(const vec3 &degrees);
+
+        // lets the child cameras report changes to their projection inputs (e.g. fov)
+        virtual bool projectionChanged() { return false; }
     };
 } // namespace gd
 
-#endif // !CAMERA_HPP
\ No newline at end of file
+#endif // !CAMERA_HPP
@@ -0,0 +1,66 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <glm/glm.hpp>
+
+namespace gd
+{
+    using namespace glm;
+    class Frustum
+    {
+    public:
+        // left, right, bottom, top, near, far as (normal, distance), normals point inwards
+        vec4 planes[6];
+
+    public:
+        Frustum() {}
+
+        // pull the six clip planes straight out of a combined projection * view matrix
+        void extract(const mat4 &viewProjection)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                for (int side = 0; side < 2; side++)
+                {
+                    float sign = side == 0 ? 1.f : -1.f;
+                    vec4 &plane = planes[i * 2 + side];
+                    plane.x = viewProjection[0][3] + sign * viewProjection[0][i];
+                    plane.y = viewProjection[1][3] + sign * viewProjection[1][i];
+                    plane.z = viewProjection[2][3] + sign * viewProjection[2][i];
+                    plane.w = viewProjection[3][3] + sign * viewProjection[3][i];
+
+                    plane /= length(vec3(plane));
+                }
+            }
+        }
+
+        // false only if the box is completely behind one of the planes
+        bool intersectsAABB(const vec3 &minBounds, const vec3 &maxBounds) const
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                // test the corner furthest along the plane normal
+                vec3 corner(
+                    planes[i].x >= 0.f ? maxBounds.x : minBounds.x,
+                    planes[i].y >= 0.f ? maxBounds.y : minBounds.y,
+                    planes[i].z >= 0.f ? maxBounds.z : minBounds.z);
+
+                if (dot(vec3(planes[i]), corner) + planes[i].w < 0.f)
+                    return false;
+            }
+            return true;
+        }
+
+        bool intersectsSphere(const vec3 &center, float radius) const
+        {
+            for (int i = 0; i < 6; i++)
+            {
+                if (dot(vec3(planes[i]), center) + planes[i].w < -radius)
+                    return false;
+            }
+            return true;
+        }
+    };
+} // namespace gd
+
+#endif // !FRUSTUM_HPP
@@ -14,10 +14,14 @@ namespace gd
     private:
         float height;
         float width;
+        float cachedFov = -1.f; // fov the cached projection was built with
 
     public:
         PerspectiveCamera(float fov, float height, float width, vec3 pos = vec3(0.f, 0.f, -10.f), vec3 rot = vec3(0.f), vec3 dir = vec3(0.f));
         mat4 generateProjectionMatrix();
+
+    protected:
+        bool projectionChanged();
     };
 
     PerspectiveCamera::PerspectiveCamera(float fov, float height, float width, vec3 pos, vec3 rot, vec3 dir) : fov(fov), height(height), width(width), Camera(pos, rot, dir) {}
@@ -26,6 +30,15 @@ namespace gd
     {
         return perspective(radians(fov), height / width, 0.1f, 300.f);
     }
+
+    bool PerspectiveCamera::projectionChanged()
+    {
+        if (fov == cachedFov)
+            return false;
+
+        cachedFov = fov;
+        return true;
+    }
     
 } // namespace gd
 
@@ -0,0 +1,155 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "../Profiling/Profiler.hpp"
+
+namespace gd
+{
+    // calls back (on its own thread) with the path of every watched file that gets written. inotify on linux,
+    // polling timestamps elsewhere. what to do about it is up to the owner: shaders read the source back in,
+    // models queue a reload
+    class FileWatcher
+    {
+    private:
+        std::set<std::string> files;
+        std::set<std::string> directories;
+        std::function<void(const std::string &)> onChange;
+        std::string threadName;
+
+        std::thread thread;
+        std::atomic<bool> running{false};
+
+    public:
+        ~FileWatcher() { stop(); }
+
+        // add every file before start(). it doesn't have to exist yet (e.g. a lod that hasn't been made)
+        void watch(const std::string &path)
+        {
+            files.insert(path);
+            directories.insert(std::filesystem::path(path).parent_path().string());
+        }
+
+        bool isWatching(const std::string &path) const { return files.count(path) != 0; }
+
+        void start(const std::string &name, std::function<void(const std::string &)> callback)
+        {
+            threadName = name;
+            onChange = std::move(callback);
+            running = true;
+            thread = std::thread([this]()
+                                 {
+                PROFILE_THREAD_NAME(threadName);
+                run(); });
+        }
+
+        void stop()
+        {
+            running = false;
+            if (thread.joinable())
+                thread.join();
+        }
+
+    private:
+#ifdef __linux__
+        void run()
+        {
+            int fd = inotify_init1(IN_NONBLOCK);
+            if (fd < 0)
+            {
+                std::cout << "inotify unavailable, falling back to polling timestamps for the " << threadName << std::endl;
+                runPolling();
+                return;
+            }
+
+            // watch directories rather than files so editors that save by renaming over the file still get noticed
+            std::vector<std::pair<int, std::string>> watches;
+            for (const std::string &directory : directories)
+            {
+                int wd = inotify_add_watch(fd, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                if (wd >= 0)
+                    watches.push_back({wd, directory});
+            }
+
+            alignas(inotify_event) char buffer[4096];
+            while (running)
+            {
+                // wake up now and then to check if we should stop
+                pollfd request = {fd, POLLIN, 0};
+                if (poll(&request, 1, 100) <= 0)
+                    continue;
+
+                ssize_t length = read(fd, buffer, sizeof(buffer));
+                for (ssize_t offset = 0; offset < length;)
+                {
+                    const inotify_event *event = (const inotify_event *)(buffer + offset);
+                    offset += sizeof(inotify_event) + event->len;
+
+                    if (!event->len)
+                        continue;
+
+                    for (const auto &watch : watches)
+                    {
+                        if (watch.first != event->wd)
+                            continue;
+
+                        std::string path = watch.second.empty() ? event->name : watch.second + "/" + event->name;
+                        if (files.count(path))
+                            onChange(path);
+                    }
+                }
+            }
+
+            close(fd);
+        }
+#else
+        void run()
+        {
+            runPolling();
+        }
+#endif
+
+        void runPolling()
+        {
+            std::vector<std::pair<std::string, std::filesystem::file_time_type>> stamps;
+            for (const std::string &path : files)
+            {
+                std::error_code error;
+                stamps.push_back({path, std::filesystem::last_write_time(path, error)});
+            }
+
+            while (running)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+                for (auto &stamp : stamps)
+                {
+                    std::error_code error;
+                    auto time = std::filesystem::last_write_time(stamp.first, error);
+                    if (!error && time != stamp.second)
+                    {
+                        stamp.second = time;
+                        onChange(stamp.first);
+                    }
+                }
+            }
+        }
+    };
+} // namespace gd
+
+#endif // !FILE_WATCHER_HPP
@@ -0,0 +1,89 @@
+#ifndef FIXED_TIMESTEP_HPP
+#define FIXED_TIMESTEP_HPP
+
+namespace gd
+{
+    // runs the simulation at a fixed rate no matter how fast we render,
+    // leftover time is handed to rendering as an interpolation factor
+    class FixedTimestep
+    {
+    public:
+        double step;      // seconds per simulation tick
+        int maxTicks = 8; // cap so a long hitch doesn't spiral into more and more catch-up ticks
+
+    private:
+        double previousTime = -1.0;
+        double accumulator = 0.0;
+
+    public:
+        FixedTimestep(double ticksPerSecond = 120.0) : step(1.0 / ticksPerSecond) {}
+
+        // feed the current time, returns how many ticks to simulate this frame
+        int advance(double currentTime)
+        {
+            if (previousTime < 0.0)
+                previousTime = currentTime;
+
+            accumulator += currentTime - previousTime;
+            previousTime = currentTime;
+
+            int ticks = int(accumulator / step);
+            if (ticks > maxTicks)
+            {
+                ticks = maxTicks;
+                accumulator = 0.0; // drop the time we can't catch up on
+            }
+            else
+                accumulator -= ticks * step;
+
+            return ticks;
+        }
+
+        float getDeltaTime() const { return float(step); }
+
+        // time that the most recent tick brought the simulation up to
+        double getSimulationTime() const { return previousTime - accumulator; }
+
+        double getTimeUntilNextTick() const { return step - accumulator; }
+
+        // how far we are between the last tick and the next one, 0 to 1
+        float getAlpha() const { return float(accumulator / step); }
+    };
+
+    // rolling averages so update and render cost can be read separately
+    class FrameStats
+    {
+    public:
+        double updateTime = 0.0; // seconds spent simulating
+        double renderTime = 0.0; // seconds spent building and submitting draws
+        int frames = 0;
+        int ticks = 0;
+        long long triangles = 0;           // drawn, at whatever lod was picked
+        long long fullDetailTriangles = 0; // what the same draws would have cost at full detail
+        long long allocations = 0;         // heap allocations the render thread made (with the allocation tracker)
+        long long steadyAllocations = 0;   // the ones in frames that shouldn't have any
+        long long occludedObjects = 0;     // in the frustum but hidden behind an occluder, never drawn
+        double occlusionTime = 0.0;        // seconds spent rasterizing occluders and testing boxes
+
+    public:
+        void reset()
+        {
+            updateTime = renderTime = 0.0;
+            frames = ticks = 0;
+            triangles = fullDetailTriangles = 0;
+            allocations = steadyAllocations = 0;
+            occludedObjects = 0;
+            occlusionTime = 0.0;
+        }
+
+        double averageUpdateMs() const { return ticks ? updateTime * 1000.0 / ticks : 0.0; }
+        double averageRenderMs() const { return frames ? renderTime * 1000.0 / frames : 0.0; }
+        long long averageTriangles() const { return frames ? triangles / frames : 0; }
+        long long averageFullDetailTriangles() const { return frames ? fullDetailTriangles / frames : 0; }
+        double averageAllocations() const { return frames ? double(allocations) / frames : 0.0; }
+        double averageOccluded() const { return frames ? double(occludedObjects) / frames : 0.0; }
+        double averageOcclusionMs() const { return frames ? occlusionTime * 1000.0 / frames : 0.0; }
+    };
+} // namespace gd
+
+#endif // !FIXED_TIMESTEP_HPP
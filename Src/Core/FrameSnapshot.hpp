@@ -0,0 +1,60 @@
+#ifndef FRAME_SNAPSHOT_HPP
+#define FRAME_SNAPSHOT_HPP
+
+#include <glm/glm.hpp>
+
+#include "Orientation.hpp"
+
+namespace gd
+{
+    using namespace glm;
+
+    // transform of one model at the last two simulation ticks
+    struct ModelTransform
+    {
+        vec3 previousPosition = vec3(0.f);
+        vec3 position = vec3(0.f);
+        quat previousOrientation = quat(1.f, 0.f, 0.f, 0.f);
+        quat orientation = quat(1.f, 0.f, 0.f, 0.f);
+        vec3 scale = vec3(1.f);
+
+        vec3 getPosition(float alpha) const { return mix(previousPosition, position, alpha); }
+        quat getOrientation(float alpha) const { return Orientation::blend(previousOrientation, orientation, alpha); }
+    };
+
+    // everything the render thread needs from one simulation tick.
+    // written whole by the simulation thread and never touched again once published
+    struct FrameSnapshot
+    {
+        static const int maxModels = 64;
+
+        ModelTransform models[maxModels];
+        int modelCount = 0;
+
+        // camera state
+        bool usePerspectiveCamera = true;
+        bool useThirdPersonCamera = true;
+        vec3 thirdPersonRotation = vec3(0.f);
+        float firstPersonPitch = 0.f;
+        float firstPersonFov = 60.f;
+        vec3 topCameraPosition = vec3(0.f);
+
+        // light state
+        float pointLightAmbientStr = 0.f;
+        float pointLightSpecStr = 0.f;
+
+        // time the current transforms belong to, and the tick length, for interpolation
+        double tickTime = 0.0;
+        double tickLength = 0.0;
+
+        // how far between the previous and current transforms the render time is, 0 to 1
+        float getAlpha(double renderTime) const
+        {
+            if (tickLength <= 0.0)
+                return 1.f;
+            return clamp(float((renderTime - tickTime) / tickLength), 0.f, 1.f);
+        }
+    };
+} // namespace gd
+
+#endif // !FRAME_SNAPSHOT_HPP
@@ -0,0 +1,164 @@
+#ifndef LINEAR_ARENA_HPP
+#define LINEAR_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace gd
+{
+    // bump allocator for data that all dies together (one model load, one frame). allocating is a pointer bump,
+    // nothing is freed on its own, and reset() drops everything at once. size it up front with reserve(); running
+    // out only costs another block, never a copy, so pointers handed out stay valid until the reset
+    class LinearArena
+    {
+    private:
+        struct Block
+        {
+            std::unique_ptr<unsigned char[]> bytes;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t current = 0; // block being bumped
+        size_t offset = 0;  // into it
+
+        size_t used = 0; // bytes handed out since the reset, padding included
+        size_t peak = 0;
+        size_t allocationCount = 0;
+        size_t blockAllocations = 0; // times we went to the heap
+
+    public:
+        LinearArena() = default;
+        explicit LinearArena(size_t capacity) { reserve(capacity); }
+        LinearArena(const LinearArena &) = delete;
+        LinearArena &operator=(const LinearArena &) = delete;
+
+        // the next bytes allocated (in any number of pieces) won't need another heap allocation
+        void reserve(size_t bytes)
+        {
+            if (!blocks.empty() && blocks[current].size - offset >= bytes)
+                return;
+
+            // blocks past the current one are free, after a rewind or reset they're used again
+            for (size_t i = current + 1; i < blocks.size(); i++)
+            {
+                if (blocks[i].size >= bytes)
+                {
+                    current = i;
+                    offset = 0;
+                    return;
+                }
+            }
+
+            addBlock(bytes);
+        }
+
+        void *allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+        {
+            size_t start = blocks.empty() ? 0 : align(offset, alignment);
+            if (blocks.empty() || start + size > blocks[current].size)
+            {
+                reserve(size + alignment);
+                start = align(offset, alignment);
+            }
+
+            used += start - offset + size;
+            peak = used > peak ? used : peak;
+            offset = start + size;
+            allocationCount++;
+            return blocks[current].bytes.get() + start;
+        }
+
+        // uninitialised room for count Ts. nothing gets destroyed, so only for trivially destructible types
+        template <typename T>
+        T *allocateArray(size_t count)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "arena memory is dropped, not destroyed");
+            return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        // everything allocated since the mark goes, for scratch that's done before the arena is
+        struct Marker
+        {
+            size_t block;
+            size_t offset;
+            size_t used;
+        };
+
+        Marker mark() const { return {current, offset, used}; }
+
+        void rewind(const Marker &marker)
+        {
+            current = marker.block;
+            offset = marker.offset;
+            used = marker.used;
+        }
+
+        // drops every allocation. the blocks stay for the next round, several get merged into one big enough for
+        // all of them so a steady workload settles on a single block
+        void reset()
+        {
+            if (blocks.size() > 1)
+            {
+                size_t total = 0;
+                for (const Block &block : blocks)
+                    total += block.size;
+                blocks.clear();
+                addBlock(total);
+            }
+            current = 0;
+            offset = 0;
+            used = 0;
+        }
+
+        // gives the memory back to the heap
+        void release()
+        {
+            blocks.clear();
+            current = 0;
+            offset = 0;
+            used = 0;
+        }
+
+        size_t getUsed() const { return used; }
+        size_t getPeak() const { return peak; }
+        size_t getAllocationCount() const { return allocationCount; }
+        size_t getBlockAllocations() const { return blockAllocations; }
+        size_t getBlockCount() const { return blocks.size(); }
+        size_t getCapacity() const
+        {
+            size_t total = 0;
+            for (const Block &block : blocks)
+                total += block.size;
+            return total;
+        }
+
+        // statistics count from here
+        void resetStats()
+        {
+            peak = used;
+            allocationCount = 0;
+            blockAllocations = 0;
+        }
+
+    private:
+        static size_t align(size_t value, size_t alignment)
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        void addBlock(size_t bytes)
+        {
+            // new[] hands out max_align_t alignment, bigger alignments pad inside the block
+            blocks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[bytes]), bytes});
+            blockAllocations++;
+            current = blocks.size() - 1;
+            offset = 0;
+        }
+    };
+} // namespace gd
+
+#endif // !LINEAR_ARENA_HPP
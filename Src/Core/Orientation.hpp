@@ -0,0 +1,59 @@
+#ifndef ORIENTATION_HPP
+#define ORIENTATION_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace gd
+{
+    using namespace glm;
+
+    // a rotation as a unit quaternion plus its basis (the columns of its matrix), so directions and transforms
+    // are read straight out of it with no trig. turning and blending are quaternion products and a normalise.
+    // euler angles (degrees, x then y then z, the order Model3D always used) still work for placing things
+    struct Orientation
+    {
+        quat value = quat(1.f, 0.f, 0.f, 0.f);
+        mat3 basis = mat3(1.f);
+
+        Orientation() = default;
+        explicit Orientation(const quat &rotation) { set(rotation); }
+
+        static Orientation fromEuler(const vec3 &degrees) { return Orientation(eulerToQuat(degrees)); }
+
+        static quat eulerToQuat(const vec3 &degrees)
+        {
+            return angleAxis(radians(degrees.x), vec3(1.f, 0.f, 0.f)) *
+                   angleAxis(radians(degrees.y), vec3(0.f, 1.f, 0.f)) *
+                   angleAxis(radians(degrees.z), vec3(0.f, 0.f, 1.f));
+        }
+
+        // normalised lerp along the shorter arc, plenty for the small steps between two ticks
+        static quat blend(const quat &from, const quat &to, float t)
+        {
+            quat target = dot(from, to) < 0.f ? -to : to;
+            return normalize(from * (1.f - t) + target * t);
+        }
+
+        void set(const quat &rotation)
+        {
+            value = normalize(rotation);
+            basis = mat3_cast(value);
+        }
+
+        void setEuler(const vec3 &degrees) { set(eulerToQuat(degrees)); }
+
+        // turn by a step in our own frame, e.g. one precomputed per tick
+        void rotateLocal(const quat &step) { set(value * step); }
+
+        const vec3 &getAxis(int axis) const { return basis[axis]; }
+
+        // translate * scale * rotate, the same matrix the euler path built, without composing rotations
+        mat4 toTransform(const vec3 &position, const vec3 &scale) const
+        {
+            return mat4(vec4(basis[0] * scale, 0.f), vec4(basis[1] * scale, 0.f), vec4(basis[2] * scale, 0.f), vec4(position, 1.f));
+        }
+    };
+} // namespace gd
+
+#endif // !ORIENTATION_HPP
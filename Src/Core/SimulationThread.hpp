@@ -0,0 +1,95 @@
+#ifndef SIMULATION_THREAD_HPP
+#define SIMULATION_THREAD_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+#include "../Profiling/Profiler.hpp"
+#include "FixedTimestep.hpp"
+
+namespace gd
+{
+    // drives a fixed timestep simulation, either on its own thread or pumped from the main loop
+    class SimulationThread
+    {
+    public:
+        using TickFunction = std::function<void(float deltaTime)>;
+        using PublishFunction = std::function<void(double tickTime, double tickLength)>;
+
+    private:
+        FixedTimestep timestep;
+        TickFunction tick;
+        PublishFunction publish;
+
+        std::thread thread;
+        std::atomic<bool> running{false};
+
+        // update cost, collected here and drained by whoever reports stats
+        std::atomic<long long> updateNanoseconds{0};
+        std::atomic<int> tickCount{0};
+
+    public:
+        SimulationThread(double ticksPerSecond, TickFunction tick, PublishFunction publish) : timestep(ticksPerSecond), tick(tick), publish(publish) {}
+        ~SimulationThread() { stop(); }
+
+        void start()
+        {
+            running = true;
+            thread = std::thread([this]()
+                                 {
+                PROFILE_THREAD_NAME("Simulation");
+
+                while (running)
+                {
+                    step(glfwGetTime());
+
+                    // nap until the next tick is due
+                    std::this_thread::sleep_for(std::chrono::duration<double>(timestep.getTimeUntilNextTick()));
+                } });
+        }
+
+        void stop()
+        {
+            running = false;
+            if (thread.joinable())
+                thread.join();
+        }
+
+        // run every tick that is due by currentTime and publish the result, returns the tick count.
+        // call this from the main loop directly when running single threaded
+        int step(double currentTime)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            int ticks = timestep.advance(currentTime);
+            for (int i = 0; i < ticks; i++)
+            {
+                PROFILE_SCOPE("Simulation Tick");
+                tick(timestep.getDeltaTime());
+            }
+
+            if (ticks > 0)
+            {
+                PROFILE_SCOPE("Publish Snapshot");
+                publish(timestep.getSimulationTime(), timestep.step);
+            }
+
+            updateNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+            tickCount += ticks;
+            return ticks;
+        }
+
+        // read and reset the update cost since the last call
+        void takeStats(double &updateSeconds, int &ticks)
+        {
+            updateSeconds = updateNanoseconds.exchange(0) * 1e-9;
+            ticks = tickCount.exchange(0);
+        }
+    };
+} // namespace gd
+
+#endif // !SIMULATION_THREAD_HPP
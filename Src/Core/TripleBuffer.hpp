@@ -0,0 +1,48 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+namespace gd
+{
+    // lock free single producer / single consumer hand off of whole frames.
+    // the writer always has a buffer to fill and the reader always has the newest complete one,
+    // neither side ever waits on the other
+    template <typename T>
+    class TripleBuffer
+    {
+    private:
+        static const int freshBit = 4; // set on the shared index when it holds an unread frame
+
+        T buffers[3];
+        int writeIndex = 0;
+        int readIndex = 1;
+        std::atomic<int> sharedIndex{2};
+
+    public:
+        // producer side: fill this, then publish()
+        T &getWriteBuffer() { return buffers[writeIndex]; }
+
+        void publish()
+        {
+            // hand our filled buffer over and take whatever was in the middle
+            int previous = sharedIndex.exchange(writeIndex | freshBit, std::memory_order_acq_rel);
+            writeIndex = previous & ~freshBit;
+        }
+
+        // consumer side: grab the latest published frame if there is one, true if it changed
+        bool consume()
+        {
+            if (!(sharedIndex.load(std::memory_order_relaxed) & freshBit))
+                return false;
+
+            int previous = sharedIndex.exchange(readIndex, std::memory_order_acq_rel);
+            readIndex = previous & ~freshBit;
+            return true;
+        }
+
+        const T &getReadBuffer() const { return buffers[readIndex]; }
+    };
+} // namespace gd
+
+#endif // !TRIPLE_BUFFER_HPP
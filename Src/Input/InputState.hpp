@@ -0,0 +1,101 @@
+#ifndef INPUT_STATE_HPP
+#define INPUT_STATE_HPP
+
+#include <mutex>
+
+#include <GLFW/glfw3.h>
+
+namespace gd
+{
+    // snapshot of the player's input for one simulation tick
+    struct InputState
+    {
+        // held movement keys
+        bool forward = false;  // W
+        bool backward = false; // S
+        bool left = false;     // A
+        bool right = false;    // D
+        bool zoomIn = false;   // E
+        bool zoomOut = false;  // Q
+
+        // presses since the last tick
+        int thirdPersonToggles = 0; // 1
+        int topCameraToggles = 0;   // 2
+        int lightCycles = 0;        // F
+
+        // accumulated mouse offset from the center of the window
+        float mouseX = 0.f;
+        float mouseY = 0.f;
+
+        static InputState poll(GLFWwindow *window)
+        {
+            InputState state;
+            state.forward = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+            state.backward = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+            state.left = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+            state.right = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+            state.zoomIn = glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS;
+            state.zoomOut = glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS;
+            return state;
+        }
+    };
+
+    // GLFW only lets the main thread read input, so it fills this and the simulation drains it every tick
+    class InputQueue
+    {
+    private:
+        std::mutex mutex;
+        InputState pending;
+
+    public:
+        // main thread: latest held keys, polled once per frame
+        void setHeldKeys(const InputState &held)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.forward = held.forward;
+            pending.backward = held.backward;
+            pending.left = held.left;
+            pending.right = held.right;
+            pending.zoomIn = held.zoomIn;
+            pending.zoomOut = held.zoomOut;
+        }
+
+        // main thread: key presses from the callbacks
+        void addThirdPersonToggle()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.thirdPersonToggles++;
+        }
+
+        void addTopCameraToggle()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.topCameraToggles++;
+        }
+
+        void addLightCycle()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.lightCycles++;
+        }
+
+        void addMouse(float x, float y)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.mouseX += x;
+            pending.mouseY += y;
+        }
+
+        // simulation thread: everything since the last tick, held keys stay held
+        InputState take()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            InputState state = pending;
+            pending.thirdPersonToggles = pending.topCameraToggles = pending.lightCycles = 0;
+            pending.mouseX = pending.mouseY = 0.f;
+            return state;
+        }
+    };
+} // namespace gd
+
+#endif // !INPUT_STATE_HPP
@@ -0,0 +1,422 @@
+#ifndef JOB_SYSTEM_HPP
+#define JOB_SYSTEM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../Profiling/Profiler.hpp"
+#include "WorkStealingQueue.hpp"
+
+namespace jobs
+{
+    struct Job;
+
+    // counts jobs still in flight, waiting on it blocks until every job tied to it has finished
+    class Counter
+    {
+    public:
+        std::atomic<int> value{0};
+
+    private:
+        friend class JobSystem;
+
+        // guards parked. the job that brings the value to zero holds it while it takes the parked jobs, so
+        // isDone() can't say yes while that job still touches the counter
+        mutable std::atomic<bool> locked{false};
+        Job *parked = nullptr; // jobs waiting for this to hit zero, linked through Job::nextParked
+
+        void lock() const
+        {
+            while (locked.exchange(true, std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+
+        void unlock() const { locked.store(false, std::memory_order_release); }
+
+    public:
+        bool isDone() const
+        {
+            if (value.load(std::memory_order_acquire) != 0)
+                return false;
+
+            // whoever saw zero may destroy the counter right after this
+            lock();
+            unlock();
+            return true;
+        }
+    };
+
+    // one unit of work. small trivially copyable callables are stored inline so submitting never allocates
+    struct alignas(64) Job
+    {
+        void (*invoke)(Job &job);
+        Counter *counter; // decremented when this job finishes
+        union
+        {
+            Counter *dependency; // job doesn't start until this hits zero
+            Job *nextParked;     // once it's parked on that, the next job waiting on the same counter
+        };
+        std::atomic<bool> busy{false}; // slot is queued or running, don't hand it out again
+        alignas(8) unsigned char payload[32];
+    };
+
+    // work stealing scheduler: every thread that submits gets its own deque, idle workers steal from the others.
+    // constructed with 0 workers it runs everything inline, in submission order, for deterministic debugging
+    class JobSystem
+    {
+    private:
+        static const int maxThreads = 64;
+        static const int queueCapacity = 4096;
+        static const int poolCapacity = queueCapacity * 2;
+
+        // per thread deque plus the ring of job slots it hands out
+        struct ThreadData
+        {
+            WorkStealingQueue<Job, queueCapacity> queue;
+            Job pool[poolCapacity];
+            uint32_t poolIndex = 0;
+            uint32_t randomState = 0;
+            std::thread::id owner;
+        };
+
+        std::unique_ptr<ThreadData> threads[maxThreads];
+        std::atomic<int> threadCount{0};
+        std::mutex registerMutex;
+
+        std::vector<std::thread> workers;
+        std::atomic<bool> running{true};
+        std::atomic<int> sleepingWorkers{0};
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+
+        int workerCount;
+        uint64_t id; // tells thread_local registrations of old job systems apart from ours
+
+    public:
+        explicit JobSystem(int workerCount = defaultWorkerCount()) : workerCount(workerCount)
+        {
+            static std::atomic<uint64_t> nextId{1};
+            id = nextId++;
+
+            this->workerCount = std::min(this->workerCount, maxThreads - 8); // leave room for the threads that submit
+            for (int i = 0; i < this->workerCount; i++)
+                workers.emplace_back([this]()
+                                     { workerLoop(); });
+        }
+
+        ~JobSystem()
+        {
+            running = false;
+            {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                wakeUp.notify_all();
+            }
+            for (std::thread &worker : workers)
+                worker.join();
+        }
+
+        // one worker per core, minus the thread that submits
+        static int defaultWorkerCount()
+        {
+            int cores = int(std::thread::hardware_concurrency());
+            return cores > 1 ? cores - 1 : 0;
+        }
+
+        int getWorkerCount() const { return workerCount; }
+        bool isSingleThreaded() const { return workerCount == 0; }
+
+        // queue a callable, it must be trivially copyable and fit in Job::payload (capture big things by pointer)
+        template <typename Function>
+        void run(const Function &function, Counter *counter = nullptr, Counter *dependency = nullptr)
+        {
+            static_assert(sizeof(Function) <= sizeof(Job::payload), "job captures too much, capture by pointer instead");
+            static_assert(std::is_trivially_copyable<Function>::value, "job callables must be trivially copyable");
+
+            if (isSingleThreaded())
+            {
+                // everything submitted earlier has already run, so dependencies are always met
+                function();
+                return;
+            }
+
+            Job *job = allocateJob();
+            new (job->payload) Function(function);
+            job->invoke = [](Job &self)
+            { (*reinterpret_cast<Function *>(self.payload))(); };
+            job->counter = counter;
+            job->dependency = dependency;
+
+            if (counter)
+                counter->value.fetch_add(1, std::memory_order_relaxed);
+
+            submit(job);
+        }
+
+        // help out with queued work until every job on the counter has finished
+        void wait(Counter &counter)
+        {
+            while (!counter.isDone())
+            {
+                if (!runOne())
+                    std::this_thread::yield();
+            }
+        }
+
+        // calls function(first, last) over [begin, end) in chunks of at most grainSize, returns when all are done.
+        // the range is split in halves so thieves take big pieces and the submitting thread keeps the small ones
+        template <typename Function>
+        void parallelFor(size_t begin, size_t end, size_t grainSize, const Function &function)
+        {
+            if (end <= begin)
+                return;
+            grainSize = std::max<size_t>(grainSize, 1);
+
+            if (isSingleThreaded())
+            {
+                for (size_t first = begin; first < end; first += grainSize)
+                    function(first, std::min(first + grainSize, end));
+                return;
+            }
+
+            ParallelForTask<Function> task(this, &function, grainSize);
+            task.split(begin, end);
+            wait(task.counter);
+        }
+
+    private:
+        template <typename Function>
+        struct ParallelForTask
+        {
+            JobSystem *system;
+            const Function *function;
+            size_t grainSize;
+            Counter counter;
+
+            ParallelForTask(JobSystem *system, const Function *function, size_t grainSize)
+                : system(system), function(function), grainSize(grainSize) {}
+
+            void split(size_t first, size_t last)
+            {
+                // give away the upper half until what's left is one chunk
+                while (last - first > grainSize)
+                {
+                    size_t middle = first + (last - first) / 2;
+                    ParallelForTask *self = this;
+                    system->run([self, middle, last]()
+                                { self->split(middle, last); },
+                                &counter);
+                    last = middle;
+                }
+                (*function)(first, last);
+            }
+        };
+
+        ThreadData &getThreadData()
+        {
+            // a thread can submit to several job systems, it remembers its slot in the last few it used
+            struct Registration
+            {
+                uint64_t owner = 0;
+                ThreadData *data = nullptr;
+            };
+            static const int rememberedSystems = 4;
+            thread_local Registration registrations[rememberedSystems];
+            thread_local int nextRegistration = 0;
+
+            for (const Registration &registration : registrations)
+            {
+                if (registration.owner == id)
+                    return *registration.data;
+            }
+
+            ThreadData *data = registerThread();
+            registrations[nextRegistration++ % rememberedSystems] = {id, data};
+            return *data;
+        }
+
+        // the slot this thread had in here before (it only fell out of the thread's few remembered systems), or a
+        // new one
+        ThreadData *registerThread()
+        {
+            std::lock_guard<std::mutex> lock(registerMutex);
+            std::thread::id self = std::this_thread::get_id();
+            int index = threadCount.load(std::memory_order_relaxed);
+            for (int i = 0; i < index; i++)
+            {
+                if (threads[i]->owner == self)
+                    return threads[i].get();
+            }
+
+            if (index == maxThreads)
+            {
+                std::cout << "JobSystem: more than " << maxThreads << " threads submitting jobs" << std::endl;
+                std::abort();
+            }
+
+            threads[index].reset(new ThreadData());
+            threads[index]->randomState = uint32_t(index * 2654435761u + 1u);
+            threads[index]->owner = self;
+            threadCount.store(index + 1, std::memory_order_release);
+            return threads[index].get();
+        }
+
+        Job *allocateJob()
+        {
+            // the pool is twice the deque size, so a free slot is rarely far away
+            ThreadData &data = getThreadData();
+            while (true)
+            {
+                for (int i = 0; i < poolCapacity; i++)
+                {
+                    Job *job = &data.pool[data.poolIndex++ & (poolCapacity - 1)];
+                    if (!job->busy.load(std::memory_order_acquire))
+                    {
+                        job->busy.store(true, std::memory_order_relaxed);
+                        return job;
+                    }
+                }
+
+                // every slot is queued, parked or running, help them along until one frees up
+                if (!runOne())
+                    std::this_thread::yield();
+            }
+        }
+
+        void submit(Job *job)
+        {
+            if (job->dependency && park(job))
+                return;
+            enqueue(job);
+        }
+
+        // true when the job's dependency isn't done yet, it then sits on the counter until that hits zero
+        bool park(Job *job)
+        {
+            Counter &dependency = *job->dependency;
+            dependency.lock();
+            bool waiting = dependency.value.load(std::memory_order_acquire) != 0;
+            if (waiting)
+            {
+                job->nextParked = dependency.parked;
+                dependency.parked = job;
+            }
+            dependency.unlock();
+            return waiting;
+        }
+
+        // a job that's ready to run
+        void enqueue(Job *job)
+        {
+            // if our deque is full there's plenty queued already, just do it now
+            if (!getThreadData().queue.push(job))
+            {
+                finish(job);
+                return;
+            }
+
+            if (sleepingWorkers.load(std::memory_order_relaxed) > 0)
+                wakeUp.notify_one();
+        }
+
+        // run one queued job from our own deque or someone else's, false if there was nothing to do. queued jobs
+        // are always ready, the ones still waiting on a dependency are parked on it instead
+        bool runOne()
+        {
+            ThreadData &self = getThreadData();
+            Job *job = self.queue.pop();
+
+            if (!job)
+            {
+                int count = threadCount.load(std::memory_order_acquire);
+
+                // xorshift so thieves don't all hammer the same victim
+                self.randomState ^= self.randomState << 13;
+                self.randomState ^= self.randomState >> 17;
+                self.randomState ^= self.randomState << 5;
+                int start = int(self.randomState % uint32_t(count));
+
+                for (int i = 0; i < count && !job; i++)
+                {
+                    ThreadData *victim = threads[(start + i) % count].get();
+                    if (victim != &self)
+                        job = victim->queue.steal();
+                }
+            }
+
+            if (!job)
+                return false;
+
+            finish(job);
+            return true;
+        }
+
+        void finish(Job *job)
+        {
+            job->invoke(*job);
+
+            Counter *counter = job->counter;
+            job->busy.store(false, std::memory_order_release);
+            if (!counter)
+                return;
+
+            // the counter can be gone as soon as it's unlocked at zero, so the parked jobs are taken before that
+            Job *ready = nullptr;
+            counter->lock();
+            if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                ready = counter->parked;
+                counter->parked = nullptr;
+            }
+            counter->unlock();
+
+            while (ready)
+            {
+                Job *next = ready->nextParked;
+                enqueue(ready);
+                ready = next;
+            }
+        }
+
+        void workerLoop()
+        {
+            PROFILE_THREAD_NAME("Job Worker");
+
+            int idleSpins = 0;
+            while (running)
+            {
+                if (runOne())
+                {
+                    idleSpins = 0;
+                    continue;
+                }
+
+                // spin briefly since more work usually shows up right away, then nap
+                if (++idleSpins < 64)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                sleepingWorkers++;
+                wakeUp.wait_for(lock, std::chrono::milliseconds(1));
+                sleepingWorkers--;
+                idleSpins = 0;
+            }
+        }
+    };
+} // namespace jobs
+
+#endif // !JOB_SYSTEM_HPP
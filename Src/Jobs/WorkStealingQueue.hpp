@@ -0,0 +1,93 @@
+#ifndef WORK_STEALING_QUEUE_HPP
+#define WORK_STEALING_QUEUE_HPP
+
+#include <atomic>
+#include <cstdint>
+
+namespace jobs
+{
+    // fixed size Chase-Lev deque. the owning thread pushes and pops at the bottom (newest first, cache warm),
+    // every other thread steals from the top (oldest first, usually the biggest chunks of work)
+    template <typename T, int Capacity>
+    class WorkStealingQueue
+    {
+    private:
+        static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+        static const int mask = Capacity - 1;
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        std::atomic<T *> items[Capacity];
+
+    public:
+        WorkStealingQueue()
+        {
+            for (int i = 0; i < Capacity; i++)
+                items[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        // owner only, false if full
+        bool push(T *item)
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            if (b - t >= Capacity)
+                return false;
+
+            items[b & mask].store(item, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        // owner only
+        T *pop()
+        {
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b)
+            {
+                // already empty
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T *item = items[b & mask].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // last item, race the thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        // any thread
+        T *steal()
+        {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+
+            if (t >= b)
+                return nullptr;
+
+            T *item = items[t & mask].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr; // someone else got it first
+
+            return item;
+        }
+
+        bool empty() const
+        {
+            return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+        }
+    };
+} // namespace jobs
+
+#endif // !WORK_STEALING_QUEUE_HPP
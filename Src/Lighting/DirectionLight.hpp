@@ -11,14 +11,18 @@ namespace gd
     public:
         vec3 direction;
 
+    private:
+        std::string directionName;
+
     public:
         DirectionLight(std::string shaderName, vec3 direction, float ambientStr, float specStr, float specPhong, vec3 lightColor, vec3 ambientColor) : 
-        direction(direction), Light(shaderName, ambientStr, specStr, specPhong, lightColor, ambientColor) {}
+        direction(direction), Light(shaderName, ambientStr, specStr, specPhong, lightColor, ambientColor),
+        directionName(shaderName + ".direction") {}
 
         // sending uniform for direction of the light
-        void applyExtraUniforms(GLuint &shaderProgram)
+        void applyExtraUniforms(shader::Shader &shader)
         {
-            unsigned int directionLoc = glGetUniformLocation(shaderProgram, (shaderName + ".direction").c_str());
+            unsigned int directionLoc = shader.getUniformLocation(directionName);
             glUniform3fv(directionLoc, 1, value_ptr(direction));
         }
     };
@@ -8,6 +8,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "../Shaders/Shader.hpp"
+
 namespace gd
 {
     using namespace glm;
@@ -27,6 +29,14 @@ namespace gd
         vec3 lightColor;
         vec3 ambientColor;
 
+    protected:
+        // "shaderName.field" for every uniform, built once so the per frame uniforms don't make strings
+        std::string ambientStrName;
+        std::string specStrName;
+        std::string specPhongName;
+        std::string lightColorName;
+        std::string ambientColorName;
+
     public: // shader name: name of light struct in shader
         Light(std::string shaderName, float ambientStr, float specStr, float specPhong = 32, vec3 lightColor = vec3(1.f), vec3 ambientColor = vec3(1.f)) : 
             shaderName(shaderName),
@@ -34,30 +44,35 @@ namespace gd
             specStr(specStr), 
             specPhong(specPhong), 
             lightColor(lightColor), 
-            ambientColor(ambientColor) {};
+            ambientColor(ambientColor),
+            ambientStrName(shaderName + ".ambientStr"),
+            specStrName(shaderName + ".specStr"),
+            specPhongName(shaderName + ".specPhong"),
+            lightColorName(shaderName + ".lightColor"),
+            ambientColorName(shaderName + ".ambientColor") {};
 
-        // apply uniforms in shaderProgram
-        void applyUniforms(GLuint &shaderProgram)
+        // apply uniforms in the shader's program (already in use), locations come from its cache
+        void applyUniforms(shader::Shader &shader)
         {            
-            unsigned int ambientStrLoc = glGetUniformLocation(shaderProgram, (shaderName + ".ambientStr").c_str());
+            unsigned int ambientStrLoc = shader.getUniformLocation(ambientStrName);
             glUniform1f(ambientStrLoc, ambientStr);
 
-            unsigned int specStrLoc = glGetUniformLocation(shaderProgram, (shaderName + ".specStr").c_str());
+            unsigned int specStrLoc = shader.getUniformLocation(specStrName);
             glUniform1f(specStrLoc, specStr);
             
-            unsigned int specPhongLoc = glGetUniformLocation(shaderProgram, (shaderName + ".specPhong").c_str());
+            unsigned int specPhongLoc = shader.getUniformLocation(specPhongName);
             glUniform1f(specPhongLoc, specPhong);
 
-            unsigned int lightColorLoc = glGetUniformLocation(shaderProgram, (shaderName + ".lightColor").c_str());
+            unsigned int lightColorLoc = shader.getUniformLocation(lightColorName);
             glUniform3fv(lightColorLoc, 1, value_ptr(lightColor));
 
-            unsigned int ambientColorLoc = glGetUniformLocation(shaderProgram, (shaderName + ".ambientColor").c_str());
+            unsigned int ambientColorLoc = shader.getUniformLocation(ambientColorName);
             glUniform3fv(ambientColorLoc, 1, value_ptr(ambientColor));
         }
 
         // pure virtual for the child light classes to apply special/extra uniforms
         // e.g directional light direction, point light position
-        virtual void applyExtraUniforms(GLuint &shaderProgram) = 0;
+        virtual void applyExtraUniforms(shader::Shader &shader) = 0;
     };
 } // namespace gd
 
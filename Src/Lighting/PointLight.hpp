@@ -13,23 +13,31 @@ namespace gd
         float linear = 0.07f;
         float quadratic = 0.017f;
 
+    private:
+        std::string positionName;
+        std::string constantName;
+        std::string linearName;
+        std::string quadraticName;
+
     public:
         PointLight(std::string shaderName, vec3 position, float ambientStr, float specStr, float specPhong, vec3 lightColor, vec3 ambientColor) : 
-        position(position), Light(shaderName, ambientStr, specStr, specPhong, lightColor, ambientColor) {}
+        position(position), Light(shaderName, ambientStr, specStr, specPhong, lightColor, ambientColor),
+        positionName(shaderName + ".position"), constantName(shaderName + ".constant"), linearName(shaderName + ".linear"),
+        quadraticName(shaderName + ".quadratic") {}
 
         // sending uniforms of point light specific info
-        void applyExtraUniforms(GLuint &shaderProgram)
+        void applyExtraUniforms(shader::Shader &shader)
         {
-            unsigned int positionLoc = glGetUniformLocation(shaderProgram, (shaderName + ".position").c_str());
+            unsigned int positionLoc = shader.getUniformLocation(positionName);
             glUniform3fv(positionLoc, 1, value_ptr(position));
 
-            unsigned int constantLoc = glGetUniformLocation(shaderProgram, (shaderName + ".constant").c_str());
+            unsigned int constantLoc = shader.getUniformLocation(constantName);
             glUniform1f(constantLoc, constant);
 
-            unsigned int linearLoc = glGetUniformLocation(shaderProgram, (shaderName + ".linear").c_str());
+            unsigned int linearLoc = shader.getUniformLocation(linearName);
             glUniform1f(linearLoc, linear);
             
-            unsigned int quadraticLoc = glGetUniformLocation(shaderProgram, (shaderName + ".quadratic").c_str());
+            unsigned int quadraticLoc = shader.getUniformLocation(quadraticName);
             glUniform1f(quadraticLoc, quadratic);
         }
     };    
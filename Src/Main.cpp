@@ -14,10 +14,29 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "Extensions/tiny_obj_loader.h"
 
+#define ALLOCATION_TRACKER_IMPLEMENTATION
+#include "Profiling/AllocationTracker.hpp"
+
+#include <cassert>
 #include <iostream>
+#include <memory>
 #include <string>
 
 #include "Shaders/Shader.hpp"
+#include "Shaders/ShaderWatcher.hpp"
+
+#include "Core/FixedTimestep.hpp"
+#include "Core/FrameSnapshot.hpp"
+#include "Core/LinearArena.hpp"
+#include "Core/SimulationThread.hpp"
+#include "Core/TripleBuffer.hpp"
+#include "Input/InputState.hpp"
+#include "Jobs/JobSystem.hpp"
+#include "Profiling/GpuTimer.hpp"
+#include "Profiling/Profiler.hpp"
+#include "Rendering/DynamicResolution.hpp"
+#include "Rendering/OcclusionCuller.hpp"
+#include "Rendering/PostProcess.hpp"
 
 #include "Camera/Camera.cpp"
 #include "Camera/OrthoCamera.hpp"
@@ -27,9 +46,19 @@
 #include "Lighting/DirectionLight.hpp"
 #include "Lighting/PointLight.hpp"
 
+#include "Models/ModelSource.cpp"
 #include "Models/Model3D.cpp"
+#include "Models/ModelReloader.hpp"
 #include "Models/Player.cpp"
 
+#include "Physics/CollisionWorld.hpp"
+#include "Scene/SceneFile.hpp"
+#include "Scene/SceneGraph.hpp"
+#include "Scene/TransformStore.hpp"
+#include "Spatial/AabbTree.hpp"
+#include "Terrain/HeightField.hpp"
+#include "Terrain/Terrain.hpp"
+
 using namespace glm;
 using namespace gd;
 using namespace shader;
@@ -38,9 +67,39 @@ using namespace shader;
 static float height = 600.f;
 static float width = 600.f;
 
-// increment to rotate/translate the models by
-static float positionIncrement = 1.f;
-static float rotationIncrement = 5.f;
+// rates to rotate/translate the models by, per second of simulation
+static float positionSpeed = 30.f;
+static float rotationSpeed = 150.f;
+static float zoomSpeed = 150.f;
+
+// simulation runs at a fixed rate, rendering runs as fast as vsync allows
+static const double simulationRate = 120.0;
+static bool useVsync = true;
+static bool useSimulationThread = true; // false pumps the simulation from the render loop instead
+static bool useJobThreads = true;       // false runs every job inline, in submission order, for deterministic debugging
+static bool useShaderHotReload = true;  // recompile shaders when their files are saved
+static bool useModelHotReload = true;   // reload meshes and textures when their files are saved
+static bool assertNoFrameAllocations = true; // debug builds stop on a heap allocation in a steady state frame
+static const int steadyAfterFrames = 120;    // frames without setup changes (camera, size, variants) before that applies
+static float renderScale = 1.f;         // internal resolution relative to the window, lower it when fill rate bound
+static bool useDynamicResolution = true; // pick renderScale each frame from measured gpu time instead
+static bool useOcclusionCulling = true;  // skip models hidden behind big ones, tested on the cpu before drawing
+static const double gpuBudgetMs = 14.0;  // what dynamic resolution aims for
+
+static const char *windowTitle = "Marcus Leocario / Joachim Arguelles";
+
+// what gets loaded when no scene is given on the command line
+static const char *defaultScenePath = "Scenes/tanks.scene";
+
+// made by Tools/Pack.cpp, used instead of the loose asset files when it's there
+static const char *archivePath = "Assets.pak";
+
+// P captures this many frames to trace.json, captureStartup also grabs model loading
+static const int captureFrames = 120;
+static bool captureStartup = false;
+
+// shared worker pool for anything that can be split up (loading, culling...)
+static jobs::JobSystem *jobSystem;
 
 // global pointers for all cameras
 static PerspectiveCamera *thirdPersonCamera;
@@ -50,180 +109,222 @@ static OrthoCamera *topCamera;
 // in a perfect world i would have created a model manager
 static Player *player;
 // static Model3D *lightModel;
-static Model3D *plane;
 
 // global pointers for both lights
 static PointLight *pointLight;
 static DirectionLight *directionLight;
 
-// if we're using the perspective or ortho camera
-static bool usePerspectiveCamera = true;
-static bool useThirdPersonCamera = true; // if using first or third person
-
-// update the light model's position 
-// (where the main model is) and then setting the point light's position to it as well
-void updateLightPosition()
+// everything gameplay owns. only the simulation thread touches this,
+// the render thread sees it through published snapshots
+struct SimulationState
 {
-    // lightModel->rotation = glm::radians(lightModel->rotation);
-    // lightModel->position = toMat4(quat(lightModel->rotation)) * vec4(lightModel->position, 1.f);
+    // if we're using the perspective or ortho camera
+    bool usePerspectiveCamera = true;
+    bool useThirdPersonCamera = true; // if using first or third person
+
+    vec3 thirdPersonRotation = vec3(0.f);
+    float firstPersonPitch = 0.f;
+    float firstPersonFov = 60.f;
+    vec3 topCameraPosition = vec3(0.f);
+
+    float pointLightAmbientStr = 0.f;
+    float pointLightSpecStr = 0.f;
+};
+static SimulationState simState;
+
+// main thread collects input here for the simulation
+static InputQueue inputQueue;
+
+// finished simulation frames going to the render thread
+static TripleBuffer<FrameSnapshot> snapshots;
+
+// models the simulation moves (just the player), in snapshot order. their transform fields belong to the simulation thread
+static std::vector<Model3D *> sceneModels;
 
-    glm::vec3 position = player->position;
+// ground heights for gameplay, the simulation thread's own copy
+static terrain::HeightField *simulationGround;
+static const float playerGroundOffset = 0.7f; // the tank's origin sits this far above the ground
 
-    pointLight->position = position;
+// one body per scene object in the same order, the player's (0) is the only one that moves
+static physics::CollisionWorld *collisionWorld;
+
+// keep the tank on the terrain
+void followGround()
+{
+    player->position.y = simulationGround->getHeight(player->position.x, player->position.z) + playerGroundOffset;
 }
 
-static void Key_Callback(
-    GLFWwindow *window,
-    int key,
-    int scancode,
-    int action,
-    int mod)
+// push the tank back out of anything it drove or turned into
+void resolveCollisions()
+{
+    collisionWorld->setTransform(0, Model3D::buildTransform(player->position, player->orientation.value, player->scale));
+    collisionWorld->step();
+    player->position += collisionWorld->getCorrection(0);
+}
+
+// one fixed step of gameplay, driven by the held keys instead of OS key repeat
+void simulationTick(const InputState &input, float deltaTime)
 {
+    for (Model3D *model : sceneModels)
+        model->storePreviousTransform();
+
     // perspective cam
-    if (key == GLFW_KEY_1 && (action == GLFW_REPEAT || action == GLFW_PRESS))
+    for (int i = 0; i < input.thirdPersonToggles; i++)
     {
-        usePerspectiveCamera = true;
-        useThirdPersonCamera = !useThirdPersonCamera;
+        simState.usePerspectiveCamera = true;
+        simState.useThirdPersonCamera = !simState.useThirdPersonCamera;
     }
 
     // ortho cam
-    if (key == GLFW_KEY_2 && (action == GLFW_REPEAT || action == GLFW_PRESS))
+    for (int i = 0; i < input.topCameraToggles; i++)
     {
-        usePerspectiveCamera = !usePerspectiveCamera;
-        useThirdPersonCamera = true;
-        topCamera->position.x = player->position.x;
-        topCamera->position.z = player->position.z;
+        simState.usePerspectiveCamera = !simState.usePerspectiveCamera;
+        simState.useThirdPersonCamera = true;
+        simState.topCameraPosition.x = player->position.x;
+        simState.topCameraPosition.z = player->position.z;
     }
 
-    // y axis rotation
-    if (key == GLFW_KEY_D && (action == GLFW_REPEAT || action == GLFW_PRESS))
+    // cycle the tank light's brightness
+    for (int i = 0; i < input.lightCycles; i++)
     {
-        if (!usePerspectiveCamera)
+        if (simState.pointLightSpecStr >= 2.f)
         {
-            // lightModel->rotation.y -= rotationIncrement;
-            topCamera->position.x -= positionIncrement;
-            // topCamera->position.z = player->position.z;
-            // updateLightPosition();
-        }
-        else if (usePerspectiveCamera)
-        {
-            player->rotation.z -= rotationIncrement;
+            simState.pointLightAmbientStr = 0.7f;
+            simState.pointLightSpecStr = 0.5f;
         }
+        simState.pointLightAmbientStr += 0.7f;
+        simState.pointLightSpecStr += 0.5f;
     }
 
-    if (key == GLFW_KEY_A && (action == GLFW_REPEAT || action == GLFW_PRESS))
+    if (simState.usePerspectiveCamera)
     {
-        if (!usePerspectiveCamera)
-        {
-            topCamera->position.x += positionIncrement;
-            // topCamera->position.z = player->position.z;
-
-            // updateLightPosition();
-        }
-        else if (usePerspectiveCamera)
-        {
-            player->rotation.z += rotationIncrement;
-        }
+        // some dark magic ritual that works!
+        // rotate the camera using the mouse's offset from the center while we keep the mouse at the center of the screen.
+        simState.thirdPersonRotation.x += 0.1f * input.mouseX;
+        simState.thirdPersonRotation.y += 0.1f * input.mouseY;
     }
 
-    // x axis rotation
-    if (key == GLFW_KEY_W && (action == GLFW_REPEAT || action == GLFW_PRESS))
+    if (!simState.usePerspectiveCamera)
     {
-        if (!usePerspectiveCamera)
-        {
-            // topCamera->position.x = player->position.x;
-            topCamera->position.z -= positionIncrement;
-
-            // updateLightPosition();
-        }
-        else if (usePerspectiveCamera && useThirdPersonCamera)
-        {
-            player->directionalMove(true);
-            updateLightPosition();
-        }
-        else if (usePerspectiveCamera && !useThirdPersonCamera && firstPersonCamera->rotation.y <= 90.f)
-        {
-            firstPersonCamera->rotation.y += rotationIncrement;
-        }
+        // pan the top down camera
+        if (input.right)
+            simState.topCameraPosition.x -= positionSpeed * deltaTime;
+        if (input.left)
+            simState.topCameraPosition.x += positionSpeed * deltaTime;
+        if (input.forward)
+            simState.topCameraPosition.z -= positionSpeed * deltaTime;
+        if (input.backward)
+            simState.topCameraPosition.z += positionSpeed * deltaTime;
     }
-
-    if (key == GLFW_KEY_S && (action == GLFW_REPEAT || action == GLFW_PRESS))
+    else if (simState.useThirdPersonCamera)
     {
-        if (!usePerspectiveCamera)
-        {
-            // topCamera->position.x = player->position.x;
-            topCamera->position.z += positionIncrement;
+        // drive the tank
+        if (input.right)
+            player->turn(false, deltaTime);
+        if (input.left)
+            player->turn(true, deltaTime);
 
-            // updateLightPosition();
-        }
-        else if (usePerspectiveCamera && useThirdPersonCamera)
+        if (input.forward || input.backward)
         {
-            player->directionalMove(false);
-            updateLightPosition();
+            if (input.forward)
+                player->directionalMove(true, deltaTime);
+            if (input.backward)
+                player->directionalMove(false, deltaTime);
         }
-        else if (usePerspectiveCamera && !useThirdPersonCamera && firstPersonCamera->rotation.y >= -90.f)
+
+        if (input.forward || input.backward || input.left || input.right)
         {
-            firstPersonCamera->rotation.y -= rotationIncrement;
+            resolveCollisions();
+            followGround();
         }
     }
-
-    if (key == GLFW_KEY_E && (action == GLFW_REPEAT || action == GLFW_PRESS))
+    else
     {
-        if (usePerspectiveCamera && !useThirdPersonCamera && firstPersonCamera->fov <= 120.f)
-            firstPersonCamera->fov += 5.f;
+        // binoculars: tank still turns, W/S look up and down, Q/E zoom
+        if (input.right)
+            player->turn(false, deltaTime);
+        if (input.left)
+            player->turn(true, deltaTime);
+        if (input.left || input.right)
+            resolveCollisions();
+
+        if (input.forward)
+            simState.firstPersonPitch += rotationSpeed * deltaTime;
+        if (input.backward)
+            simState.firstPersonPitch -= rotationSpeed * deltaTime;
+        simState.firstPersonPitch = clamp(simState.firstPersonPitch, -90.f, 90.f);
+
+        if (input.zoomIn)
+            simState.firstPersonFov += zoomSpeed * deltaTime;
+        if (input.zoomOut)
+            simState.firstPersonFov -= zoomSpeed * deltaTime;
+        simState.firstPersonFov = clamp(simState.firstPersonFov, 10.f, 120.f);
     }
+}
 
-    if (key == GLFW_KEY_Q && (action == GLFW_REPEAT || action == GLFW_PRESS))
+// copy the simulation's current state into the next snapshot and hand it to the render thread
+void publishSnapshot(double tickTime, double tickLength)
+{
+    FrameSnapshot &snapshot = snapshots.getWriteBuffer();
+
+    // the snapshot holds at most maxModels, setup already complained about any past that
+    snapshot.modelCount = int(sceneModels.size());
+    if (snapshot.modelCount > FrameSnapshot::maxModels)
+        snapshot.modelCount = FrameSnapshot::maxModels;
+    for (int i = 0; i < snapshot.modelCount; i++)
     {
-        if (usePerspectiveCamera && !useThirdPersonCamera && firstPersonCamera->fov >= 10.f)
-            firstPersonCamera->fov -= 5.f;
+        ModelTransform &transform = snapshot.models[i];
+        transform.previousPosition = sceneModels[i]->previousPosition;
+        transform.position = sceneModels[i]->position;
+        transform.previousOrientation = sceneModels[i]->previousOrientation;
+        transform.orientation = sceneModels[i]->orientation.value;
+        transform.scale = sceneModels[i]->scale;
     }
 
+    snapshot.usePerspectiveCamera = simState.usePerspectiveCamera;
+    snapshot.useThirdPersonCamera = simState.useThirdPersonCamera;
+    snapshot.thirdPersonRotation = simState.thirdPersonRotation;
+    snapshot.firstPersonPitch = simState.firstPersonPitch;
+    snapshot.firstPersonFov = simState.firstPersonFov;
+    snapshot.topCameraPosition = simState.topCameraPosition;
+
+    snapshot.pointLightAmbientStr = simState.pointLightAmbientStr;
+    snapshot.pointLightSpecStr = simState.pointLightSpecStr;
+
+    snapshot.tickTime = tickTime;
+    snapshot.tickLength = tickLength;
+
+    snapshots.publish();
+}
+
+static void Key_Callback(
+    GLFWwindow *window,
+    int key,
+    int scancode,
+    int action,
+    int mod)
+{
+    // perspective cam
+    if (key == GLFW_KEY_1 && (action == GLFW_REPEAT || action == GLFW_PRESS))
+        inputQueue.addThirdPersonToggle();
+
+    // ortho cam
+    if (key == GLFW_KEY_2 && (action == GLFW_REPEAT || action == GLFW_PRESS))
+        inputQueue.addTopCameraToggle();
+
     if (key == GLFW_KEY_F && (action == GLFW_REPEAT || action == GLFW_PRESS))
-    {
-        if (pointLight->specStr >= 2.f)
-        {
-            pointLight->ambientStr = 0.7f;
-            pointLight->specStr = 0.5f;
-        }
-        pointLight->ambientStr += 0.7f;
-        pointLight->specStr += 0.5f;
-    }
+        inputQueue.addLightCycle();
 
-    // direction light brightness
-    // if (key == GLFW_KEY_RIGHT && (action == GLFW_REPEAT || action == GLFW_PRESS) && controlLight)
-    // {
-    //     directionLight->ambientStr += 0.1f;
-    //     directionLight->specStr += 0.1f;
-    // }
-
-    // if (key == GLFW_KEY_LEFT && (action == GLFW_REPEAT || action == GLFW_PRESS) && controlLight)
-    // {
-    //     directionLight->ambientStr -= 0.1f;
-    //     directionLight->specStr -= 0.1f;
-    // }
-
-    // if (key == GLFW_KEY_UP && (action == GLFW_REPEAT || action == GLFW_PRESS))
-    // {
-    // }
-
-    // if (key == GLFW_KEY_DOWN && (action == GLFW_REPEAT || action == GLFW_PRESS))
-    // {
-    // }
+    // profiler capture
+    if (key == GLFW_KEY_P && action == GLFW_PRESS)
+        profiling::Profiler::get().requestCapture(captureFrames);
 }
 
 static void Cursor_Position_Callback(GLFWwindow *window, double xpos, double ypos)
 {
+    // the simulation decides whether the offset turns the camera
     if (glfwGetWindowAttrib(window, GLFW_FOCUSED))
-    {
-        if (usePerspectiveCamera)
-        {
-            // some dark magic ritual that works!
-            // rotate the camera using the mouse's offset from the center while we keep the mouse at the center of the screen.
-            thirdPersonCamera->rotation.x += 0.1f * float(width / 2 - xpos);
-            thirdPersonCamera->rotation.y += 0.1f * float(height / 2 - ypos);
-        }
-    }
+        inputQueue.addMouse(float(width / 2 - xpos), float(height / 2 - ypos));
 }
 
 void Mouse_Button_Callback(GLFWwindow *window, int button, int action, int mods)
@@ -247,8 +348,10 @@ void Mouse_Button_Callback(GLFWwindow *window, int button, int action, int mods)
     }
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
+    const char *scenePath = argc > 1 ? argv[1] : defaultScenePath;
+
     GLFWwindow *window;
 
     /* Initialize the library */
@@ -256,7 +359,7 @@ int main(void)
         return -1;
 
     /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(height, width, "Marcus Leocario / Joachim Arguelles", NULL, NULL);
+    window = glfwCreateWindow(height, width, windowTitle, NULL, NULL);
     if (!window)
     {
         glfwTerminate();
@@ -273,10 +376,25 @@ int main(void)
 
     gladLoadGL();
 
+    glEnable(GL_DEPTH_TEST);
+
     glfwSetKeyCallback(window, Key_Callback);
     glfwSetCursorPosCallback(window, Cursor_Position_Callback);
     glfwSetMouseButtonCallback(window, Mouse_Button_Callback);
 
+    PROFILE_THREAD_NAME("Main (GL)");
+    if (captureStartup)
+    {
+        profiling::Profiler::get().requestCapture(captureFrames, "startup_trace.json");
+        profiling::Profiler::get().beginFrame();
+    }
+
+    jobSystem = new jobs::JobSystem(useJobThreads ? jobs::JobSystem::defaultWorkerCount() : 0);
+
+    // everything below asks the archive first, mapping it reads nothing yet
+    if (std::filesystem::exists(archivePath))
+        assets::AssetArchive::get().open(archivePath);
+
     Shader skybox("Shaders/skybox.vert", "Shaders/skybox.frag");
 
     /*
@@ -358,72 +476,360 @@ int main(void)
 
     for (unsigned int i = 0; i < 6; i++)
     {
-        int w, h, skyCChannel;
-        stbi_set_flip_vertically_on_load(false);
+        // cube map faces stay the way up they're stored
+        ImageData face = ModelSource::loadImage(facesSkybox[i], false);
 
-        unsigned char *data = stbi_load(facesSkybox[i].c_str(), &w, &h, &skyCChannel, 0);
+        if (face.bytes)
+        {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, face.width, face.height, 0, GL_RGB, GL_UNSIGNED_BYTE, face.bytes);
+        }
 
-        if (data)
+        ModelSource::freeImage(face);
+    }
+
+    // what to load and where it goes
+    scene::SceneFile sceneFile;
+    {
+        PROFILE_SCOPE("Load Scene");
+        if (!sceneFile.load(scenePath))
         {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+            glfwTerminate();
+            return -1;
         }
+    }
+    int playerPlacement = sceneFile.getPlayer();
+    if (playerPlacement < 0)
+    {
+        std::cout << "Error in scene file! " << scenePath << " has no player" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    const scene::SceneFile::Placement &playerStart = sceneFile.placements[playerPlacement];
 
-        stbi_image_free(data);
+    // parse every obj and decode every texture on the job system, then upload them from here since GL is single threaded.
+    // each asset loads once however often it's placed, ones nothing places aren't loaded at all
+    std::vector<std::unique_ptr<ModelSource>> sources(sceneFile.assets.size());
+    std::vector<size_t> placedAssets;
+    for (const scene::SceneFile::Placement &placement : sceneFile.placements)
+    {
+        if (sources[placement.asset])
+            continue;
+        const scene::SceneFile::Asset &asset = sceneFile.assets[placement.asset];
+        sources[placement.asset].reset(new ModelSource(asset.model, asset.texture, asset.normal));
+        placedAssets.push_back(placement.asset);
     }
 
-    // model from https://free3d.com/3d-model/german-wwii-era-heavy-tank-tiger-i-254401.html
-    player = new Player("Models/source/tanknew.obj", "Models/texture/tank.jpg", "Models/texture/tank_normal.jpg", vec3(1.f), vec3(0.f, 0.7f, 0.f), vec3(-90.f, 0.f, 0.f), vec3(1.f));
-
-    // Among Us character model from https://skfb.ly/6XXwV
-    // Model3D amogus("Models/source/among us.obj", "Plastic_4K_Diffuse.jpg", "Plastic_4K_Normal.jpg", vec3(1.f), vec3(0.f, 0.f, -30.f), vec3(0.f, 0.f, 0.f), vec3(0.01f));
-    
-    // model from https://www.turbosquid.com/3d-models/fictional-pbr-tank-3d-model-1382107
-    Model3D fictionalTank("Models/source/fictionaltank.obj", "Models/texture/fictionaltank.jpg");
-    fictionalTank.position = vec3(40.f, 3.f, -5.f);
-    fictionalTank.rotation = vec3(-90.f, 0.f, 32.f);
-    
-    // model from https://www.turbosquid.com/3d-models/3d-model-of-tank/899695
-    Model3D genericTank("Models/source/generictank.obj", "Models/texture/generictank.jpg");
-    genericTank.position = vec3(60.f, 3.f, 50.f);
-    genericTank.rotation = vec3(-90.f, 0.f, 43.f);
-    
-    // model from https://www.turbosquid.com/3d-models/free-3ds-mode-wiesel-2-ozelot-anti-air/361920
-    Model3D ozelot("Models/source/ozelot.obj", "Models/texture/ozelot.jpg");
-    ozelot.position = vec3(10.f, 3.f, 80.f);
-    ozelot.rotation = vec3(-90.f, 0.f, 56.f);
-    
-    // model from https://www.turbosquid.com/3d-models/free-sherman-3d-model/949824
-    Model3D sherman("Models/source/sherman.obj", "Models/texture/sherman.jpg");
-    sherman.position = vec3(-30.f, 3.f, 30.f);
-    sherman.rotation = vec3(-90.f, 0.f, 47.f);
-    
-    // modified model, original from https://free3d.com/3d-model/t-90a-russian-tank-47395.html
-    Model3D t90broken("Models/source/t90broken.obj", "Models/texture/t90broken.png");
-    t90broken.position = vec3(-30.f, 1.f, 0.f);
-    t90broken.rotation = vec3(-90.f, 0.f, 72.f);
-
-    // model from https://skfb.ly/orGPV
-    Model3D deadTree("Models/source/DeadTree_LoPoly.obj", "Models/texture/DeadTree_LoPoly_DeadTree_Diffuse.jpg", "Models/texture/DeadTree_LoPoly_DeadTree_Normal.jpg");
-    deadTree.position = vec3(-100.f, 1.f, -30.f);
-
-    // Model3D fictionalTank("Models/source/fictionaltank.obj", "Models/texture/fictionaltank.png");
-
-    plane = new Model3D("Models/source/plane.obj", "Models/texture/Grass.png", "", vec3(1.f), vec3(0.f, 0.f, 0.f), vec3(-90.f, 0.f, 0.f), vec3(1000.f));
-
-    thirdPersonCamera = new PerspectiveCamera(60, height, width, vec3(0.f, 2.f, 20.f), vec3(0.f, 0.f, 0.f), vec3(0.f, 0.f, 0.f));
-    firstPersonCamera = new PerspectiveCamera(60, height, width, vec3(0.f, 2.f, 20.f), vec3(0.f, 0.f, 0.f), vec3(0.f, 0.f, 0.f));
-    topCamera = new OrthoCamera(vec3(0.f, 50.f, 0.f), vec3(0.f, -90.f, 0.f), vec3(0.f, 0.f, 0.f));
-
-    directionLight = new DirectionLight("dirLight", vec3(0, -10, 5), 0.1f, 0.2f, 32, vec3(0.3f, 0.3f, 1.f), vec3(0.3f, 0.3f, 1.f));
-    pointLight = new PointLight("pointLight", vec3(0.f, 3.f, 0.f), 0.5f, 0.7f, 32, vec3(1.f, 1.f, 1.f), vec3(1.f, 1.f, 1.f));
+    {
+        PROFILE_SCOPE("Load Models");
+        jobSystem->parallelFor(0, placedAssets.size(), 1, [&sources, &placedAssets](size_t first, size_t last)
+                               {
+            for (size_t i = first; i < last; i++)
+                sources[placedAssets[i]]->load(); });
+    }
+
+    // one model per asset that every placement of it draws with, the player's doubles as the one for its asset
+    player = new Player(*sources[playerStart.asset], vec3(1.f), playerStart.position, playerStart.rotation, playerStart.scale);
+    std::vector<Model3D *> assetModels(sources.size(), nullptr);
+    assetModels[playerStart.asset] = player;
+    for (size_t asset : placedAssets)
+    {
+        if (!assetModels[asset])
+            assetModels[asset] = new Model3D(*sources[asset]);
+    }
+    sources.clear(); // everything's on the GPU now
+
+    // cameras and lights from the scene, with what used to be hardcoded for anything it leaves out
+    auto getCamera = [&sceneFile](uint32_t role, const scene::SceneFile::Camera &fallback)
+    {
+        const scene::SceneFile::Camera *camera = sceneFile.getCamera(role);
+        return camera ? *camera : fallback;
+    };
+    scene::SceneFile::Camera thirdPersonStart = getCamera(scene::SceneFile::ThirdPerson, {scene::SceneFile::ThirdPerson, 60.f, vec3(0.f, 2.f, 20.f), vec3(0.f)});
+    scene::SceneFile::Camera firstPersonStart = getCamera(scene::SceneFile::FirstPerson, {scene::SceneFile::FirstPerson, 60.f, vec3(0.f, 2.f, 20.f), vec3(0.f)});
+    scene::SceneFile::Camera topStart = getCamera(scene::SceneFile::Top, {scene::SceneFile::Top, 0.f, vec3(0.f, 50.f, 0.f), vec3(0.f, -90.f, 0.f)});
+
+    thirdPersonCamera = new PerspectiveCamera(thirdPersonStart.fov, height, width, thirdPersonStart.position, thirdPersonStart.rotation, vec3(0.f, 0.f, 0.f));
+    firstPersonCamera = new PerspectiveCamera(firstPersonStart.fov, height, width, firstPersonStart.position, firstPersonStart.rotation, vec3(0.f, 0.f, 0.f));
+    topCamera = new OrthoCamera(topStart.position, topStart.rotation, vec3(0.f, 0.f, 0.f));
+
+    // the shaders take one light of each kind
+    const scene::SceneFile::Light *sunStart = nullptr;
+    const scene::SceneFile::Light *pointLightStart = nullptr;
+    for (const scene::SceneFile::Light &light : sceneFile.lights)
+    {
+        const scene::SceneFile::Light *&slot = light.type == scene::SceneFile::Directional ? sunStart : pointLightStart;
+        if (slot)
+            std::cout << "only one light of each kind is supported, skipping " << light.name << std::endl;
+        else
+            slot = &light;
+    }
+
+    if (sunStart)
+        directionLight = new DirectionLight(sunStart->name, sunStart->vector, sunStart->ambientStr, sunStart->specStr, sunStart->specPhong, sunStart->color, sunStart->ambientColor);
+    else
+        directionLight = new DirectionLight("dirLight", vec3(0, -10, 5), 0.1f, 0.2f, 32, vec3(0.3f, 0.3f, 1.f), vec3(0.3f, 0.3f, 1.f));
+
+    // an attached light's position is its offset on the tank, it's placed through the scene graph every frame
+    bool pointLightAttached = true;
+    vec3 pointLightOffset = vec3(0.f, 0.f, -5.f);
+    if (pointLightStart)
+    {
+        pointLight = new PointLight(pointLightStart->name, pointLightStart->vector, pointLightStart->ambientStr, pointLightStart->specStr, pointLightStart->specPhong, pointLightStart->color, pointLightStart->ambientColor);
+        pointLightAttached = (pointLightStart->flags & scene::SceneFile::Attached) != 0;
+        pointLightOffset = pointLightStart->vector;
+    }
+    else
+        pointLight = new PointLight("pointLight", vec3(0.f, 3.f, 0.f), 0.5f, 0.7f, 32, vec3(1.f, 1.f, 1.f), vec3(1.f, 1.f, 1.f));
 
     std::cout << "loaded cameras" << std::endl;
 
-    Shader sample("Shaders/sample.vert", "Shaders/sample.frag");
+    // material shader, specialised per model and camera mode, variants compile the first time they're drawn
+    ShaderVariants sampleVariants("Shaders/sample.vert", "Shaders/sample.frag", sampleFeatureNames);
+
+    // the ground, streamed in chunks around the player. it draws with the sample fragment shader
+    ShaderVariants terrainVariants("Shaders/terrain.vert", "Shaders/sample.frag", sampleFeatureNames);
+    terrain::Terrain terrain(*jobSystem, "Models/texture/Grass.png");
+    terrain.loadAround(player->position);
+
+    // night vision, fog and tonemapping, applied to the whole frame at once
+    PostProcess postProcess;
+    postProcess.renderScale = renderScale;
+
+    DynamicResolution dynamicResolution;
+    dynamicResolution.targetMilliseconds = gpuBudgetMs;
+    dynamicResolution.scale = renderScale;
+
+    ShaderWatcher shaderWatcher;
+    if (useShaderHotReload)
+    {
+        shaderWatcher.watch("Shaders/post.vert");
+        shaderWatcher.watch("Shaders/post.frag");
+        shaderWatcher.watch("Shaders/skybox.vert");
+        shaderWatcher.watch("Shaders/skybox.frag");
+        shaderWatcher.watch("Shaders/sample.vert");
+        shaderWatcher.watch("Shaders/sample.frag");
+        shaderWatcher.watch("Shaders/terrain.vert");
+        shaderWatcher.start();
+    }
+
+    // the loose files, even when the models came from the archive
+    ModelReloader modelReloader;
+    if (useModelHotReload)
+    {
+        for (size_t asset = 0; asset < assetModels.size(); asset++)
+        {
+            if (assetModels[asset])
+                modelReloader.watch(assetModels[asset], sceneFile.assets[asset].model, sceneFile.assets[asset].texture, sceneFile.assets[asset].normal);
+        }
+        modelReloader.start(jobSystem);
+    }
+
+    // every placement is an object: the player first (the only one the simulation moves), then the static ones.
+    // object indices are shared by the transforms, the bounds tree, the collision bodies and the lods below
+    sceneModels = {player};
+    if (sceneModels.size() > size_t(FrameSnapshot::maxModels))
+        std::cout << "Error: " << sceneModels.size() << " moving models, snapshots only carry " << FrameSnapshot::maxModels
+                  << ", the rest won't move on screen" << std::endl;
+    int dynamicCount = int(sceneModels.size());
+    std::vector<Model3D *> objectModels{player};
+    std::vector<int> objectAssets{int(playerStart.asset)};
+    std::vector<vec3> objectPositions{player->position};
+    std::vector<quat> objectOrientations{player->orientation.value};
+    std::vector<vec3> objectScales{player->scale};
+    for (size_t i = 0; i < sceneFile.placements.size(); i++)
+    {
+        if (int(i) == playerPlacement)
+            continue;
+        const scene::SceneFile::Placement &placement = sceneFile.placements[i];
+        objectModels.push_back(assetModels[placement.asset]);
+        objectAssets.push_back(int(placement.asset));
+        objectPositions.push_back(placement.position);
+        objectOrientations.push_back(gd::Orientation::eulerToQuat(placement.rotation));
+        objectScales.push_back(placement.scale);
+    }
+    size_t objectCount = objectModels.size();
+
+    // everything was placed for flat ground at y = 0, lift it onto the terrain in one batch
+    simulationGround = new terrain::HeightField(terrain.generator, terrain.getCellSize());
+    {
+        std::vector<float> groundX(objectCount), groundZ(objectCount), groundHeights(objectCount);
+        for (size_t i = 0; i < objectCount; i++)
+        {
+            groundX[i] = objectPositions[i].x;
+            groundZ[i] = objectPositions[i].z;
+        }
+        simulationGround->getHeights(groundX.data(), groundZ.data(), groundHeights.data(), objectCount);
+        for (size_t i = 0; i < objectCount; i++)
+            objectPositions[i].y += groundHeights[i];
+        player->position = objectPositions[0];
+    }
+
+    // the render thread's copy of the object transforms. static ones are built here once, the player's is rebuilt
+    // from the interpolated snapshot every frame
+    scene::TransformStore sceneTransforms;
+    for (size_t i = 0; i < objectCount; i++)
+        sceneTransforms.create(objectPositions[i], objectOrientations[i], objectScales[i], objectModels[i]->getMinBounds(), objectModels[i]->getMaxBounds());
+    sceneTransforms.updateWorldMatrices();
+
+    // the props never move, only the player gets pushed
+    collisionWorld = new physics::CollisionWorld();
+    for (size_t i = 0; i < objectCount; i++)
+        collisionWorld->addBody(objectModels[i]->getMinBounds(), objectModels[i]->getMaxBounds(), sceneTransforms.getWorldMatrix(int(i)), int(i) >= dynamicCount);
+
+    // the render thread keeps its own for the cameras, height fields aren't shared between threads
+    terrain::HeightField cameraGround(terrain.generator, terrain.getCellSize());
+
+    // bounding volume tree over the objects' world bounds, culling asks it instead of testing every object
+    spatial::AabbTree sceneTree;
+    sceneTree.margin = 2.f; // the tank covers about a quarter unit a frame, this saves reinserting it every frame
+    std::vector<int> sceneProxies;
+    for (size_t i = 0; i < objectCount; i++)
+    {
+        vec3 worldMin, worldMax;
+        sceneTransforms.getWorldBounds(int(i), worldMin, worldMax);
+        sceneProxies.push_back(sceneTree.insert(worldMin, worldMax, int(i)));
+    }
+    sceneTree.rebuild();
+
+    // big visible models get rasterized into a small cpu depth buffer every frame, and whatever's behind them isn't drawn.
+    // it's 256 wide with the window's aspect, so its pixels stay square
+    int windowWidth, windowHeight;
+    glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+    OcclusionCuller occlusionCuller(*jobSystem, 256, std::max(256 * windowHeight / std::max(windowWidth, 1), 8));
+
+    // visible static objects of each asset are grouped by lod so each group is one instanced draw
+    int batchCount = int(assetModels.size()) * ModelSource::maxLods;
+    std::vector<uint8_t> objectLods(objectCount, 0); // what each static object drew with last, for the hysteresis
+
+    // attachments of the tank, in its heading frame: origin at the tank, -z behind it
+    scene::SceneGraph sceneGraph;
+    int tankNode = sceneGraph.createNode();
+    int binocularNode = sceneGraph.createNode(tankNode, glm::translate(mat4(1.f), vec3(0.f, 1.3f, -5.f)));
+    int tankLightNode = sceneGraph.createNode(tankNode, glm::translate(mat4(1.f), pointLightOffset));
+    const quat layDown = angleAxis(glm::radians(90.f), vec3(1.f, 0.f, 0.f)); // undoes the models' -90 on x
+    float binocularPitch = NAN;
+
+    // what the binoculars are pointed at, shown in the title
+    int targetModel = -1;
+    float targetDistance = 0.f;
+
+    // models were placed after construction, don't interpolate from where they were made
+    for (Model3D *model : sceneModels)
+        model->storePreviousTransform();
+
+    // starting state for the simulation, taken from the objects we just set up
+    simState.thirdPersonRotation = thirdPersonCamera->rotation;
+    simState.firstPersonPitch = firstPersonCamera->rotation.y;
+    simState.firstPersonFov = firstPersonCamera->fov;
+    simState.topCameraPosition = topCamera->position;
+    simState.pointLightAmbientStr = pointLight->ambientStr;
+    simState.pointLightSpecStr = pointLight->specStr;
+
+    // 0 renders uncapped, gameplay speed no longer depends on it
+    glfwSwapInterval(useVsync ? 1 : 0);
+
+    // simulation runs ahead on its own thread, this thread only renders the snapshots it publishes
+    SimulationThread simulation(
+        simulationRate,
+        [](float deltaTime)
+        { simulationTick(inputQueue.take(), deltaTime); },
+        publishSnapshot);
+
+    publishSnapshot(glfwGetTime(), 0.0);
+    if (useSimulationThread)
+        simulation.start();
+
+    FrameStats stats;
+    double statsTime = glfwGetTime();
+    double titleTime = statsTime;
+    uint64_t lastGpuResult = 0;
+
+    // what a frame works out and throws away (the visible list, instance batches) is bumped out of here and
+    // dropped at the start of the next frame. sized for every object being visible, so it never grows
+    gd::LinearArena frameArena(objectCount * (2 * sizeof(int) + sizeof(mat4)) + (2 * batchCount + 1) * sizeof(int) + 8 * alignof(std::max_align_t));
+
+    // a frame only counts as steady once nothing about the setup changed for a while: new shader variants,
+    // a camera switch or a resize all make the driver compile or allocate on its own
+    int steadyFrames = 0;
+    uint64_t lastSetup = 0;
+    size_t lastVariantCount = 0;
+
+    // gpu side timings for the trace
+    profiling::GpuZone skyboxGpuZone("Skybox");
+    profiling::GpuZone terrainGpuZone("Terrain");
+    profiling::GpuZone modelsGpuZone("Models");
+    profiling::GpuZone postGpuZone("Post");
+    profiling::GpuZone swapGpuZone("Swap");
 
     /* Loop until the user closes the window */
     while (!glfwWindowShouldClose(window))
     {
+        // nothing in a steady frame should touch the heap (the tracker counts operator new on this thread), anything
+        // that's expected to (reloads, streaming, captures) says so with an AllowAllocations
+        profiling::NoAllocationScope noAllocations(steadyFrames >= steadyAfterFrames);
+        profiling::AllocationScope frameHeap;
+
+        profiling::Profiler::get().beginFrame();
+        PROFILE_SCOPE("Frame");
+
+        double frameStart = glfwGetTime();
+        frameArena.reset();
+
+        inputQueue.setHeldKeys(InputState::poll(window));
+
+        // swap in any shaders that were saved since last frame
+        for (const SourceChange &change : shaderWatcher.takeChanges())
+        {
+            profiling::AllowAllocations allow;
+            int reloaded = (skybox.reload(change.path, change.source) ? 1 : 0) + sampleVariants.reload(change.path, change.source) +
+                           terrainVariants.reload(change.path, change.source) + postProcess.shaders.reload(change.path, change.source);
+            std::cout << "reloaded " << change.path << " (" << reloaded << " programs)" << std::endl;
+        }
+
+        // and a model or texture that finished reloading. objects drawn with it take its new bounds for culling,
+        // collision keeps the boxes it started with (they belong to the simulation thread)
+        if (Model3D *reloaded = modelReloader.update())
+        {
+            for (size_t i = 0; i < objectCount; i++)
+            {
+                if (objectModels[i] == reloaded)
+                    sceneTransforms.setLocalBounds(int(i), reloaded->getMinBounds(), reloaded->getMaxBounds());
+            }
+            sceneTransforms.updateWorldMatrices();
+            for (size_t i = 0; i < objectCount; i++)
+            {
+                if (objectModels[i] != reloaded)
+                    continue;
+                vec3 worldMin, worldMax;
+                sceneTransforms.getWorldBounds(int(i), worldMin, worldMax);
+                sceneTree.move(sceneProxies[i], worldMin, worldMax);
+            }
+        }
+
+        if (!useSimulationThread)
+            simulation.step(frameStart);
+
+        // newest finished simulation frame, if the last one has been replaced
+        snapshots.consume();
+        const FrameSnapshot &snapshot = snapshots.getReadBuffer();
+
+        double renderStart = glfwGetTime();
+
+        // blend the models between the last two ticks so motion stays smooth at any frame rate
+        float alpha = snapshot.getAlpha(renderStart);
+        vec3 playerPosition = snapshot.models[0].getPosition(alpha);
+        quat playerOrientation = snapshot.models[0].getOrientation(alpha);
+
+        bool usePerspectiveCamera = snapshot.usePerspectiveCamera;
+        bool useThirdPersonCamera = snapshot.useThirdPersonCamera;
+
+        thirdPersonCamera->rotation = snapshot.thirdPersonRotation;
+        firstPersonCamera->fov = snapshot.firstPersonFov;
+        topCamera->position = snapshot.topCameraPosition;
+
+        pointLight->ambientStr = snapshot.pointLightAmbientStr;
+        pointLight->specStr = snapshot.pointLightSpecStr;
+
         // if using perspective cam, lock the mouse to the center to use the first person cam controls
         if (usePerspectiveCamera)
         {
@@ -431,23 +837,32 @@ int main(void)
             {
                 glfwSetCursorPos(window, height / 2.f, width / 2.f);
 
-                // translate the camera 10 units away from the player in all directions and negate its (direction) rotation to keep it aimed at the player
-                thirdPersonCamera->position.x = player->position.x - (cos(glm::radians(thirdPersonCamera->rotation.y)) * sin(glm::radians(thirdPersonCamera->rotation.x))) * 10.f;
-                thirdPersonCamera->position.y = (player->position.y + 3.f) - sin(glm::radians(thirdPersonCamera->rotation.y)) * 10.f;
-                thirdPersonCamera->position.z = player->position.z - (cos(glm::radians(thirdPersonCamera->rotation.y)) * cos(glm::radians(thirdPersonCamera->rotation.x))) * 10.f;
+                // back the camera 10 units away from a point above the player along where it looks, so it stays aimed at the player
+                thirdPersonCamera->position = playerPosition + vec3(0.f, 3.f, 0.f) - thirdPersonCamera->getForward() * 10.f;
 
                 // limit the camera so u can't go through the ground
-                if (thirdPersonCamera->position.y <= 0.1f)
-                    thirdPersonCamera->position.y = 0.1f;
+                float groundHeight = cameraGround.getHeight(thirdPersonCamera->position.x, thirdPersonCamera->position.z) + 0.1f;
+                if (thirdPersonCamera->position.y <= groundHeight)
+                    thirdPersonCamera->position.y = groundHeight;
             }
         }
 
-        firstPersonCamera->rotation.x = player->rotation.z + 180.f;
-        firstPersonCamera->position.x = player->position.x - sin(glm::radians(player->rotation.z)) * 5.f;
-        firstPersonCamera->position.z = player->position.z - cos(glm::radians(player->rotation.z)) * 5.f;
+        // everything riding on the tank follows its heading frame, the model's orientation without the stand up
+        sceneGraph.setLocalMatrix(tankNode, Model3D::buildTransform(playerPosition, playerOrientation * layDown, vec3(1.f)));
 
-        pointLight->position.x = player->position.x - sin(glm::radians(player->rotation.z)) * 5.f;
-        pointLight->position.z = player->position.z - cos(glm::radians(player->rotation.z)) * 5.f;
+        // the binoculars look out the back of the frame, tilted by the pitch (trig only when that changes)
+        if (snapshot.firstPersonPitch != binocularPitch)
+        {
+            binocularPitch = snapshot.firstPersonPitch;
+            quat tilt = angleAxis(glm::radians(180.f), vec3(0.f, 1.f, 0.f)) * angleAxis(glm::radians(-binocularPitch), vec3(1.f, 0.f, 0.f));
+            sceneGraph.setLocalMatrix(binocularNode, Model3D::buildTransform(vec3(0.f, 1.3f, -5.f), tilt, vec3(1.f)));
+        }
+        sceneGraph.update();
+
+        firstPersonCamera->position = sceneGraph.getWorldPosition(binocularNode);
+        firstPersonCamera->setOrientation(quat_cast(mat3(sceneGraph.getWorldMatrix(binocularNode))));
+        if (pointLightAttached)
+            pointLight->position = sceneGraph.getWorldPosition(tankLightNode);
 
         Camera *currentCamera;
 
@@ -458,81 +873,356 @@ int main(void)
         else // use orthographic projection and view matrix
             currentCamera = topCamera;
 
+        // stream terrain chunks in around the player and drop the ones left behind
+        terrain.update(playerPosition);
+
+        // build the view/projection matrices and frustum once for everything this frame
+        currentCamera->update();
+        const Frustum &frustum = currentCamera->getFrustum();
+
         /* Render here */
         glFlush();
 
+        // the scene goes to the offscreen hdr target, post processing resolves it to the window
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        postProcess.begin(framebufferWidth, framebufferHeight);
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glDepthMask(GL_FALSE);
-        glDepthFunc(GL_LEQUAL);
+        {
+            PROFILE_SCOPE("Skybox");
+            PROFILE_GPU_SCOPE_ALWAYS(skyboxGpuZone, useDynamicResolution);
+
+            glDepthMask(GL_FALSE);
+            glDepthFunc(GL_LEQUAL);
+
+            glUseProgram(skybox.shaderProgram);
+
+            glm::mat4 skyView = glm::mat4(1.f);
+            skyView = glm::mat4(
+                glm::mat3(currentCamera->getViewMatrix()));
+
+            unsigned int sky_ViewLoc = skybox.getUniformLocation("view");
+            glUniformMatrix4fv(sky_ViewLoc, 1, GL_FALSE, glm::value_ptr(skyView));
 
-        glUseProgram(skybox.shaderProgram);
+            unsigned int sky_ProjectionLoc = skybox.getUniformLocation("projection");
+            glUniformMatrix4fv(sky_ProjectionLoc, 1, GL_FALSE, glm::value_ptr(currentCamera->getProjectionMatrix()));
 
-        glm::mat4 skyView = glm::mat4(1.f);
-        skyView = glm::mat4(
-            glm::mat3(currentCamera->generateViewMatrix()));
+            glBindVertexArray(skyboxVAO);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
 
-        unsigned int sky_ViewLoc = glGetUniformLocation(skybox.shaderProgram, "view");
-        glUniformMatrix4fv(sky_ViewLoc, 1, GL_FALSE, glm::value_ptr(skyView));
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
 
-        unsigned int sky_ProjectionLoc = glGetUniformLocation(skybox.shaderProgram, "projection");
-        glUniformMatrix4fv(sky_ProjectionLoc, 1, GL_FALSE, glm::value_ptr(currentCamera->generateProjectionMatrix()));
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LESS);
+        }
+
+        long long frameTriangles = 0;
+
+        bool fogActive = useThirdPersonCamera && usePerspectiveCamera;
+
+        // scene half of the variant, models add what their own data supports
+        uint32_t sceneFeatures = feature::DirLight | feature::PointLight;
+
+        // per frame uniforms go to each variant the first time it's used this frame
+        GLuint preparedPrograms[16];
+        int preparedCount = 0;
+        auto prepareProgram = [&](Shader &variant)
+        {
+            GLuint &program = variant.shaderProgram;
+            for (int i = 0; i < preparedCount; i++)
+            {
+                if (preparedPrograms[i] == program)
+                    return;
+            }
+            if (preparedCount < 16)
+                preparedPrograms[preparedCount++] = program;
+
+            glUseProgram(program);
+
+            unsigned int cameraPosLoc = variant.getUniformLocation("cameraPos");
+            glUniform3fv(cameraPosLoc, 1, glm::value_ptr(currentCamera->position));
+
+            // update uniforms for both lights
+            directionLight->applyUniforms(variant);
+            directionLight->applyExtraUniforms(variant);
+
+            pointLight->applyUniforms(variant);
+            pointLight->applyExtraUniforms(variant);
+
+            unsigned int projectionLoc = variant.getUniformLocation("projection");
+            glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(currentCamera->getProjectionMatrix()));
+
+            unsigned int viewLoc = variant.getUniformLocation("view");
+            glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(currentCamera->getViewMatrix()));
+        };
+
+        {
+            PROFILE_SCOPE("Terrain");
+            PROFILE_GPU_SCOPE_ALWAYS(terrainGpuZone, useDynamicResolution);
+
+            Shader &variant = terrainVariants.get(terrain.getShaderFeatures(sceneFeatures));
+            prepareProgram(variant);
+
+            terrain::Terrain::DrawStats terrainStats = terrain.draw(variant, frustum, currentCamera->position);
+            frameTriangles += terrainStats.triangles;
+            stats.fullDetailTriangles += terrainStats.fullDetailTriangles;
+        }
+
+        {
+            PROFILE_SCOPE("Models");
+            PROFILE_GPU_SCOPE_ALWAYS(modelsGpuZone, useDynamicResolution);
+
+            // world matrices and bounds for whatever moved, then the tree follows them. only models that left
+            // their fat box restructure it
+            for (int i = 0; i < snapshot.modelCount; i++)
+            {
+                const ModelTransform &transform = snapshot.models[i];
+                sceneTransforms.setTransform(i, transform.getPosition(alpha), transform.getOrientation(alpha), transform.scale);
+            }
+            sceneTransforms.updateWorldMatrices();
+
+            for (int i = 0; i < snapshot.modelCount; i++)
+            {
+                vec3 worldMin, worldMax;
+                sceneTransforms.getWorldBounds(i, worldMin, worldMax);
+                sceneTree.move(sceneProxies[i], worldMin, worldMax);
+            }
 
-        unsigned int sky_useThirdPersonCameraLoc = glGetUniformLocation(skybox.shaderProgram, "useThirdPersonCamera");
-        glUniform1i(sky_useThirdPersonCameraLoc, useThirdPersonCamera);
+            // Draw (skipping anything outside the camera's frustum), in scene order so program switches stay the same
+            int *visibleModels = frameArena.allocateArray<int>(objectCount);
+            int visibleCount = 0;
+            sceneTree.queryFrustum(frustum, [visibleModels, &visibleCount](int model)
+                                   {
+                visibleModels[visibleCount++] = model;
+                return true; });
+            std::sort(visibleModels, visibleModels + visibleCount);
+
+            // the big ones among them are the occluders, then every visible box is tested against what they cover
+            if (useOcclusionCulling)
+            {
+                PROFILE_SCOPE("Occlusion");
+                double occlusionStart = glfwGetTime();
+
+                occlusionCuller.begin(currentCamera->getViewProjectionMatrix(), currentCamera->getProjectionMatrix());
+                for (int v = 0; v < visibleCount; v++)
+                {
+                    int i = visibleModels[v];
+                    vec3 worldMin, worldMax;
+                    sceneTransforms.getWorldBounds(i, worldMin, worldMax);
+                    const std::vector<vec3> &occluder = objectModels[i]->getOccluderVertices();
+                    occlusionCuller.addOccluder(occluder.data(), int(occluder.size()), sceneTransforms.getWorldMatrix(i), worldMin, worldMax);
+                }
+                occlusionCuller.render();
+
+                int unoccludedCount = 0;
+                for (int v = 0; v < visibleCount; v++)
+                {
+                    vec3 worldMin, worldMax;
+                    sceneTransforms.getWorldBounds(visibleModels[v], worldMin, worldMax);
+                    if (occlusionCuller.isVisible(worldMin, worldMax))
+                        visibleModels[unoccludedCount++] = visibleModels[v];
+                }
+                visibleCount = unoccludedCount;
+
+                double occlusionTime = glfwGetTime() - occlusionStart;
+                const OcclusionCuller::Stats &occlusionStats = occlusionCuller.getStats();
+                stats.occludedObjects += occlusionStats.occluded;
+                stats.occlusionTime += occlusionTime;
+                PROFILE_COUNTER("Occluded Models", double(occlusionStats.occluded));
+                PROFILE_COUNTER("Occluder Triangles", double(occlusionStats.triangles));
+                PROFILE_COUNTER("Occlusion ms", occlusionTime * 1000.0);
+            }
 
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTex);
+            // fully fogged models don't need their detail
+            float detailDistance = fogActive ? postProcess.fogEnd : 0.f;
+            int modelDraws = 0;
 
-        glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+            int *batchSizes = frameArena.allocateArray<int>(batchCount);
+            std::fill(batchSizes, batchSizes + batchCount, 0);
+            int *objectBatches = frameArena.allocateArray<int>(visibleCount); // -1 for the ones drawn on their own
 
-        glDepthMask(GL_TRUE);
-        glDepthFunc(GL_LESS);
+            for (int v = 0; v < visibleCount; v++)
+            {
+                int i = visibleModels[v];
+                const mat4 &transformMatrix = sceneTransforms.getWorldMatrix(i);
+                Model3D *model = objectModels[i];
+                stats.fullDetailTriangles += model->getTriangleCount();
+
+                // static objects go to their asset's batch
+                if (i >= dynamicCount)
+                {
+                    int lod = model->chooseLod(transformMatrix, currentCamera->getViewProjectionMatrix(), currentCamera->getProjectionMatrix(), detailDistance, objectLods[i]);
+                    objectLods[i] = uint8_t(lod);
+                    frameTriangles += model->getTriangleCount(lod);
+                    objectBatches[v] = objectAssets[i] * ModelSource::maxLods + lod;
+                    batchSizes[objectBatches[v]]++;
+                    continue;
+                }
+                objectBatches[v] = -1;
+
+                model->selectLod(transformMatrix, currentCamera->getViewProjectionMatrix(), currentCamera->getProjectionMatrix(), detailDistance);
+                frameTriangles += model->getTriangleCount(model->currentLod);
+
+                Shader &variant = sampleVariants.get(model->getShaderFeatures(sceneFeatures));
+                prepareProgram(variant);
+                model->draw(variant.shaderProgram, transformMatrix);
+                modelDraws++;
+            }
 
-        glUseProgram(sample.shaderProgram);
+            // every batch's transforms in one array, one run per batch in scene order
+            int *batchFirst = frameArena.allocateArray<int>(batchCount + 1);
+            batchFirst[0] = 0;
+            for (int batch = 0; batch < batchCount; batch++)
+                batchFirst[batch + 1] = batchFirst[batch] + batchSizes[batch];
 
-        unsigned int cameraPosLoc = glGetUniformLocation(sample.shaderProgram, "cameraPos");
-        glUniform3fv(cameraPosLoc, 1, glm::value_ptr(currentCamera->position));
+            mat4 *instanceTransforms = frameArena.allocateArray<mat4>(batchFirst[batchCount]);
+            std::fill(batchSizes, batchSizes + batchCount, 0); // counts back up while filling
+            for (int v = 0; v < visibleCount; v++)
+            {
+                int batch = objectBatches[v];
+                if (batch >= 0)
+                    instanceTransforms[batchFirst[batch] + batchSizes[batch]++] = sceneTransforms.getWorldMatrix(visibleModels[v]);
+            }
 
-        // update uniforms for both lights
-        directionLight->applyUniforms(sample.shaderProgram);
-        directionLight->applyExtraUniforms(sample.shaderProgram);
+            for (size_t asset = 0; asset < assetModels.size(); asset++)
+            {
+                for (int lod = 0; lod < ModelSource::maxLods; lod++)
+                {
+                    int batch = int(asset) * ModelSource::maxLods + lod;
+                    if (!batchSizes[batch])
+                        continue;
+
+                    Shader &variant = sampleVariants.get(assetModels[asset]->getShaderFeatures(sceneFeatures | feature::Instanced));
+                    prepareProgram(variant);
+                    assetModels[asset]->drawInstances(variant.shaderProgram, lod, instanceTransforms + batchFirst[batch], batchSizes[batch]);
+                    modelDraws++;
+                }
+            }
+            PROFILE_COUNTER("Visible Models", double(visibleCount));
+            PROFILE_COUNTER("Model Draws", double(modelDraws));
+        }
 
-        pointLight->applyUniforms(sample.shaderProgram);
-        pointLight->applyExtraUniforms(sample.shaderProgram);
+        // binocular target: the tree finds candidate boxes along the view ray, their triangle bvhs the exact hit
+        targetModel = -1;
+        if (usePerspectiveCamera && !useThirdPersonCamera)
+        {
+            PROFILE_SCOPE("Pick Target");
+            targetModel = sceneTree.raycast(firstPersonCamera->position, firstPersonCamera->direction, 1000.f, targetDistance,
+                                            [&](int model, float, float maxDistance)
+                                            {
+                float hitDistance;
+                if (model == 0 || !objectModels[model]->raycast(sceneTransforms.getWorldMatrix(model), firstPersonCamera->position, firstPersonCamera->direction, maxDistance, hitDistance))
+                    return -1.f; // the player's own tank is always in the way
+                return hitDistance; });
+        }
 
-        unsigned int projectionLoc = glGetUniformLocation(sample.shaderProgram, "projection");
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(currentCamera->generateProjectionMatrix()));
+        {
+            PROFILE_GPU_SCOPE_ALWAYS(postGpuZone, useDynamicResolution);
 
-        unsigned int viewLoc = glGetUniformLocation(sample.shaderProgram, "view");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(currentCamera->generateViewMatrix()));
+            // night vision for the first person camera, fog to limit view distance for the third person one
+            uint32_t postFeatures = 0;
+            if (!useThirdPersonCamera)
+                postFeatures |= PostProcess::NightVision;
+            else if (usePerspectiveCamera)
+                postFeatures |= PostProcess::Fog;
 
-        unsigned int usePerspectiveCameraLoc = glGetUniformLocation(sample.shaderProgram, "usePerspectiveCamera");
-        glUniform1i(usePerspectiveCameraLoc, usePerspectiveCamera);
+            postProcess.apply(postFeatures, glm::inverse(currentCamera->getProjectionMatrix()), float(frameStart));
+        }
 
-        unsigned int useThirdPersonCameraLoc = glGetUniformLocation(sample.shaderProgram, "useThirdPersonCamera");
-        glUniform1i(useThirdPersonCameraLoc, useThirdPersonCamera);
+        // scene + post gpu time decides the next frame's resolution. results arrive a few frames late,
+        // only act when the post zone (the last one each frame) brings a new one
+        double gpuMilliseconds = skyboxGpuZone.lastMilliseconds + terrainGpuZone.lastMilliseconds + modelsGpuZone.lastMilliseconds + postGpuZone.lastMilliseconds;
+        if (useDynamicResolution && postGpuZone.resultCount != lastGpuResult)
+        {
+            lastGpuResult = postGpuZone.resultCount;
+            postProcess.renderScale = dynamicResolution.update(gpuMilliseconds);
+        }
+        PROFILE_COUNTER("Render Scale %", postProcess.renderScale * 100.0);
+        PROFILE_COUNTER("GPU ms", gpuMilliseconds);
 
-        // Draw
-        player->draw(sample.shaderProgram);
-        // amogus.draw(sample.shaderProgram);
-        fictionalTank.draw(sample.shaderProgram);
-        genericTank.draw(sample.shaderProgram);
-        ozelot.draw(sample.shaderProgram);
-        sherman.draw(sample.shaderProgram);
-        t90broken.draw(sample.shaderProgram);
-        deadTree.draw(sample.shaderProgram);
+        // live readout in the title bar, a few times a second so it stays readable
+        if (frameStart - titleTime >= 0.25)
+        {
+            char target[64] = "";
+            if (targetModel >= 0)
+                snprintf(target, sizeof(target), " | target %s %.0f m", sceneFile.assets[objectAssets[targetModel]].name.c_str(), targetDistance);
+
+            char title[224];
+            snprintf(title, sizeof(title), "%s | %dx%d (%d%%) | gpu %.1f ms (avg %.1f) | %lldk tris%s", windowTitle,
+                     postProcess.getSceneWidth(), postProcess.getSceneHeight(), int(postProcess.renderScale * 100.f + 0.5f),
+                     gpuMilliseconds, dynamicResolution.getAverageMilliseconds(), frameTriangles / 1000, target);
+            glfwSetWindowTitle(window, title);
+            titleTime = frameStart;
+        }
 
+        stats.renderTime += glfwGetTime() - renderStart;
+        stats.frames++;
+        stats.triangles += frameTriangles;
+        PROFILE_COUNTER("Triangles", double(frameTriangles));
 
-        plane->draw(sample.shaderProgram);
+        // report update vs render cost every few seconds
+        if (frameStart - statsTime >= 5.0)
+        {
+            simulation.takeStats(stats.updateTime, stats.ticks);
+
+            std::cout << "update: " << stats.averageUpdateMs() << " ms/tick, render: " << stats.averageRenderMs() << " ms/frame, "
+                      << stats.frames / (frameStart - statsTime) << " fps, " << stats.averageTriangles() << " triangles/frame ("
+                      << stats.averageFullDetailTriangles() << " at full detail)";
+            if (useOcclusionCulling)
+                std::cout << ", " << stats.averageOccluded() << " occluded models/frame (" << stats.averageOcclusionMs() << " ms culling)";
+            if (profiling::isTrackingAllocations())
+                std::cout << ", " << stats.averageAllocations() << " heap allocations/frame (" << stats.steadyAllocations << " in steady frames)";
+            std::cout << std::endl;
+            stats.reset();
+            statsTime = frameStart;
+        }
 
         /* Swap front and back buffers */
-        glfwSwapBuffers(window);
+        {
+            PROFILE_SCOPE("Swap");
+            PROFILE_GPU_SCOPE(swapGpuZone);
+            glfwSwapBuffers(window);
+        }
 
         /* Poll for and process events */
         glfwPollEvents();
+
+        // anything about the setup that changed starts the wait for a steady frame over
+        uint64_t setup = uint64_t(uint32_t(framebufferWidth)) << 32 | uint64_t(uint32_t(framebufferHeight)) << 2 |
+                         (usePerspectiveCamera ? 1u : 0u) | (useThirdPersonCamera ? 2u : 0u);
+        size_t variantCount = sampleVariants.getVariantCount() + terrainVariants.getVariantCount() + postProcess.shaders.getVariantCount();
+        if (setup != lastSetup || variantCount != lastVariantCount)
+        {
+            steadyFrames = 0;
+            lastSetup = setup;
+            lastVariantCount = variantCount;
+        }
+        else
+            steadyFrames++;
+
+        // the offenders printed their call stacks as they happened (debug builds)
+        uint64_t offending = noAllocations.getOffending();
+        stats.allocations += frameHeap.get().allocations;
+        stats.steadyAllocations += offending;
+        assert((!assertNoFrameAllocations || !offending) && "heap allocation in a steady state frame");
+    }
+
+    simulation.stop();
+    delete simulationGround;
+    delete collisionWorld;
+    shaderWatcher.stop();
+    modelReloader.stop();
+    terrain.clear();
+    for (Model3D *model : assetModels)
+    {
+        if (model != player)
+            delete model;
     }
+    delete jobSystem;
+    assets::AssetArchive::get().close();
 
     glfwTerminate();
     return 0;
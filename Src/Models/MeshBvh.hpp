@@ -0,0 +1,449 @@
+#ifndef MESH_BVH_HPP
+#define MESH_BVH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace model
+{
+    using namespace glm;
+
+    // 32 bytes, two to a cache line. children of an internal node sit next to each other
+    struct BvhNode
+    {
+        vec3 minBounds;
+        int32_t leftOrFirst; // left child (the right one follows it) or the first triangle of a leaf
+        vec3 maxBounds;
+        int32_t triangleCount; // 0 for internal nodes
+    };
+    static_assert(sizeof(BvhNode) == 32, "BvhNode should stay 32 bytes");
+
+    // triangle bounding volume hierarchy of one mesh for exact ray and segment queries in object space
+    // (picking, line of sight). built top down with a binned surface area heuristic, triangles are copied
+    // out in leaf order so a leaf's are contiguous. the result can be cached on disk next to the shader cache
+    class MeshBvh
+    {
+    public:
+        static constexpr int binCount = 12;
+        static constexpr int maxLeafTriangles = 4;
+
+        std::vector<BvhNode> nodes;
+        std::vector<vec3> vertices; // three per triangle, in leaf order
+
+    public:
+        // triangles from interleaved vertex data (position first), vertexCount consecutive vertices from first
+        void build(const float *vertexData, int attributesSize, int first, int vertexCount)
+        {
+            int triangleCount = vertexCount / 3;
+            nodes.clear();
+            vertices.clear();
+            if (triangleCount == 0)
+                return;
+
+            std::vector<vec3> source(size_t(triangleCount) * 3);
+            for (int i = 0; i < triangleCount * 3; i++)
+            {
+                const float *position = vertexData + size_t(first + i) * attributesSize;
+                source[i] = vec3(position[0], position[1], position[2]);
+            }
+
+            std::vector<BuildTriangle> triangles(triangleCount);
+            for (int i = 0; i < triangleCount; i++)
+            {
+                BuildTriangle &triangle = triangles[i];
+                triangle.minBounds = min(source[i * 3], min(source[i * 3 + 1], source[i * 3 + 2]));
+                triangle.maxBounds = max(source[i * 3], max(source[i * 3 + 1], source[i * 3 + 2]));
+                triangle.centroid = (triangle.minBounds + triangle.maxBounds) * 0.5f;
+                triangle.index = i;
+            }
+
+            nodes.reserve(size_t(triangleCount) * 2);
+            nodes.push_back(BvhNode());
+            subdivide(0, triangles, 0, triangleCount);
+
+            vertices.resize(source.size());
+            for (int i = 0; i < triangleCount; i++)
+            {
+                int from = triangles[i].index * 3;
+                vertices[i * 3] = source[from];
+                vertices[i * 3 + 1] = source[from + 1];
+                vertices[i * 3 + 2] = source[from + 2];
+            }
+        }
+
+        bool empty() const { return nodes.empty(); }
+        int getTriangleCount() const { return int(vertices.size() / 3); }
+
+        // the count biggest triangles (three vertices each, in no particular order) into out
+        void getLargestTriangles(int count, std::vector<vec3> &out) const
+        {
+            int triangleCount = getTriangleCount();
+            count = std::min(count, triangleCount);
+            std::vector<std::pair<float, int>> areas(triangleCount);
+            for (int i = 0; i < triangleCount; i++)
+            {
+                const vec3 *corners = &vertices[size_t(i) * 3];
+                areas[i] = {length(cross(corners[1] - corners[0], corners[2] - corners[0])), i};
+            }
+            if (count < triangleCount)
+                std::nth_element(areas.begin(), areas.begin() + count, areas.end(), std::greater<std::pair<float, int>>());
+
+            out.reserve(out.size() + size_t(count) * 3);
+            for (int i = 0; i < count; i++)
+            {
+                const vec3 *corners = &vertices[size_t(areas[i].second) * 3];
+                out.insert(out.end(), corners, corners + 3);
+            }
+        }
+
+        // nearest hit along origin + direction * t, t in [0, maxDistance]. direction doesn't need to be
+        // normalised, t is in its units (so a world ray moved into object space keeps world distances)
+        bool raycast(const vec3 &origin, const vec3 &direction, float maxDistance, float &hitDistance, int *hitTriangle = nullptr) const
+        {
+            return traverse(origin, direction, maxDistance, hitDistance, hitTriangle, false);
+        }
+
+        // true if anything is between start and end, stops at the first triangle it finds
+        bool intersectsSegment(const vec3 &start, const vec3 &end) const
+        {
+            float hitDistance;
+            return traverse(start, end - start, 1.f, hitDistance, nullptr, true);
+        }
+
+        // moller-trumbore, t or FLT_MAX. both sides count so open and inside-out meshes still get hit
+        static float intersectTriangle(const vec3 &origin, const vec3 &direction, const vec3 &a, const vec3 &b, const vec3 &c)
+        {
+            vec3 edge1 = b - a;
+            vec3 edge2 = c - a;
+            vec3 p = cross(direction, edge2);
+            float determinant = dot(edge1, p);
+            if (std::abs(determinant) < 1e-12f)
+                return FLT_MAX;
+
+            float inverse = 1.f / determinant;
+            vec3 offset = origin - a;
+            float u = dot(offset, p) * inverse;
+            if (u < 0.f || u > 1.f)
+                return FLT_MAX;
+
+            vec3 q = cross(offset, edge1);
+            float v = dot(direction, q) * inverse;
+            if (v < 0.f || u + v > 1.f)
+                return FLT_MAX;
+
+            float t = dot(edge2, q) * inverse;
+            return t >= 0.f ? t : FLT_MAX;
+        }
+
+        // the cache is keyed by a hash of the triangles it was built from, so stale files are rebuilt
+        static uint64_t hashPositions(const float *vertexData, int attributesSize, int first, int vertexCount)
+        {
+            uint64_t h = 14695981039346656037ull;
+            for (int i = first; i < first + vertexCount; i++)
+            {
+                const unsigned char *bytes = (const unsigned char *)(vertexData + size_t(i) * attributesSize);
+                for (size_t b = 0; b < sizeof(float) * 3; b++)
+                {
+                    h ^= bytes[b];
+                    h *= 1099511628211ull;
+                }
+            }
+            return h;
+        }
+
+        bool load(const std::string &path, uint64_t sourceHash)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+                return false;
+
+            uint32_t fileMagic = 0, nodeCount = 0, vertexCount = 0;
+            uint64_t fileHash = 0;
+            file.read((char *)&fileMagic, sizeof(fileMagic));
+            file.read((char *)&fileHash, sizeof(fileHash));
+            file.read((char *)&nodeCount, sizeof(nodeCount));
+            file.read((char *)&vertexCount, sizeof(vertexCount));
+            if (!file || fileMagic != magic || fileHash != sourceHash || nodeCount == 0)
+                return false;
+
+            nodes.resize(nodeCount);
+            vertices.resize(vertexCount);
+            file.read((char *)nodes.data(), nodeCount * sizeof(BvhNode));
+            file.read((char *)vertices.data(), vertexCount * sizeof(vec3));
+            if (!file || !isValid())
+            {
+                nodes.clear();
+                vertices.clear();
+                return false;
+            }
+            return true;
+        }
+
+        void save(const std::string &path, uint64_t sourceHash) const
+        {
+            std::error_code error;
+            std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+            // temp file first so a crash never leaves half a cache behind, named per save so two loads writing
+            // the same cache at once don't share one
+            static std::atomic<uint32_t> saveCount{0};
+            std::string tempPath = path + ".tmp" + std::to_string(saveCount++);
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                uint32_t nodeCount = uint32_t(nodes.size()), vertexCount = uint32_t(vertices.size());
+                file.write((const char *)&magic, sizeof(magic));
+                file.write((const char *)&sourceHash, sizeof(sourceHash));
+                file.write((const char *)&nodeCount, sizeof(nodeCount));
+                file.write((const char *)&vertexCount, sizeof(vertexCount));
+                file.write((const char *)nodes.data(), nodeCount * sizeof(BvhNode));
+                file.write((const char *)vertices.data(), vertexCount * sizeof(vec3));
+                if (!file)
+                {
+                    std::cout << "couldn't write bvh cache " << path << std::endl;
+                    return;
+                }
+            }
+            std::filesystem::rename(tempPath, path, error);
+        }
+
+        // every child and triangle index inside nodes and vertices, children after their parent so traversal
+        // can't loop. anything read back from disk goes through this before it's used
+        bool isValid() const
+        {
+            if (nodes.empty() || vertices.size() % 3)
+                return false;
+
+            size_t triangleCount = vertices.size() / 3;
+            for (size_t i = 0; i < nodes.size(); i++)
+            {
+                const BvhNode &node = nodes[i];
+                if (node.leftOrFirst < 0 || node.triangleCount < 0)
+                    return false;
+                if (node.triangleCount == 0)
+                {
+                    if (size_t(node.leftOrFirst) <= i || size_t(node.leftOrFirst) + 1 >= nodes.size())
+                        return false;
+                }
+                else if (size_t(node.leftOrFirst) + size_t(node.triangleCount) > triangleCount)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        static constexpr uint32_t magic = 0x31485642; // "BVH1"
+
+        struct BuildTriangle
+        {
+            vec3 minBounds;
+            vec3 maxBounds;
+            vec3 centroid;
+            int index;
+        };
+
+        static float area(const vec3 &minBounds, const vec3 &maxBounds)
+        {
+            vec3 size = maxBounds - minBounds;
+            return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        void subdivide(int nodeIndex, std::vector<BuildTriangle> &triangles, int first, int count)
+        {
+            vec3 minBounds(FLT_MAX), maxBounds(-FLT_MAX), centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+            for (int i = first; i < first + count; i++)
+            {
+                minBounds = min(minBounds, triangles[i].minBounds);
+                maxBounds = max(maxBounds, triangles[i].maxBounds);
+                centroidMin = min(centroidMin, triangles[i].centroid);
+                centroidMax = max(centroidMax, triangles[i].centroid);
+            }
+
+            nodes[nodeIndex].minBounds = minBounds;
+            nodes[nodeIndex].maxBounds = maxBounds;
+            nodes[nodeIndex].leftOrFirst = first;
+            nodes[nodeIndex].triangleCount = count;
+
+            if (count <= maxLeafTriangles)
+                return;
+
+            // cheapest bin boundary over all three axes
+            float bestCost = FLT_MAX;
+            int bestAxis = -1;
+            int bestSplit = 0;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                float extent = centroidMax[axis] - centroidMin[axis];
+                if (extent <= 0.f)
+                    continue;
+
+                int counts[binCount] = {};
+                vec3 binMin[binCount], binMax[binCount];
+                for (int b = 0; b < binCount; b++)
+                {
+                    binMin[b] = vec3(FLT_MAX);
+                    binMax[b] = vec3(-FLT_MAX);
+                }
+
+                float scale = binCount / extent * 0.9999f;
+                for (int i = first; i < first + count; i++)
+                {
+                    int bin = int((triangles[i].centroid[axis] - centroidMin[axis]) * scale);
+                    counts[bin]++;
+                    binMin[bin] = min(binMin[bin], triangles[i].minBounds);
+                    binMax[bin] = max(binMax[bin], triangles[i].maxBounds);
+                }
+
+                float rightCost[binCount] = {};
+                vec3 sweepMin(FLT_MAX), sweepMax(-FLT_MAX);
+                int sweepCount = 0;
+                for (int b = binCount - 1; b > 0; b--)
+                {
+                    sweepCount += counts[b];
+                    sweepMin = min(sweepMin, binMin[b]);
+                    sweepMax = max(sweepMax, binMax[b]);
+                    rightCost[b] = sweepCount ? sweepCount * area(sweepMin, sweepMax) : -1.f;
+                }
+
+                sweepMin = vec3(FLT_MAX);
+                sweepMax = vec3(-FLT_MAX);
+                sweepCount = 0;
+                for (int b = 1; b < binCount; b++)
+                {
+                    sweepCount += counts[b - 1];
+                    sweepMin = min(sweepMin, binMin[b - 1]);
+                    sweepMax = max(sweepMax, binMax[b - 1]);
+                    if (!sweepCount || rightCost[b] < 0.f)
+                        continue;
+
+                    float cost = sweepCount * area(sweepMin, sweepMax) + rightCost[b];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestAxis = axis;
+                        bestSplit = b;
+                    }
+                }
+            }
+
+            // splitting has to beat testing every triangle here (traversal is about as expensive as a triangle)
+            float leafCost = count * area(minBounds, maxBounds);
+            if (bestAxis < 0 || bestCost + area(minBounds, maxBounds) >= leafCost)
+                return;
+
+            float boundary = centroidMin[bestAxis] + bestSplit / (binCount / (centroidMax[bestAxis] - centroidMin[bestAxis]) * 0.9999f);
+            int middle = int(std::partition(triangles.begin() + first, triangles.begin() + first + count, [&](const BuildTriangle &triangle)
+                                            { return triangle.centroid[bestAxis] < boundary; }) -
+                             triangles.begin());
+            if (middle == first || middle == first + count)
+                return;
+
+            int left = int(nodes.size());
+            nodes.push_back(BvhNode());
+            nodes.push_back(BvhNode());
+            nodes[nodeIndex].leftOrFirst = left;
+            nodes[nodeIndex].triangleCount = 0;
+
+            subdivide(left, triangles, first, middle - first);
+            subdivide(left + 1, triangles, middle, first + count - middle);
+        }
+
+        // slab test against the inverse direction, entry distance or FLT_MAX for a miss
+        static float boxEntry(const BvhNode &node, const vec3 &origin, const vec3 &inverseDirection, float maxDistance)
+        {
+            vec3 t1 = (node.minBounds - origin) * inverseDirection;
+            vec3 t2 = (node.maxBounds - origin) * inverseDirection;
+            vec3 entries = min(t1, t2);
+            vec3 exits = max(t1, t2);
+
+            float enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.f));
+            float leave = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+            return enter <= leave ? enter : FLT_MAX;
+        }
+
+        bool traverse(const vec3 &origin, const vec3 &direction, float maxDistance, float &hitDistance, int *hitTriangle, bool anyHit) const
+        {
+            hitDistance = maxDistance;
+            if (nodes.empty())
+                return false;
+
+            vec3 inverseDirection = 1.f / direction;
+            bool hit = false;
+
+            // deep enough for any tree the builder makes out of meshes we'd load. a deeper one (a degenerate mesh,
+            // a cache or archive from elsewhere) moves the stack to the heap rather than skip nodes
+            int fixedStack[64];
+            std::vector<int> grownStack;
+            int *stack = fixedStack;
+            int stackCapacity = 64, stackSize = 0;
+            auto push = [&](int node)
+            {
+                if (stackSize == stackCapacity)
+                {
+                    if (stack == fixedStack)
+                        grownStack.assign(fixedStack, fixedStack + stackSize);
+                    stackCapacity *= 2;
+                    grownStack.resize(stackCapacity);
+                    stack = grownStack.data();
+                }
+                stack[stackSize++] = node;
+            };
+
+            if (boxEntry(nodes[0], origin, inverseDirection, hitDistance) == FLT_MAX)
+                return false;
+            push(0);
+
+            while (stackSize)
+            {
+                const BvhNode &node = nodes[stack[--stackSize]];
+
+                if (node.triangleCount)
+                {
+                    for (int i = node.leftOrFirst; i < node.leftOrFirst + node.triangleCount; i++)
+                    {
+                        float t = intersectTriangle(origin, direction, vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
+                        if (t <= hitDistance)
+                        {
+                            hitDistance = t;
+                            hit = true;
+                            if (hitTriangle)
+                                *hitTriangle = i;
+                            if (anyHit)
+                                return true;
+                        }
+                    }
+                    continue;
+                }
+
+                // nearer child goes on top, the further one is dropped if a hit already beat its entry
+                int left = node.leftOrFirst;
+                float leftEntry = boxEntry(nodes[left], origin, inverseDirection, hitDistance);
+                float rightEntry = boxEntry(nodes[left + 1], origin, inverseDirection, hitDistance);
+                int nearChild = left, farChild = left + 1;
+                if (rightEntry < leftEntry)
+                {
+                    std::swap(leftEntry, rightEntry);
+                    std::swap(nearChild, farChild);
+                }
+
+                if (rightEntry != FLT_MAX)
+                    push(farChild);
+                if (leftEntry != FLT_MAX)
+                    push(nearChild);
+            }
+            return hit;
+        }
+    };
+} // namespace model
+
+#endif // !MESH_BVH_HPP
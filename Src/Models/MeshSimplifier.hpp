@@ -0,0 +1,361 @@
+#ifndef MESH_SIMPLIFIER_HPP
+#define MESH_SIMPLIFIER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+namespace model
+{
+    // quadric error metric simplification (garland & heckbert) using half-edge collapses: a vertex only
+    // ever merges onto one of its neighbours, so every output position and per-corner uv/normal index is
+    // one the input already had and the result can be written back out against the original obj data.
+    // no GL or glm, it runs offline from Tools/Simplify.cpp
+    class MeshSimplifier
+    {
+    public:
+        struct Triangle
+        {
+            uint32_t v[3];    // position indices
+            int texcoord[3];  // -1 when the mesh has none
+            int normal[3];    // -1 when the mesh has none
+        };
+
+        // extra weight on the planes that hold open edges in place, so holes and outlines don't shrink
+        double boundaryWeight = 1000.0;
+
+    private:
+        struct Vec3
+        {
+            double x, y, z;
+
+            Vec3 operator-(const Vec3 &o) const { return {x - o.x, y - o.y, z - o.z}; }
+            double dot(const Vec3 &o) const { return x * o.x + y * o.y + z * o.z; }
+            Vec3 cross(const Vec3 &o) const { return {y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x}; }
+            double length() const { return std::sqrt(dot(*this)); }
+        };
+
+        // symmetric 4x4 error matrix, upper triangle
+        struct Quadric
+        {
+            double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+            // squared distance to the plane ax + by + cz + d = 0 (unit normal), scaled by weight
+            void addPlane(double a, double b, double c, double d, double weight)
+            {
+                a2 += weight * a * a, ab += weight * a * b, ac += weight * a * c, ad += weight * a * d;
+                b2 += weight * b * b, bc += weight * b * c, bd += weight * b * d;
+                c2 += weight * c * c, cd += weight * c * d;
+                d2 += weight * d * d;
+            }
+
+            void add(const Quadric &o)
+            {
+                a2 += o.a2, ab += o.ab, ac += o.ac, ad += o.ad, b2 += o.b2, bc += o.bc, bd += o.bd, c2 += o.c2, cd += o.cd, d2 += o.d2;
+            }
+
+            double evaluate(const Vec3 &p) const
+            {
+                return a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x +
+                       b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y +
+                       c2 * p.z * p.z + 2 * cd * p.z + d2;
+            }
+        };
+
+        // collapse from onto to. stamps go stale when either end changes, then the entry is skipped
+        struct Candidate
+        {
+            double cost;
+            uint32_t from, to;
+            uint32_t fromStamp, toStamp;
+
+            bool operator<(const Candidate &o) const { return cost > o.cost; } // cheapest on top
+        };
+
+        std::vector<Vec3> positions;
+        std::vector<Triangle> triangles;
+        std::vector<bool> triangleAlive;
+        std::vector<Quadric> quadrics;
+        std::vector<std::vector<uint32_t>> vertexTriangles;
+        std::vector<uint32_t> stamps;
+        std::vector<bool> vertexAlive;
+        std::priority_queue<Candidate> candidates;
+        size_t liveTriangles = 0;
+        double maxError = 0.0;
+
+    public:
+        // positions are xyz triples
+        MeshSimplifier(const std::vector<float> &positionData, const std::vector<Triangle> &input)
+        {
+            for (size_t i = 0; i + 2 < positionData.size(); i += 3)
+                positions.push_back({positionData[i], positionData[i + 1], positionData[i + 2]});
+
+            quadrics.resize(positions.size());
+            vertexTriangles.resize(positions.size());
+            stamps.resize(positions.size(), 0);
+            vertexAlive.resize(positions.size(), true);
+
+            // degenerate input triangles are dropped up front, they only confuse the flip checks
+            for (const Triangle &triangle : input)
+            {
+                if (triangle.v[0] == triangle.v[1] || triangle.v[1] == triangle.v[2] || triangle.v[0] == triangle.v[2])
+                    continue;
+                if (triangle.v[0] >= positions.size() || triangle.v[1] >= positions.size() || triangle.v[2] >= positions.size())
+                    continue;
+                triangles.push_back(triangle);
+            }
+            triangleAlive.resize(triangles.size(), true);
+            liveTriangles = triangles.size();
+
+            std::unordered_map<uint64_t, int> edgeUses;
+            for (uint32_t t = 0; t < triangles.size(); t++)
+            {
+                const Triangle &triangle = triangles[t];
+                Vec3 normal = getNormal(triangle.v[0], triangle.v[1], triangle.v[2]);
+                double length = normal.length();
+
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    vertexTriangles[triangle.v[corner]].push_back(t);
+                    edgeUses[edgeKey(triangle.v[corner], triangle.v[(corner + 1) % 3])]++;
+                }
+
+                if (length <= 0.0)
+                    continue;
+
+                // area weighted so big faces hold their shape better than slivers
+                Vec3 n = {normal.x / length, normal.y / length, normal.z / length};
+                double d = -n.dot(positions[triangle.v[0]]);
+                for (int corner = 0; corner < 3; corner++)
+                    quadrics[triangle.v[corner]].addPlane(n.x, n.y, n.z, d, length * 0.5);
+            }
+
+            // open edges get a plane standing perpendicular on the face, pinning them
+            for (uint32_t t = 0; t < triangles.size(); t++)
+            {
+                const Triangle &triangle = triangles[t];
+                Vec3 normal = getNormal(triangle.v[0], triangle.v[1], triangle.v[2]);
+
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    uint32_t a = triangle.v[corner], b = triangle.v[(corner + 1) % 3];
+                    if (edgeUses[edgeKey(a, b)] != 1)
+                        continue;
+
+                    Vec3 edge = positions[b] - positions[a];
+                    Vec3 side = edge.cross(normal);
+                    double length = side.length();
+                    if (length <= 0.0)
+                        continue;
+
+                    Vec3 n = {side.x / length, side.y / length, side.z / length};
+                    double d = -n.dot(positions[a]);
+                    double weight = boundaryWeight * edge.dot(edge);
+                    quadrics[a].addPlane(n.x, n.y, n.z, d, weight);
+                    quadrics[b].addPlane(n.x, n.y, n.z, d, weight);
+                }
+            }
+
+            for (auto &edge : edgeUses)
+                pushEdge(uint32_t(edge.first >> 32), uint32_t(edge.first & 0xffffffff));
+        }
+
+        // collapse until at most targetCount triangles are left, or nothing more can go without folding the
+        // surface over. call again with a smaller target to continue from where it stopped
+        void simplify(size_t targetCount)
+        {
+            while (liveTriangles > targetCount && !candidates.empty())
+            {
+                Candidate candidate = candidates.top();
+                candidates.pop();
+
+                if (!vertexAlive[candidate.from] || !vertexAlive[candidate.to] ||
+                    stamps[candidate.from] != candidate.fromStamp || stamps[candidate.to] != candidate.toStamp)
+                    continue;
+
+                if (!canCollapse(candidate.from, candidate.to))
+                    continue;
+
+                collapse(candidate.from, candidate.to);
+                if (candidate.cost > maxError)
+                    maxError = candidate.cost;
+            }
+        }
+
+        size_t getTriangleCount() const { return liveTriangles; }
+
+        // largest quadric error accepted so far
+        double getMaxError() const { return maxError; }
+
+        std::vector<Triangle> getTriangles() const
+        {
+            std::vector<Triangle> result;
+            result.reserve(liveTriangles);
+            for (size_t t = 0; t < triangles.size(); t++)
+            {
+                if (triangleAlive[t])
+                    result.push_back(triangles[t]);
+            }
+            return result;
+        }
+
+    private:
+        static uint64_t edgeKey(uint32_t a, uint32_t b)
+        {
+            return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+        }
+
+        Vec3 getNormal(uint32_t a, uint32_t b, uint32_t c) const
+        {
+            return (positions[b] - positions[a]).cross(positions[c] - positions[a]);
+        }
+
+        // queue whichever direction of the edge is cheaper
+        void pushEdge(uint32_t a, uint32_t b)
+        {
+            Quadric sum = quadrics[a];
+            sum.add(quadrics[b]);
+
+            double toB = sum.evaluate(positions[b]);
+            double toA = sum.evaluate(positions[a]);
+            if (toB <= toA)
+                candidates.push({std::max(toB, 0.0), a, b, stamps[a], stamps[b]});
+            else
+                candidates.push({std::max(toA, 0.0), b, a, stamps[b], stamps[a]});
+        }
+
+        void collectNeighbours(uint32_t v, std::vector<uint32_t> &out) const
+        {
+            out.clear();
+            for (uint32_t t : vertexTriangles[v])
+            {
+                if (!triangleAlive[t])
+                    continue;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    uint32_t n = triangles[t].v[corner];
+                    if (n != v && std::find(out.begin(), out.end(), n) == out.end())
+                        out.push_back(n);
+                }
+            }
+        }
+
+        static bool contains(const Triangle &triangle, uint32_t v)
+        {
+            return triangle.v[0] == v || triangle.v[1] == v || triangle.v[2] == v;
+        }
+
+        bool canCollapse(uint32_t from, uint32_t to)
+        {
+            // link condition: the two ends may only share the vertices opposite the edge, anything else would pinch the mesh
+            int sharedTriangles = 0;
+            for (uint32_t t : vertexTriangles[from])
+            {
+                if (triangleAlive[t] && contains(triangles[t], to))
+                    sharedTriangles++;
+            }
+            if (sharedTriangles == 0)
+                return false;
+
+            std::vector<uint32_t> fromNeighbours, toNeighbours;
+            collectNeighbours(from, fromNeighbours);
+            collectNeighbours(to, toNeighbours);
+            int shared = 0;
+            for (uint32_t n : fromNeighbours)
+            {
+                if (std::find(toNeighbours.begin(), toNeighbours.end(), n) != toNeighbours.end())
+                    shared++;
+            }
+            if (shared > sharedTriangles)
+                return false;
+
+            // none of the triangles that stay may flip over or collapse to nothing
+            for (uint32_t t : vertexTriangles[from])
+            {
+                if (!triangleAlive[t] || contains(triangles[t], to))
+                    continue;
+
+                uint32_t v[3] = {triangles[t].v[0], triangles[t].v[1], triangles[t].v[2]};
+                Vec3 before = getNormal(v[0], v[1], v[2]);
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    if (v[corner] == from)
+                        v[corner] = to;
+                }
+                Vec3 after = getNormal(v[0], v[1], v[2]);
+
+                double afterLength = after.length();
+                if (afterLength <= 1e-12 || before.dot(after) <= 0.2 * before.length() * afterLength)
+                    return false;
+            }
+
+            return true;
+        }
+
+        void collapse(uint32_t from, uint32_t to)
+        {
+            // corner attributes on either end of the edge, so corners on the same side of any uv seam follow along
+            int fromTexcoord = -1, fromNormal = -1, toTexcoord = -1, toNormal = -1;
+            for (uint32_t t : vertexTriangles[from])
+            {
+                if (!triangleAlive[t] || !contains(triangles[t], to))
+                    continue;
+
+                Triangle &triangle = triangles[t];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    if (triangle.v[corner] == from)
+                        fromTexcoord = triangle.texcoord[corner], fromNormal = triangle.normal[corner];
+                    if (triangle.v[corner] == to)
+                        toTexcoord = triangle.texcoord[corner], toNormal = triangle.normal[corner];
+                }
+
+                triangleAlive[t] = false;
+                liveTriangles--;
+            }
+
+            for (uint32_t t : vertexTriangles[from])
+            {
+                if (!triangleAlive[t])
+                    continue;
+
+                Triangle &triangle = triangles[t];
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    if (triangle.v[corner] != from)
+                        continue;
+
+                    triangle.v[corner] = to;
+                    if (triangle.texcoord[corner] == fromTexcoord && triangle.normal[corner] == fromNormal)
+                    {
+                        triangle.texcoord[corner] = toTexcoord;
+                        triangle.normal[corner] = toNormal;
+                    }
+                }
+                vertexTriangles[to].push_back(t);
+            }
+
+            vertexAlive[from] = false;
+            vertexTriangles[from].clear();
+            quadrics[to].add(quadrics[from]);
+
+            // drop dead triangles from the survivor's list now and then so it doesn't keep growing
+            std::vector<uint32_t> &list = vertexTriangles[to];
+            list.erase(std::remove_if(list.begin(), list.end(), [this](uint32_t t)
+                                      { return !triangleAlive[t]; }),
+                       list.end());
+
+            // everything queued for the survivor is out of date
+            stamps[to]++;
+            std::vector<uint32_t> neighbours;
+            collectNeighbours(to, neighbours);
+            for (uint32_t n : neighbours)
+                pushEdge(to, n);
+        }
+    };
+} // namespace model
+
+#endif // !MESH_SIMPLIFIER_HPP
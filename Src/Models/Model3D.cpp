@@ -4,133 +4,82 @@ using namespace model;
 using namespace glm;
 
 // insert constructor variables into attributes
-Model3D::Model3D(std::string modelPath, std::string texturePath, std::string normalPath, vec3 color, vec3 pos, vec3 rot, vec3 sca) : color(color), position(pos), rotation(rot), scale(sca)
+Model3D::Model3D(std::string modelPath, std::string texturePath, std::string normalPath, vec3 color, vec3 pos, vec3 rot, vec3 sca) : position(pos), orientation(gd::Orientation::fromEuler(rot)), scale(sca), color(color), previousPosition(pos), previousOrientation(orientation.value)
 {
-    // std::string path = "Models/djSword.obj";
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> material;
-    std::string warning, error;
-    tinyobj::attrib_t attributes;
-    bool success;
-
-    if (!modelPath.empty())
-    {
-        success = tinyobj::LoadObj(
-            &attributes,
-            &shapes,
-            &material,
-            &warning,
-            &error,
-            modelPath.c_str());
+    ModelSource source(modelPath, texturePath, normalPath);
+    source.load();
+    upload(source);
+}
 
-        if (!warning.empty())
-            std::cout << warning << std::endl;
+Model3D::Model3D(ModelSource &source, vec3 color, vec3 pos, vec3 rot, vec3 sca) : position(pos), orientation(gd::Orientation::fromEuler(rot)), scale(sca), color(color), previousPosition(pos), previousOrientation(orientation.value)
+{
+    upload(source);
+}
 
-        if (!error.empty())
-            std::cout << error << std::endl;
+// send an already loaded source to the GPU, GL thread only
+void Model3D::upload(ModelSource &source)
+{
+    PROFILE_SCOPE("Upload Model");
 
-        std::cout << "success: " << success << std::endl;
-    }
-    else
-        std::cout << "Error empty model path!" << std::endl;
+    uploadMesh(source);
+    texture = uploadTexture(source.texture, GL_TEXTURE0);
+    normalTexture = uploadTexture(source.normal, GL_TEXTURE1);
+    updateMaterialFeatures();
+}
 
-    if (success)
+// swap in the parts a hot reload loaded, keeping what we had for any that didn't load (e.g. a broken save)
+bool Model3D::reload(ModelSource &source)
+{
+    PROFILE_SCOPE("Reload Model");
+
+    bool swapped = false;
+    if (source.parts & ModelSource::MeshPart)
     {
-        // std::cout << "attributes size: " << attributes. << std::endl;
-        attributesSize = 3;
+        if (source.success)
+        {
+            // the instance attributes lived on the old VAO, drawInstances sets them up again
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &VBO);
+            glDeleteBuffers(1, &instanceVBO);
+            VAO = VBO = instanceVBO = 0;
+            uploadMesh(source);
+            swapped = true;
+        }
+        else
+            std::cout << "keeping the old mesh of " << source.modelPath << std::endl;
+    }
+    if (source.parts & ModelSource::TexturePart)
+        swapped = replaceTexture(texture, source.texture, GL_TEXTURE0) || swapped;
+    if (source.parts & ModelSource::NormalPart)
+        swapped = replaceTexture(normalTexture, source.normal, GL_TEXTURE1) || swapped;
 
-        if (!attributes.normals.empty())
-            attributesSize += 3;
+    updateMaterialFeatures();
+    return swapped;
+}
 
-        std::vector<glm::vec3> tangents;
-        std::vector<glm::vec3> bitangents;
-        if (!attributes.texcoords.empty())
-        {
-            attributesSize += 8;
-
-            for (size_t i = 0; i < shapes[0].mesh.indices.size(); i += 3)
-            {
-                tinyobj::index_t vData1 = shapes[0].mesh.indices[i];
-                tinyobj::index_t vData2 = shapes[0].mesh.indices[i + 1];
-                tinyobj::index_t vData3 = shapes[0].mesh.indices[i + 2];
-
-                glm::vec3 v1 = glm::vec3(
-                    attributes.vertices[vData1.vertex_index * 3],
-                    attributes.vertices[vData1.vertex_index * 3 + 1],
-                    attributes.vertices[vData1.vertex_index * 3 + 2]);
-
-                glm::vec3 v2 = glm::vec3(
-                    attributes.vertices[vData2.vertex_index * 3],
-                    attributes.vertices[vData2.vertex_index * 3 + 1],
-                    attributes.vertices[vData2.vertex_index * 3 + 2]);
-
-                glm::vec3 v3 = glm::vec3(
-                    attributes.vertices[vData3.vertex_index * 3],
-                    attributes.vertices[vData3.vertex_index * 3 + 1],
-                    attributes.vertices[vData3.vertex_index * 3 + 2]);
-
-                glm::vec2 uv1 = glm::vec2(
-                    attributes.texcoords[vData1.texcoord_index * 2],
-                    attributes.texcoords[vData1.texcoord_index * 2 + 1]);
-
-                glm::vec2 uv2 = glm::vec2(
-                    attributes.texcoords[vData2.texcoord_index * 2],
-                    attributes.texcoords[vData2.texcoord_index * 2 + 1]);
-
-                glm::vec2 uv3 = glm::vec2(
-                    attributes.texcoords[vData3.texcoord_index * 2],
-                    attributes.texcoords[vData3.texcoord_index * 2 + 1]);
-
-                glm::vec3 deltaPos1 = v2 - v1;
-                glm::vec3 deltaPos2 = v3 - v1;
-
-                glm::vec2 deltaUV1 = uv2 - uv1;
-                glm::vec2 deltaUV2 = uv3 - uv1;
-
-                float r = 1.f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
-                glm::vec3 tangent = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y) * r;
-                glm::vec3 bitangent = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x) * r;
-
-                tangents.push_back(tangent);
-                tangents.push_back(tangent);
-                tangents.push_back(tangent);
-
-                bitangents.push_back(bitangent);
-                bitangents.push_back(bitangent);
-                bitangents.push_back(bitangent);
-            }
-        }   
-
-        for (size_t i = 0; i < shapes.at(0).mesh.indices.size(); i++)
+void Model3D::uploadMesh(ModelSource &source)
+{
+    attributesSize = source.attributesSize;
+    vertexCount = source.attributesSize ? int(source.getFloatCount()) / source.attributesSize : 0;
+
+    lodCount = 1;
+    lodFirst[0] = 0;
+    lodVertexCount[0] = vertexCount;
+    if (!source.lodVertexCount.empty())
+    {
+        lodCount = std::min(int(source.lodVertexCount.size()), ModelSource::maxLods);
+        for (int i = 0; i < lodCount; i++)
         {
-            // std::cout << "for loop" << i << std::endl;
-            tinyobj::index_t vData = shapes.at(0).mesh.indices.at(i);
-            vertexData.push_back(attributes.vertices.at((vData.vertex_index * 3)));
-            vertexData.push_back(attributes.vertices.at((vData.vertex_index * 3) + 1));
-            vertexData.push_back(attributes.vertices.at((vData.vertex_index * 3) + 2));
-
-            if (!attributes.normals.empty())
-            {
-                vertexData.push_back(attributes.normals.at((vData.normal_index * 3)));
-                vertexData.push_back(attributes.normals.at((vData.normal_index * 3) + 1));
-                vertexData.push_back(attributes.normals.at((vData.normal_index * 3) + 2));
-            }
-
-            if (!attributes.texcoords.empty())
-            {
-                vertexData.push_back(attributes.texcoords.at((vData.texcoord_index * 2)));
-                vertexData.push_back(attributes.texcoords.at((vData.texcoord_index * 2) + 1));
-            }
-
-            vertexData.push_back(tangents.at(i).x);
-            vertexData.push_back(tangents[i].y);
-            vertexData.push_back(tangents[i].z);
-            vertexData.push_back(bitangents[i].x);
-            vertexData.push_back(bitangents[i].y);
-            vertexData.push_back(bitangents[i].z);
+            lodFirst[i] = source.lodFirst[i];
+            lodVertexCount[i] = source.lodVertexCount[i];
         }
-        std::cout << "end for loop" << std::endl;
+        vertexCount = lodVertexCount[0];
+    }
+    minBounds = source.minBounds;
+    maxBounds = source.maxBounds;
 
+    if (source.success)
+    {
         // initialize VAO and VBO
         glGenVertexArrays(1, &VAO);
         std::cout << "end gen array" << std::endl;
@@ -145,8 +94,8 @@ Model3D::Model3D(std::string modelPath, std::string texturePath, std::string nor
 
         glBufferData(
             GL_ARRAY_BUFFER,
-            sizeof(GLfloat) * vertexData.size(),
-            vertexData.data(),
+            sizeof(GLfloat) * source.getFloatCount(),
+            source.getVertices(), // straight from the archive's mapped pages when it was packed
             // attributes.vertices.data(),
             GL_DYNAMIC_DRAW);
 
@@ -161,7 +110,7 @@ Model3D::Model3D(std::string modelPath, std::string texturePath, std::string nor
         glEnableVertexAttribArray(0);
         std::cout << "end attrib pointer 0" << std::endl;
 
-        if (!attributes.normals.empty())
+        if (source.hasNormals)
         {
             GLintptr normalsPtr = 3 * sizeof(float);
             glVertexAttribPointer(
@@ -175,7 +124,7 @@ Model3D::Model3D(std::string modelPath, std::string texturePath, std::string nor
             std::cout << "end normals attrib pointer" << std::endl;
         }
 
-        if (!attributes.texcoords.empty())
+        if (source.hasTexcoords)
         {
             GLintptr uvPtr = (attributesSize - 8) * sizeof(float);
             glVertexAttribPointer(
@@ -211,97 +160,253 @@ Model3D::Model3D(std::string modelPath, std::string texturePath, std::string nor
 
         std::cout << "loaded model" << std::endl;
     }
-    else
-        std::cout << "Error loading object file!" << std::endl;
-
-    if (!texturePath.empty())
-    {
-        // texture mapping
-        int img_width, img_height, colorChannels;
-        stbi_set_flip_vertically_on_load(true); // flip da image
-        unsigned char *tex_bytes = stbi_load(texturePath.c_str(), &img_width, &img_height, &colorChannels, 0);
-
-        // GLuint texture;
-        glGenTextures(1, &texture);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-
-        // check if the image is a .png or .jpg
-        if (texturePath.find("png") != std::string::npos)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img_width, img_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex_bytes);
-        else if (texturePath.find("jpg") != std::string::npos)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, img_width, img_height, 0, GL_RGB, GL_UNSIGNED_BYTE, tex_bytes);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        // generate MIPMAPS! (arent they the little image duplicates for when it gets far away??)
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        // Free loaded bytes
-        stbi_image_free(tex_bytes);
-        glEnable(GL_DEPTH_TEST);
-
-        std::cout << "loaded texture" << std::endl;
-    }
 
-    if (!normalPath.empty())
-    {
-        // texture mapping
-        int img_width, img_height, colorChannels;
-        stbi_set_flip_vertically_on_load(true); // flip da image
-        unsigned char *normTextureBytes = stbi_load(normalPath.c_str(), &img_width, &img_height, &colorChannels, 0);
+    bvh = std::move(source.bvh);
 
-        // GLuint texture;
-        glGenTextures(1, &normalTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normalTexture);
-
-        if (normalPath.find("png") != std::string::npos)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, img_width, img_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, normTextureBytes);
-        else if (normalPath.find("jpg") != std::string::npos)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, img_width, img_height, 0, GL_RGB, GL_UNSIGNED_BYTE, normTextureBytes);
+    // the culler draws the biggest of the full mesh's own triangles, as many as the coarsest lod has. a simplified
+    // lod bulges past the real surface in places and would hide things that show, part of the real surface can't
+    occluderVertices.clear();
+    if (source.success)
+        bvh.getLargestTriangles(lodVertexCount[lodCount - 1] / 3, occluderVertices);
+    hasNormals = source.success && source.hasNormals;
+    hasTexcoords = source.success && source.hasTexcoords;
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+void Model3D::updateMaterialFeatures()
+{
+    // textures are useless without uvs, and the normal map also needs the tangent frame built from normals
+    materialFeatures = 0;
+    if (texture && hasTexcoords)
+        materialFeatures |= shader::feature::Texture;
+    if (normalTexture && hasNormals && hasTexcoords)
+        materialFeatures |= shader::feature::NormalMap;
+}
 
-        // generate MIPMAPS! (arent they the little image duplicates for when it gets far away??)
-        glGenerateMipmap(GL_TEXTURE_2D);
+// the old texture only goes once the new one uploaded
+bool Model3D::replaceTexture(GLuint &current, ImageData &image, GLenum unit)
+{
+    GLuint replacement = uploadTexture(image, unit);
+    if (!replacement)
+        return false;
 
-        // Free loaded bytes
-        stbi_image_free(normTextureBytes);
-        glEnable(GL_DEPTH_TEST);
+    glDeleteTextures(1, &current);
+    current = replacement;
+    return true;
+}
 
-        std::cout << "loaded texture" << std::endl;
-    }
+GLuint Model3D::uploadTexture(ImageData &image, GLenum unit)
+{
+    if (!image.bytes)
+        return 0;
+
+    GLuint textureId;
+    glGenTextures(1, &textureId);
+    glActiveTexture(unit);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+
+    // 4 channels for png with alpha, 3 for jpg
+    if (image.channels == 4)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.bytes);
+    else if (image.channels == 3)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.bytes);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // generate MIPMAPS! (arent they the little image duplicates for when it gets far away??)
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Free loaded bytes
+    ModelSource::freeImage(image);
+    glEnable(GL_DEPTH_TEST);
+
+    std::cout << "loaded texture" << std::endl;
+    return textureId;
 }
 
 Model3D::~Model3D()
 {
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteTextures(1, &texture);
+    glDeleteTextures(1, &normalTexture);
 }
 
-void Model3D::draw(GLuint &shaderProgram)
+void Model3D::storePreviousTransform()
 {
-    glUseProgram(shaderProgram);
+    previousPosition = position;
+    previousOrientation = orientation.value;
+}
+
+vec3 Model3D::getInterpolatedPosition(float alpha)
+{
+    return mix(previousPosition, position, alpha);
+}
+
+quat Model3D::getInterpolatedOrientation(float alpha)
+{
+    return gd::Orientation::blend(previousOrientation, orientation.value, alpha);
+}
+
+mat4 Model3D::getTransformMatrix(float alpha)
+{
+    // the current tick's basis is already there, only blended frames build one
+    if (alpha >= 1.f)
+        return orientation.toTransform(position, scale);
+    return buildTransform(getInterpolatedPosition(alpha), getInterpolatedOrientation(alpha), scale);
+}
+
+mat4 Model3D::buildTransform(vec3 pos, vec3 rot, vec3 sca)
+{
+    return gd::Orientation::fromEuler(rot).toTransform(pos, sca);
+}
+
+mat4 Model3D::buildTransform(vec3 pos, const quat &orientation, vec3 sca)
+{
+    // generate a transformation matrix (translate * scale * rotate) straight from the rotation's basis
+    return gd::Orientation(orientation).toTransform(pos, sca);
+}
+
+void Model3D::getWorldBounds(vec3 &worldMin, vec3 &worldMax, float alpha)
+{
+    getWorldBounds(getTransformMatrix(alpha), worldMin, worldMax);
+}
 
-    // generate a transformation matrix based on the stored attributes for this model3d
-    glm::mat4 identity_matrix4 = glm::mat4(1.f);
-    glm::mat4 transformation_matrix = glm::translate(identity_matrix4, position);
-    transformation_matrix = glm::scale(transformation_matrix, scale);
-    transformation_matrix = glm::rotate(transformation_matrix, glm::radians(rotation.x), glm::vec3(1, 0, 0));
-    transformation_matrix = glm::rotate(transformation_matrix, glm::radians(rotation.y), glm::vec3(0, 1, 0));
-    transformation_matrix = glm::rotate(transformation_matrix, glm::radians(rotation.z), glm::vec3(0, 0, 1));
+void Model3D::getWorldBounds(const mat4 &transform, vec3 &worldMin, vec3 &worldMax) const
+{
+    // transform the box center, then grow the extents by the absolute rotation/scale part
+    vec3 center = vec3(transform * vec4((minBounds + maxBounds) * 0.5f, 1.f));
+    vec3 extents = (maxBounds - minBounds) * 0.5f;
+    vec3 worldExtents = abs(vec3(transform[0])) * extents.x + abs(vec3(transform[1])) * extents.y + abs(vec3(transform[2])) * extents.z;
+
+    worldMin = center - worldExtents;
+    worldMax = center + worldExtents;
+}
+
+bool Model3D::isVisible(const gd::Frustum &frustum, float alpha)
+{
+    return isVisible(frustum, getTransformMatrix(alpha));
+}
+
+bool Model3D::isVisible(const gd::Frustum &frustum, const mat4 &transform)
+{
+    vec3 worldMin, worldMax;
+    getWorldBounds(transform, worldMin, worldMax);
+    return frustum.intersectsAABB(worldMin, worldMax);
+}
+
+bool Model3D::raycast(const mat4 &transform, const vec3 &origin, const vec3 &direction, float maxDistance, float &hitDistance) const
+{
+    // the direction isn't renormalised after the inverse, so t means the same distance on both sides
+    mat4 inverseTransform = inverse(transform);
+    vec3 localOrigin = vec3(inverseTransform * vec4(origin, 1.f));
+    vec3 localDirection = vec3(inverseTransform * vec4(direction, 0.f));
+    return bvh.raycast(localOrigin, localDirection, maxDistance, hitDistance);
+}
+
+const float Model3D::lodThresholds[ModelSource::maxLods - 1] = {0.25f, 0.12f, 0.05f};
+const float Model3D::lodHysteresis = 0.15f;
+
+int Model3D::selectLod(const mat4 &transform, const mat4 &viewProjection, const mat4 &projection, float detailDistance)
+{
+    return currentLod = chooseLod(transform, viewProjection, projection, detailDistance, currentLod);
+}
+
+int Model3D::chooseLod(const mat4 &transform, const mat4 &viewProjection, const mat4 &projection, float detailDistance, int previousLod) const
+{
+    if (lodCount <= 1)
+        return 0;
+
+    vec3 worldMin, worldMax;
+    getWorldBounds(transform, worldMin, worldMax);
+    vec3 center = (worldMin + worldMax) * 0.5f;
+    float radius = length(worldMax - worldMin) * 0.5f;
+
+    // clip w is the view depth for perspective and 1 for ortho, projection[1][1] covers fov or ortho height
+    vec4 clip = viewProjection * vec4(center, 1.f);
+    if (clip.w <= radius && projection[2][3] != 0.f)
+        return 0; // camera is inside the bounds
+
+    if (detailDistance > 0.f && clip.w - radius > detailDistance)
+        return lodCount - 1;
+
+    float size = radius * std::fabs(projection[1][1]) / std::max(clip.w, 0.001f);
+
+    int lod = std::min(previousLod, lodCount - 1);
+    while (lod < lodCount - 1 && size < lodThresholds[lod] * (1.f - lodHysteresis))
+        lod++;
+    while (lod > 0 && size > lodThresholds[lod - 1] * (1.f + lodHysteresis))
+        lod--;
+
+    return lod;
+}
+
+uint32_t Model3D::getShaderFeatures(uint32_t sceneFeatures) const
+{
+    uint32_t features = (sceneFeatures & ~shader::feature::material) | materialFeatures;
+
+    // nothing to light without normals
+    if (!hasNormals)
+        features &= ~(shader::feature::DirLight | shader::feature::PointLight);
+
+    return features;
+}
+
+void Model3D::draw(GLuint &shaderProgram, float alpha)
+{
+    draw(shaderProgram, getTransformMatrix(alpha));
+}
+
+void Model3D::draw(GLuint &shaderProgram, const mat4 &transformation_matrix)
+{
+    glUseProgram(shaderProgram);
 
     // send to the given shaderprogram
     unsigned int transformLoc = glGetUniformLocation(shaderProgram, "transform");
     glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transformation_matrix));
 
+    bindMaterial(shaderProgram);
+
+    // draw
+    glBindVertexArray(VAO);
+    glDrawArrays(GL_TRIANGLES, lodFirst[currentLod], lodVertexCount[currentLod]);
+}
+
+void Model3D::drawInstances(GLuint &shaderProgram, int lod, const mat4 *transforms, int count)
+{
+    if (count <= 0)
+        return;
+
+    glUseProgram(shaderProgram);
+    bindMaterial(shaderProgram);
+    glBindVertexArray(VAO);
+
+    // the transform is a mat4 attribute (one vec4 column in each of 5-8) that steps once per instance
+    if (!instanceVBO)
+    {
+        glGenBuffers(1, &instanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for (int column = 0; column < 4; column++)
+        {
+            glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(mat4), (void *)(sizeof(vec4) * column));
+            glEnableVertexAttribArray(5 + column);
+            glVertexAttribDivisor(5 + column, 1);
+        }
+    }
+
+    // fresh storage every call, so the driver never waits for the last draw to finish reading the old one
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(mat4) * count, transforms, GL_STREAM_DRAW);
+
+    glDrawArraysInstanced(GL_TRIANGLES, lodFirst[lod], lodVertexCount[lod], count);
+}
+
+// textures and color, shared by both draws
+void Model3D::bindMaterial(GLuint &shaderProgram)
+{
     GLuint tex0Address = glGetUniformLocation(shaderProgram, "tex0");
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture);
@@ -317,8 +422,4 @@ void Model3D::draw(GLuint &shaderProgram)
 
     GLuint rgbaAddress = glGetUniformLocation(shaderProgram, "rgba");
     glUniform4fv(rgbaAddress, 1, value_ptr(vec4(color, 1.f)));
-
-    // draw
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertexData.size() / attributesSize);
 }
\ No newline at end of file
@@ -1,24 +1,63 @@
 #ifndef MODEL_3D_HPP
 #define MODEL_3D_HPP
 
+#include "../Core/Orientation.hpp"
+#include "MeshBvh.hpp"
+#include "ModelSource.hpp"
+
 namespace model
 {
     using namespace glm;
+
     class Model3D
     {
     private: // model 3d data
-        GLuint VAO;
-        GLuint VBO;
-        GLuint texture;
-        GLuint normalTexture;
-        int attributesSize;
-        std::vector<GLfloat> vertexData;
+        GLuint VAO = 0;
+        GLuint VBO = 0;
+        GLuint texture = 0;
+        GLuint normalTexture = 0;
+        GLuint instanceVBO = 0; // per instance transforms for drawInstances, made on first use
+        int attributesSize = 0;
+        int vertexCount = 0;
+
+        // every lod lives in the one VBO, drawn as a range of it
+        int lodCount = 1;
+        int lodFirst[ModelSource::maxLods] = {};
+        int lodVertexCount[ModelSource::maxLods] = {};
+
+        // shader::feature bits this model's data can feed (texture, normal map)
+        uint32_t materialFeatures = 0;
+        bool hasNormals = false;
+        bool hasTexcoords = false;
+
+        // object space bounding box of the mesh, used for culling
+        vec3 minBounds = vec3(0.f);
+        vec3 maxBounds = vec3(0.f);
+
+        // full detail triangles in object space, for picking and line of sight
+        MeshBvh bvh;
+
+        // the full mesh's biggest triangles in object space (three vertices each), what the occlusion culler draws
+        std::vector<vec3> occluderVertices;
+
+    public:
+        // projected size (how much of half the screen height the bounds cover) under which each coarser lod
+        // takes over, and how far past a threshold it has to go before switching so lods don't flicker
+        static const float lodThresholds[ModelSource::maxLods - 1];
+        static const float lodHysteresis;
+
+        // lod picked by the last selectLod, render thread only
+        int currentLod = 0;
 
     public: // model state info
         vec3 position = vec3(0.f);
-        vec3 rotation = vec3(0.f);
+        gd::Orientation orientation; // set with setRotation for euler angles
         vec3 scale = vec3(1.f);
         vec3 color = vec3(1.f);
+
+        // transform at the previous simulation tick, rendering blends towards the current one
+        vec3 previousPosition = vec3(0.f);
+        quat previousOrientation = quat(1.f, 0.f, 0.f, 0.f);
         // float theta_mod1 = 0;
         // float theta_mod2 = 0;
         // vec4 rgba_mod = vec4(1.0f, 0.72f, 0.77f, 1.0f);
@@ -26,9 +65,72 @@ namespace model
     public:
         Model3D(std::string modelPath, std::string texturePath = "", std::string normalPath = "", vec3 color = vec3(1.f), vec3 pos = vec3(0.f), vec3 rot = vec3(0.f), vec3 sca = vec3(1.f));
         // Model3D(std::string modelPath, vec3 rgba = vec3(1.f), vec3 pos = vec3(0.f), vec3 rot = vec3(0.f), vec3 sca = vec3(1.f));
+        // from a source that was already loaded (e.g. on the job system), only does the GL upload
+        Model3D(ModelSource &source, vec3 color = vec3(1.f), vec3 pos = vec3(0.f), vec3 rot = vec3(0.f), vec3 sca = vec3(1.f));
         ~Model3D();
 
-        void draw(GLuint &shaderProgram);
+        // euler angles in degrees (x, then y, then z)
+        void setRotation(const vec3 &degrees) { orientation.setEuler(degrees); }
+
+        // call at the start of every simulation tick before moving the model
+        void storePreviousTransform();
+
+        // alpha blends between the previous and current tick (1 = current)
+        vec3 getInterpolatedPosition(float alpha = 1.f);
+        quat getInterpolatedOrientation(float alpha = 1.f);
+        mat4 getTransformMatrix(float alpha = 1.f);
+        static mat4 buildTransform(vec3 pos, vec3 rot, vec3 sca);
+        static mat4 buildTransform(vec3 pos, const quat &orientation, vec3 sca);
+
+        // world space bounding box of the transformed mesh
+        void getWorldBounds(vec3 &worldMin, vec3 &worldMax, float alpha = 1.f);
+        void getWorldBounds(const mat4 &transform, vec3 &worldMin, vec3 &worldMax) const;
+        bool isVisible(const gd::Frustum &frustum, float alpha = 1.f);
+        bool isVisible(const gd::Frustum &frustum, const mat4 &transform);
+
+        // nearest hit of a world space ray against the mesh placed with transform. the ray goes into object
+        // space so the bvh never needs rebuilding, hitDistance stays in world units
+        bool raycast(const mat4 &transform, const vec3 &origin, const vec3 &direction, float maxDistance, float &hitDistance) const;
+
+        // pick the lod for this frame from how big the model shows up on screen. anything further than
+        // detailDistance (when > 0, e.g. fully fogged) gets the coarsest one
+        int selectLod(const mat4 &transform, const mat4 &viewProjection, const mat4 &projection, float detailDistance = 0.f);
+
+        // the same choice for a placement that keeps its own previous lod (instances of this mesh)
+        int chooseLod(const mat4 &transform, const mat4 &viewProjection, const mat4 &projection, float detailDistance, int previousLod) const;
+        int getLodCount() const { return lodCount; }
+        int getTriangleCount(int lod = 0) const { return lodVertexCount[lod] / 3; }
+
+        // object space bounding box of the full mesh
+        const vec3 &getMinBounds() const { return minBounds; }
+        const vec3 &getMaxBounds() const { return maxBounds; }
+        const std::vector<vec3> &getOccluderVertices() const { return occluderVertices; }
+
+        // cheapest sample shader variant for this model given the scene's features (lights, camera effects)
+        uint32_t getShaderFeatures(uint32_t sceneFeatures) const;
+
+        void draw(GLuint &shaderProgram, float alpha = 1.f);
+
+        // draw with a transform from elsewhere (e.g. a simulation snapshot) instead of our own fields
+        void draw(GLuint &shaderProgram, const mat4 &transform);
+
+        // one draw call for count copies of the given lod, each with its own transform. needs a variant
+        // with shader::feature::Instanced
+        void drawInstances(GLuint &shaderProgram, int lod, const mat4 *transforms, int count);
+
+        // makes a mipmapped texture on unit and frees the image's bytes, 0 if it never loaded
+        static GLuint uploadTexture(ImageData &image, GLenum unit);
+
+        // replace the mesh and/or textures with the parts source loaded (ModelSource::parts), GL thread only.
+        // false when nothing new made it in
+        bool reload(ModelSource &source);
+
+    private:
+        void upload(ModelSource &source);
+        void uploadMesh(ModelSource &source);
+        void updateMaterialFeatures();
+        static bool replaceTexture(GLuint &current, ImageData &image, GLenum unit);
+        void bindMaterial(GLuint &shaderProgram);
     };
 } // namespace model
 
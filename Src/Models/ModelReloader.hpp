@@ -0,0 +1,167 @@
+#ifndef MODEL_RELOADER_HPP
+#define MODEL_RELOADER_HPP
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../Core/FileWatcher.hpp"
+#include "../Jobs/JobSystem.hpp"
+#include "../Profiling/AllocationTracker.hpp"
+#include "Model3D.hpp"
+#include "ModelSource.hpp"
+
+namespace model
+{
+    // hot reloading for models: watches each model's obj (and lods) and textures, reloads only the part that was
+    // saved on the job system, and hands the result to the render thread to swap in between frames. models whose
+    // files weren't touched are never looked at
+    class ModelReloader
+    {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Watched
+        {
+            Model3D *model;
+            std::string modelPath;
+            std::string texturePath;
+            std::string normalPath;
+
+            Watched(Model3D *model, const std::string &modelPath, const std::string &texturePath, const std::string &normalPath)
+                : model(model), modelPath(modelPath), texturePath(texturePath), normalPath(normalPath) {}
+
+            uint32_t changedParts = 0; // ModelSource::Part bits saved since the last load started, under the mutex
+            Clock::time_point changedAt;
+
+            std::unique_ptr<ModelSource> source; // being loaded, or loaded and waiting for its swap
+            jobs::Counter loading;
+        };
+
+        std::vector<std::unique_ptr<Watched>> watched;
+        gd::FileWatcher watcher;
+        std::mutex mutex;
+        jobs::JobSystem *jobSystem = nullptr;
+
+    public:
+        // a save is often a few writes, and Tools/Simplify.cpp writes the lods one after the other, so a change
+        // has to sit this long before it loads
+        static constexpr double settleSeconds = 0.3;
+
+        ~ModelReloader() { stop(); }
+
+        // add every model before start()
+        void watch(Model3D *model, const std::string &modelPath, const std::string &texturePath, const std::string &normalPath)
+        {
+            watched.emplace_back(new Watched(model, modelPath, texturePath, normalPath));
+
+            watcher.watch(modelPath);
+            for (int lod = 1; lod < ModelSource::maxLods; lod++)
+                watcher.watch(ModelSource::getLodPath(modelPath, lod));
+            if (!texturePath.empty())
+                watcher.watch(texturePath);
+            if (!normalPath.empty())
+                watcher.watch(normalPath);
+        }
+
+        void start(jobs::JobSystem *jobs)
+        {
+            jobSystem = jobs;
+            watcher.start("Model Watcher", [this](const std::string &path)
+                          { changed(path); });
+        }
+
+        // also waits for loads still running, they write into sources we own
+        void stop()
+        {
+            watcher.stop();
+            for (const auto &entry : watched)
+            {
+                if (entry->source)
+                    jobSystem->wait(entry->loading);
+                entry->source.reset();
+            }
+        }
+
+        // render thread, at the start of a frame. starts loads for changes that settled, and swaps in at most one
+        // finished model so two big uploads never land in the same frame. returns the model it swapped, if any
+        Model3D *update()
+        {
+            PROFILE_SCOPE("Model Reload");
+
+            Model3D *swapped = nullptr;
+            Clock::time_point now = Clock::now();
+            for (const auto &entry : watched)
+            {
+                Watched &model = *entry;
+                if (model.source)
+                {
+                    if (swapped || !model.loading.isDone())
+                        continue;
+
+                    profiling::AllowAllocations allow; // a reload is expected to allocate, the frames around it aren't
+                    if (model.model->reload(*model.source))
+                    {
+                        swapped = model.model;
+                        std::cout << "reloaded " << model.modelPath << std::endl;
+                    }
+                    model.source.reset();
+                    continue; // anything saved meanwhile loads next frame
+                }
+
+                uint32_t parts;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!model.changedParts || std::chrono::duration<double>(now - model.changedAt).count() < settleSeconds)
+                        continue;
+                    parts = model.changedParts;
+                    model.changedParts = 0;
+                }
+
+                profiling::AllowAllocations allow;
+                model.source.reset(new ModelSource(model.modelPath, model.texturePath, model.normalPath));
+                model.source->parts = parts;
+                model.source->useArchive = false;
+                ModelSource *source = model.source.get();
+                jobSystem->run([source]()
+                               { source->load(); },
+                               &model.loading);
+            }
+            return swapped;
+        }
+
+    private:
+        // watcher thread. a texture can be shared, so every model using the file gets it
+        void changed(const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto &entry : watched)
+            {
+                Watched &model = *entry;
+                uint32_t parts = 0;
+                if (path == model.modelPath)
+                    parts |= ModelSource::MeshPart;
+                for (int lod = 1; lod < ModelSource::maxLods; lod++)
+                {
+                    if (path == ModelSource::getLodPath(model.modelPath, lod))
+                        parts |= ModelSource::MeshPart;
+                }
+                if (path == model.texturePath)
+                    parts |= ModelSource::TexturePart;
+                if (path == model.normalPath)
+                    parts |= ModelSource::NormalPart;
+
+                if (parts)
+                {
+                    model.changedParts |= parts;
+                    model.changedAt = Clock::now();
+                }
+            }
+        }
+    };
+} // namespace model
+
+#endif // !MODEL_RELOADER_HPP
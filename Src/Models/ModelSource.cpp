@@ -0,0 +1,703 @@
+#include "ModelSource.hpp"
+#include "../Profiling/AllocationTracker.hpp"
+
+using namespace model;
+using namespace glm;
+
+ModelSource::ModelSource(std::string modelPath, std::string texturePath, std::string normalPath) : modelPath(modelPath), texturePath(texturePath), normalPath(normalPath) {}
+
+ModelSource::~ModelSource()
+{
+    // Free loaded bytes (if they never made it to the GPU)
+    freeImage(texture);
+    freeImage(normal);
+}
+
+// parse the obj and decode the textures, no GL calls so this can run on a worker thread
+void ModelSource::load()
+{
+    PROFILE_SCOPE("Load Model");
+
+    if (parts & MeshPart)
+        loadModel();
+    if (parts & TexturePart)
+        texture = loadImage(texturePath, true, useArchive);
+    if (parts & NormalPart)
+        normal = loadImage(normalPath, true, useArchive);
+}
+
+// the full mesh, its lods and the bvh
+void ModelSource::loadModel()
+{
+    // the archive has it ready to use, lods and bvh included
+    const assets::AssetArchive &archive = assets::AssetArchive::get();
+    const assets::AssetArchive::Entry *packed = useArchive ? archive.find(modelPath, assets::Mesh) : nullptr;
+    if (packed && loadPacked(archive, *packed))
+    {
+        success = true;
+        return;
+    }
+
+    if (modelPath.empty())
+    {
+        std::cout << "Error empty model path!" << std::endl;
+        std::cout << "Error loading object file! " << modelPath << std::endl;
+        return;
+    }
+
+    // everything made on the way to vertexData (the obj text, the parsed arrays, tangents) comes out of one arena,
+    // sized by a first pass and freed in one go when the load is done
+    profiling::AllocationScope heap;
+    gd::LinearArena arena;
+
+    // the full mesh, then the lower detail versions made by Tools/Simplify.cpp that go after it in vertexData
+    std::string paths[maxLods];
+    size_t lengths[maxLods];
+    int fileCount = 0;
+    size_t textBytes = 0;
+    for (int lod = 0; lod < maxLods; lod++)
+    {
+        std::string path = lod ? getLodPath(modelPath, lod) : modelPath;
+        std::error_code error;
+        size_t length = size_t(std::filesystem::file_size(path, error));
+        if (error)
+            break;
+
+        paths[fileCount] = path;
+        lengths[fileCount] = length;
+        fileCount++;
+        textBytes += length;
+    }
+
+    if (!fileCount)
+    {
+        std::cout << "Cannot open file [" << modelPath << "]" << std::endl;
+        std::cout << "Error loading object file! " << modelPath << std::endl;
+        return;
+    }
+
+    arena.reserve(textBytes + fileCount * alignof(std::max_align_t));
+    char *texts[maxLods];
+    ObjCounts counts[maxLods];
+    size_t scratchBytes = 0;
+    for (int i = 0; i < fileCount; i++)
+    {
+        texts[i] = arena.allocateArray<char>(lengths[i]);
+        std::ifstream file(paths[i], std::ios::binary);
+        if (!file.read(texts[i], std::streamsize(lengths[i])))
+        {
+            fileCount = i;
+            break;
+        }
+
+        counts[i] = countObj(texts[i], lengths[i]);
+        const ObjCounts &count = counts[i];
+        size_t bytes = count.positions * 3 * sizeof(float) + count.normals * 3 * sizeof(float) + count.texcoords * 2 * sizeof(float) +
+                       count.triangleCorners * 3 * sizeof(int) + count.triangleCorners / 3 * 2 * sizeof(vec3);
+        scratchBytes = std::max(scratchBytes, bytes + 8 * alignof(std::max_align_t));
+    }
+
+    // one file is parsed at a time and its scratch goes before the next, so room for the biggest does for all
+    arena.reserve(scratchBytes);
+    if (fileCount)
+    {
+        size_t attributes = 3 + (counts[0].normals ? 3 : 0) + (counts[0].texcoords ? 8 : 0);
+        size_t corners = 0;
+        for (int i = 0; i < fileCount; i++)
+            corners += counts[i].triangleCorners;
+        vertexData.reserve(corners * attributes);
+    }
+
+    lodFirst.clear();
+    lodVertexCount.clear();
+    for (int i = 0; i < fileCount; i++)
+    {
+        int first = i ? int(vertexData.size()) / attributesSize : 0;
+        gd::LinearArena::Marker scratch = arena.mark();
+        bool loaded = loadMesh(paths[i], texts[i], lengths[i], counts[i], i > 0, arena);
+        arena.rewind(scratch);
+        if (!loaded)
+            break;
+
+        lodFirst.push_back(first);
+        lodVertexCount.push_back(int(vertexData.size()) / attributesSize - first);
+    }
+
+    success = !lodFirst.empty();
+    if (!success)
+    {
+        std::cout << "Error loading object file! " << modelPath << std::endl;
+        return;
+    }
+
+    // only the full mesh gets a bvh, ray casts want the exact surface whatever lod is drawn
+    uint64_t hash = MeshBvh::hashPositions(vertexData.data(), attributesSize, lodFirst[0], lodVertexCount[0]);
+    std::string cachePath = getBvhCachePath(modelPath);
+    if (!bvh.load(cachePath, hash))
+    {
+        bvh.build(vertexData.data(), attributesSize, lodFirst[0], lodVertexCount[0]);
+        bvh.save(cachePath, hash);
+    }
+
+    std::cout << "loaded " << modelPath << ": arena peak " << arena.getPeak() / 1024 << " KB in " << arena.getBlockAllocations()
+              << " blocks for " << arena.getAllocationCount() << " allocations";
+    if (profiling::isTrackingAllocations())
+    {
+        profiling::AllocationStats stats = heap.get();
+        std::cout << ", heap " << stats.allocations << " allocations peaking at " << stats.peak / 1024 << " KB";
+    }
+    std::cout << std::endl;
+}
+
+// point at (or unpack) a Mesh entry written by writePacked
+bool ModelSource::loadPacked(const assets::AssetArchive &archive, const assets::AssetArchive::Entry &entry)
+{
+    PROFILE_SCOPE("Load Packed Model");
+
+    PackedHeader header;
+    if (entry.size < sizeof(header))
+        return false;
+
+    // a stored entry is used where it's mapped, a compressed one unpacks into vertexData (all of it, header included)
+    const unsigned char *data = archive.getMapped(entry);
+    if (!data)
+    {
+        vertexData.resize((entry.size + sizeof(float) - 1) / sizeof(float));
+        if (!archive.unpack(entry, (unsigned char *)vertexData.data()))
+        {
+            vertexData.clear();
+            return false;
+        }
+        data = (const unsigned char *)vertexData.data();
+    }
+
+    std::memcpy(&header, data, sizeof(header));
+    size_t nodesAt = alignPacked(sizeof(header) + header.floatCount * sizeof(float));
+    size_t trianglesAt = alignPacked(nodesAt + size_t(header.bvhNodeCount) * sizeof(BvhNode));
+    if (header.attributesSize <= 0 || header.lodCount < 1 || header.lodCount > maxLods ||
+        trianglesAt + size_t(header.bvhVertexCount) * sizeof(vec3) > entry.size)
+    {
+        std::cout << "Error in packed model! " << modelPath << std::endl;
+        vertexData.clear();
+        return false;
+    }
+
+    attributesSize = header.attributesSize;
+    hasNormals = (header.flags & 1) != 0;
+    hasTexcoords = (header.flags & 2) != 0;
+    lodFirst.assign(header.lodFirst, header.lodFirst + header.lodCount);
+    lodVertexCount.assign(header.lodVertexCount, header.lodVertexCount + header.lodCount);
+    minBounds = vec3(header.minBounds[0], header.minBounds[1], header.minBounds[2]);
+    maxBounds = vec3(header.maxBounds[0], header.maxBounds[1], header.maxBounds[2]);
+
+    mappedVertices = (const float *)(data + sizeof(header));
+    mappedFloatCount = size_t(header.floatCount);
+
+    // the bvh keeps its own copy, it outlives the source
+    const BvhNode *nodes = (const BvhNode *)(data + nodesAt);
+    const vec3 *triangles = (const vec3 *)(data + trianglesAt);
+    bvh.nodes.assign(nodes, nodes + header.bvhNodeCount);
+    bvh.vertices.assign(triangles, triangles + header.bvhVertexCount);
+    if (!bvh.isValid())
+    {
+        std::cout << "Error in packed bvh, rebuilding it! " << modelPath << std::endl;
+        bvh.build(getVertices(), attributesSize, lodFirst[0], lodVertexCount[0]);
+    }
+
+    return true;
+}
+
+void ModelSource::writePacked(std::vector<unsigned char> &out) const
+{
+    PackedHeader header = {};
+    header.attributesSize = attributesSize;
+    header.flags = (hasNormals ? 1u : 0u) | (hasTexcoords ? 2u : 0u);
+    header.lodCount = std::min(int(lodVertexCount.size()), maxLods);
+    for (int i = 0; i < header.lodCount; i++)
+    {
+        header.lodFirst[i] = lodFirst[i];
+        header.lodVertexCount[i] = lodVertexCount[i];
+    }
+    for (int axis = 0; axis < 3; axis++)
+    {
+        header.minBounds[axis] = minBounds[axis];
+        header.maxBounds[axis] = maxBounds[axis];
+    }
+    header.floatCount = getFloatCount();
+    header.bvhNodeCount = uint32_t(bvh.nodes.size());
+    header.bvhVertexCount = uint32_t(bvh.vertices.size());
+
+    size_t nodesAt = alignPacked(sizeof(header) + header.floatCount * sizeof(float));
+    size_t trianglesAt = alignPacked(nodesAt + bvh.nodes.size() * sizeof(BvhNode));
+    out.assign(trianglesAt + bvh.vertices.size() * sizeof(vec3), 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), getVertices(), header.floatCount * sizeof(float));
+    std::memcpy(out.data() + nodesAt, bvh.nodes.data(), bvh.nodes.size() * sizeof(BvhNode));
+    std::memcpy(out.data() + trianglesAt, bvh.vertices.data(), bvh.vertices.size() * sizeof(vec3));
+}
+
+std::string ModelSource::getLodPath(const std::string &path, int lod)
+{
+    size_t dot = path.rfind('.');
+    std::string base = dot == std::string::npos ? path : path.substr(0, dot);
+    return base + ".lod" + std::to_string(lod) + ".obj";
+}
+
+std::string ModelSource::getBvhCachePath(const std::string &path)
+{
+    // the stem is only there to tell files apart by eye, the hash of the whole path keeps meshes with the same
+    // name in different folders from sharing (and fighting over) one cache
+    std::string normalized = std::filesystem::path(path).lexically_normal().generic_string();
+    char hash[20];
+    snprintf(hash, sizeof(hash), ".%016llx", (unsigned long long)assets::AssetArchive::hashName(normalized));
+    return "ModelCache/" + std::filesystem::path(path).stem().string() + hash + ".bvh";
+}
+
+// counts the lines loadMesh will turn into arrays, so it can allocate each once at its final size
+ModelSource::ObjCounts ModelSource::countObj(const char *text, size_t length)
+{
+    ObjCounts counts;
+    const char *end = text + length;
+    for (const char *line = text; line < end;)
+    {
+        const char *lineEnd = (const char *)std::memchr(line, '\n', size_t(end - line));
+        lineEnd = lineEnd ? lineEnd : end;
+
+        const char *token = line;
+        while (token < lineEnd && (*token == ' ' || *token == '\t'))
+            token++;
+        auto isSpace = [lineEnd](const char *c)
+        { return c < lineEnd && (*c == ' ' || *c == '\t'); };
+
+        if (token < lineEnd && token[0] == 'v')
+        {
+            if (isSpace(token + 1))
+                counts.positions++;
+            else if (token + 1 < lineEnd && token[1] == 'n' && isSpace(token + 2))
+                counts.normals++;
+            else if (token + 1 < lineEnd && token[1] == 't' && isSpace(token + 2))
+                counts.texcoords++;
+        }
+        else if (token < lineEnd && token[0] == 'f' && isSpace(token + 1))
+        {
+            int corners = 0;
+            for (const char *c = token + 1; c < lineEnd; c++)
+            {
+                bool separator = *c == ' ' || *c == '\t' || *c == '\r';
+                if (!separator && (c[-1] == ' ' || c[-1] == '\t' || c[-1] == '\r'))
+                    corners++;
+            }
+
+            counts.triangleCorners += corners > 2 ? size_t(corners - 2) * 3 : 0;
+            counts.minFaceCorners = counts.maxFaceCorners ? std::min(counts.minFaceCorners, corners) : corners;
+            counts.maxFaceCorners = std::max(counts.maxFaceCorners, corners);
+        }
+
+        line = lineEnd + 1;
+    }
+    return counts;
+}
+
+// reads the obj text where it already is, in the arena
+struct ObjTextBuffer : std::streambuf
+{
+    ObjTextBuffer(const char *text, size_t length)
+    {
+        char *begin = const_cast<char *>(text);
+        setg(begin, begin, begin + length);
+    }
+};
+
+// tinyobj hands the obj over line by line, this writes it straight into arrays sized from the first pass. anything
+// the arrays weren't sized for, or that LoadObj would treat differently, sets failed and the load goes the slow way
+struct ObjParse
+{
+    float *positions;
+    float *normals;
+    float *texcoords;
+    int *corners;
+    size_t positionCount = 0, positionCapacity;
+    size_t normalCount = 0, normalCapacity;
+    size_t texcoordCount = 0, texcoordCapacity;
+    size_t cornerCount = 0, cornerCapacity;
+    bool shapeDone = false; // LoadObj starts a new shape at a group or object, and only its first is drawn
+    bool failed = false;
+
+    static void vertex(void *user, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t z, tinyobj::real_t)
+    {
+        ObjParse &parse = *(ObjParse *)user;
+        if (parse.positionCount == parse.positionCapacity)
+        {
+            parse.failed = true;
+            return;
+        }
+        float *position = parse.positions + parse.positionCount++ * 3;
+        position[0] = x;
+        position[1] = y;
+        position[2] = z;
+    }
+
+    static void normal(void *user, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t z)
+    {
+        ObjParse &parse = *(ObjParse *)user;
+        if (parse.normalCount == parse.normalCapacity)
+        {
+            parse.failed = true;
+            return;
+        }
+        float *normal = parse.normals + parse.normalCount++ * 3;
+        normal[0] = x;
+        normal[1] = y;
+        normal[2] = z;
+    }
+
+    static void texcoord(void *user, tinyobj::real_t x, tinyobj::real_t y, tinyobj::real_t)
+    {
+        ObjParse &parse = *(ObjParse *)user;
+        if (parse.texcoordCount == parse.texcoordCapacity)
+        {
+            parse.failed = true;
+            return;
+        }
+        float *texcoord = parse.texcoords + parse.texcoordCount++ * 2;
+        texcoord[0] = x;
+        texcoord[1] = y;
+    }
+
+    // obj indices count from 1, negative ones back from the last element so far, and 0 means there isn't one
+    static int toIndex(int raw, size_t count)
+    {
+        return raw > 0 ? raw - 1 : raw < 0 ? int(count) + raw : -1;
+    }
+
+    // triangles go in as they are, quads split along their shorter diagonal like LoadObj's triangulation
+    static void face(void *user, tinyobj::index_t *indices, int cornerCount)
+    {
+        ObjParse &parse = *(ObjParse *)user;
+        if (parse.shapeDone || parse.failed)
+            return;
+        if (cornerCount < 3 || cornerCount > 4 || parse.cornerCount + size_t(cornerCount - 2) * 3 > parse.cornerCapacity)
+        {
+            parse.failed = true;
+            return;
+        }
+
+        int face[4][3];
+        for (int i = 0; i < cornerCount; i++)
+        {
+            face[i][0] = toIndex(indices[i].vertex_index, parse.positionCount);
+            face[i][1] = toIndex(indices[i].normal_index, parse.normalCount);
+            face[i][2] = toIndex(indices[i].texcoord_index, parse.texcoordCount);
+            if (face[i][0] < 0 || face[i][0] >= int(parse.positionCount) || face[i][1] >= int(parse.normalCount) ||
+                face[i][2] >= int(parse.texcoordCount) || face[i][1] < -1 || face[i][2] < -1)
+            {
+                parse.failed = true;
+                return;
+            }
+        }
+
+        static const int triangle[3] = {0, 1, 2};
+        static const int splitOn02[6] = {0, 1, 2, 0, 2, 3};
+        static const int splitOn13[6] = {0, 1, 3, 1, 2, 3};
+        const int *order = triangle;
+        if (cornerCount == 4)
+        {
+            const float *v0 = parse.positions + face[0][0] * 3;
+            const float *v1 = parse.positions + face[1][0] * 3;
+            const float *v2 = parse.positions + face[2][0] * 3;
+            const float *v3 = parse.positions + face[3][0] * 3;
+            float e02x = v2[0] - v0[0], e02y = v2[1] - v0[1], e02z = v2[2] - v0[2];
+            float e13x = v3[0] - v1[0], e13y = v3[1] - v1[1], e13z = v3[2] - v1[2];
+            float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+            float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+            order = sqr02 < sqr13 ? splitOn02 : splitOn13;
+        }
+
+        for (int i = 0; i < (cornerCount - 2) * 3; i++)
+        {
+            int *corner = parse.corners + parse.cornerCount++ * 3;
+            corner[0] = face[order[i]][0];
+            corner[1] = face[order[i]][1];
+            corner[2] = face[order[i]][2];
+        }
+    }
+
+    // materials don't matter here, this only keeps tinyobj from warning that it has none
+    static void material(void *, const char *, int) {}
+
+    static void group(void *user, const char **, int)
+    {
+        ObjParse &parse = *(ObjParse *)user;
+        parse.shapeDone = parse.shapeDone || parse.cornerCount > 0;
+    }
+
+    static void object(void *user, const char *)
+    {
+        group(user, nullptr, 0);
+    }
+};
+
+// parse an obj and append it to vertexData. a lod has to match the layout the full mesh set up
+bool ModelSource::loadMesh(const std::string &path, const char *text, size_t length, const ObjCounts &counts, bool isLod, gd::LinearArena &arena)
+{
+    // polygons past quads need tinyobj's ear clipping, those (small) files still go through LoadObj
+    if (counts.minFaceCorners < 3 || counts.maxFaceCorners > 4)
+        return loadMeshWithTinyObj(path, isLod, arena);
+
+    ObjParse parse;
+    parse.positions = arena.allocateArray<float>(counts.positions * 3);
+    parse.positionCapacity = counts.positions;
+    parse.normals = arena.allocateArray<float>(counts.normals * 3);
+    parse.normalCapacity = counts.normals;
+    parse.texcoords = arena.allocateArray<float>(counts.texcoords * 2);
+    parse.texcoordCapacity = counts.texcoords;
+    parse.corners = arena.allocateArray<int>(counts.triangleCorners * 3);
+    parse.cornerCapacity = counts.triangleCorners;
+
+    tinyobj::callback_t callback;
+    callback.vertex_cb = ObjParse::vertex;
+    callback.normal_cb = ObjParse::normal;
+    callback.texcoord_cb = ObjParse::texcoord;
+    callback.index_cb = ObjParse::face;
+    callback.usemtl_cb = ObjParse::material;
+    callback.group_cb = ObjParse::group;
+    callback.object_cb = ObjParse::object;
+
+    ObjTextBuffer buffer(text, length);
+    std::istream stream(&buffer);
+    std::string warning, error;
+    bool loaded = tinyobj::LoadObjWithCallback(stream, callback, &parse, nullptr, &warning, &error);
+    if (!loaded || parse.failed)
+        return loadMeshWithTinyObj(path, isLod, arena);
+
+    if (!warning.empty())
+        std::cout << warning << std::endl;
+
+    if (!parse.cornerCount)
+        return false;
+
+    MeshData mesh;
+    mesh.positions = parse.positions;
+    mesh.positionCount = parse.positionCount;
+    mesh.normals = parse.normals;
+    mesh.normalCount = parse.normalCount;
+    mesh.texcoords = parse.texcoords;
+    mesh.texcoordCount = parse.texcoordCount;
+    mesh.corners = parse.corners;
+    mesh.cornerCount = parse.cornerCount;
+    return appendMesh(path, mesh, isLod, arena);
+}
+
+// the general path, tinyobj's own vectors and all
+bool ModelSource::loadMeshWithTinyObj(const std::string &path, bool isLod, gd::LinearArena &arena)
+{
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> material;
+    std::string warning, error;
+    tinyobj::attrib_t attributes;
+
+    bool loaded = tinyobj::LoadObj(
+        &attributes,
+        &shapes,
+        &material,
+        &warning,
+        &error,
+        path.c_str());
+
+    if (!warning.empty())
+        std::cout << warning << std::endl;
+
+    if (!error.empty())
+        std::cout << error << std::endl;
+
+    if (!loaded || shapes.empty())
+        return false;
+
+    const std::vector<tinyobj::index_t> &indices = shapes[0].mesh.indices;
+    int *corners = arena.allocateArray<int>(indices.size() * 3);
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        corners[i * 3] = indices[i].vertex_index;
+        corners[i * 3 + 1] = indices[i].normal_index;
+        corners[i * 3 + 2] = indices[i].texcoord_index;
+    }
+
+    MeshData mesh;
+    mesh.positions = attributes.vertices.data();
+    mesh.positionCount = attributes.vertices.size() / 3;
+    mesh.normals = attributes.normals.data();
+    mesh.normalCount = attributes.normals.size() / 3;
+    mesh.texcoords = attributes.texcoords.data();
+    mesh.texcoordCount = attributes.texcoords.size() / 2;
+    mesh.corners = corners;
+    mesh.cornerCount = indices.size();
+    return appendMesh(path, mesh, isLod, arena);
+}
+
+// interleaves position, normal, texcoord, tangent and bitangent per corner onto the end of vertexData
+bool ModelSource::appendMesh(const std::string &path, const MeshData &mesh, bool isLod, gd::LinearArena &arena)
+{
+    bool meshNormals = mesh.normalCount > 0;
+    bool meshTexcoords = mesh.texcoordCount > 0;
+    if (isLod && (hasNormals != meshNormals || hasTexcoords != meshTexcoords))
+    {
+        std::cout << "skipping " << path << ", its vertex layout doesn't match the full mesh" << std::endl;
+        return false;
+    }
+
+    // every index is checked here once so the loops below can't read past the arrays
+    for (size_t i = 0; i < mesh.cornerCount; i++)
+    {
+        const int *corner = mesh.corners + i * 3;
+        if (corner[0] < 0 || size_t(corner[0]) >= mesh.positionCount ||
+            (meshNormals && (corner[1] < 0 || size_t(corner[1]) >= mesh.normalCount)) ||
+            (meshTexcoords && (corner[2] < 0 || size_t(corner[2]) >= mesh.texcoordCount)))
+        {
+            std::cout << "Error in object file, a face points past its vertices! " << path << std::endl;
+            return false;
+        }
+    }
+
+    hasNormals = meshNormals;
+    hasTexcoords = meshTexcoords;
+
+    attributesSize = 3;
+
+    if (hasNormals)
+        attributesSize += 3;
+
+    // object space bounds for frustum culling (a lod never reaches past the full mesh)
+    if (!isLod && mesh.positionCount)
+    {
+        minBounds = maxBounds = vec3(mesh.positions[0], mesh.positions[1], mesh.positions[2]);
+        for (size_t i = 1; i < mesh.positionCount; i++)
+        {
+            vec3 vertex(mesh.positions[i * 3], mesh.positions[i * 3 + 1], mesh.positions[i * 3 + 2]);
+            minBounds = min(minBounds, vertex);
+            maxBounds = max(maxBounds, vertex);
+        }
+    }
+
+    // one tangent and bitangent per triangle, all three corners share them
+    glm::vec3 *tangents = nullptr;
+    if (hasTexcoords)
+    {
+        attributesSize += 8;
+        tangents = arena.allocateArray<glm::vec3>(mesh.cornerCount / 3 * 2);
+
+        for (size_t i = 0; i + 2 < mesh.cornerCount; i += 3)
+        {
+            const int *vData1 = mesh.corners + i * 3;
+            const int *vData2 = vData1 + 3;
+            const int *vData3 = vData1 + 6;
+
+            glm::vec3 v1 = glm::vec3(mesh.positions[vData1[0] * 3], mesh.positions[vData1[0] * 3 + 1], mesh.positions[vData1[0] * 3 + 2]);
+            glm::vec3 v2 = glm::vec3(mesh.positions[vData2[0] * 3], mesh.positions[vData2[0] * 3 + 1], mesh.positions[vData2[0] * 3 + 2]);
+            glm::vec3 v3 = glm::vec3(mesh.positions[vData3[0] * 3], mesh.positions[vData3[0] * 3 + 1], mesh.positions[vData3[0] * 3 + 2]);
+
+            glm::vec2 uv1 = glm::vec2(mesh.texcoords[vData1[2] * 2], mesh.texcoords[vData1[2] * 2 + 1]);
+            glm::vec2 uv2 = glm::vec2(mesh.texcoords[vData2[2] * 2], mesh.texcoords[vData2[2] * 2 + 1]);
+            glm::vec2 uv3 = glm::vec2(mesh.texcoords[vData3[2] * 2], mesh.texcoords[vData3[2] * 2 + 1]);
+
+            glm::vec3 deltaPos1 = v2 - v1;
+            glm::vec3 deltaPos2 = v3 - v1;
+
+            glm::vec2 deltaUV1 = uv2 - uv1;
+            glm::vec2 deltaUV2 = uv3 - uv1;
+
+            float r = 1.f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
+            tangents[i / 3 * 2] = (deltaPos1 * deltaUV2.y - deltaPos2 * deltaUV1.y) * r;
+            tangents[i / 3 * 2 + 1] = (deltaPos2 * deltaUV1.x - deltaPos1 * deltaUV2.x) * r;
+        }
+    }
+
+    // load() reserved room for every lod, this doesn't reallocate
+    size_t first = vertexData.size();
+    vertexData.resize(first + mesh.cornerCount * attributesSize);
+    float *out = vertexData.data() + first;
+    for (size_t i = 0; i < mesh.cornerCount; i++)
+    {
+        const int *vData = mesh.corners + i * 3;
+        const float *position = mesh.positions + vData[0] * 3;
+        *out++ = position[0];
+        *out++ = position[1];
+        *out++ = position[2];
+
+        if (hasNormals)
+        {
+            const float *normal = mesh.normals + vData[1] * 3;
+            *out++ = normal[0];
+            *out++ = normal[1];
+            *out++ = normal[2];
+        }
+
+        // tangents only exist (and only fit in attributesSize) with texcoords
+        if (hasTexcoords)
+        {
+            const float *texcoord = mesh.texcoords + vData[2] * 2;
+            *out++ = texcoord[0];
+            *out++ = texcoord[1];
+
+            const glm::vec3 &tangent = tangents[i / 3 * 2];
+            const glm::vec3 &bitangent = tangents[i / 3 * 2 + 1];
+            *out++ = tangent.x;
+            *out++ = tangent.y;
+            *out++ = tangent.z;
+            *out++ = bitangent.x;
+            *out++ = bitangent.y;
+            *out++ = bitangent.z;
+        }
+    }
+    return true;
+}
+
+ImageData ModelSource::loadImage(const std::string &path, bool flip, bool useArchive)
+{
+    ImageData image;
+    if (path.empty())
+        return image;
+
+    // already decoded in the archive: used in place, or unpacked into memory that's freed like stbi's own
+    const assets::AssetArchive &archive = assets::AssetArchive::get();
+    const assets::AssetArchive::Entry *packed = useArchive ? archive.find(path, assets::Image) : nullptr;
+    if (packed && packed->size > sizeof(assets::ImageInfo))
+    {
+        image.bytes = (unsigned char *)archive.getMapped(*packed);
+        image.mapped = image.bytes != nullptr;
+        if (!image.mapped)
+        {
+            image.bytes = (unsigned char *)malloc(packed->size);
+            if (image.bytes && !archive.unpack(*packed, image.bytes))
+                freeImage(image);
+        }
+
+        if (image.bytes)
+        {
+            assets::ImageInfo info;
+            std::memcpy(&info, image.bytes + packed->size - sizeof(info), sizeof(info));
+            image.width = info.width;
+            image.height = info.height;
+            image.channels = info.channels;
+            if ((info.flipped != 0) == flip && size_t(info.width) * info.height * info.channels + sizeof(info) == packed->size)
+                return image;
+            freeImage(image); // packed the other way up, decode the file instead
+        }
+    }
+
+    // texture mapping
+    stbi_set_flip_vertically_on_load_thread(flip); // flip da image
+    image.bytes = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+
+    if (!image.bytes)
+        std::cout << "Error loading texture! " << path << std::endl;
+
+    return image;
+}
+
+void ModelSource::freeImage(ImageData &image)
+{
+    if (!image.mapped)
+        stbi_image_free(image.bytes);
+    image.bytes = nullptr;
+    image.mapped = false;
+}
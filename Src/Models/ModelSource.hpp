@@ -0,0 +1,146 @@
+#ifndef MODEL_SOURCE_HPP
+#define MODEL_SOURCE_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../Assets/AssetArchive.hpp"
+#include "../Core/LinearArena.hpp"
+#include "MeshBvh.hpp"
+
+namespace model
+{
+    using namespace glm;
+
+    // decoded image straight from stb_image, or pixels from the asset archive
+    struct ImageData
+    {
+        unsigned char *bytes = nullptr;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        bool mapped = false; // bytes point into the mapped archive, there's nothing to free
+    };
+
+    // everything a Model3D needs from disk, parsed and decoded without touching GL so it can load on any thread.
+    // with an asset archive open it comes from there ready made, otherwise from the obj and image files
+    class ModelSource
+    {
+    public:
+        // the full mesh plus up to three simplified ones (name.lod1.obj ...)
+        static constexpr int maxLods = 4;
+
+        std::string modelPath;
+        std::string texturePath;
+        std::string normalPath;
+
+        // what load() reads, hot reloading asks for only the part that changed
+        enum Part : uint32_t
+        {
+            MeshPart = 1 << 0, // the obj and its lods, bounds and bvh
+            TexturePart = 1 << 1,
+            NormalPart = 1 << 2,
+            AllParts = MeshPart | TexturePart | NormalPart,
+        };
+        uint32_t parts = AllParts;
+        bool useArchive = true; // reloads want the file that was just saved, not the packed copy
+
+        bool success = false;
+        int attributesSize = 0;
+        bool hasNormals = false;
+        bool hasTexcoords = false;
+        std::vector<float> vertexData;
+        std::vector<int> lodFirst;       // first vertex of each lod in vertexData
+        std::vector<int> lodVertexCount; // vertices in each lod
+        vec3 minBounds = vec3(0.f);
+        vec3 maxBounds = vec3(0.f);
+
+        // a packed mesh stays where the archive has it, vertexData is only filled when it was compressed
+        const float *mappedVertices = nullptr;
+        size_t mappedFloatCount = 0;
+
+        ImageData texture;
+        ImageData normal;
+
+        // triangles of the full mesh for ray casts, read from ModelCache/ when it's still current
+        MeshBvh bvh;
+
+    private:
+        // start of a Mesh entry, followed by the vertices, the bvh nodes and the bvh triangles (each 16 byte aligned)
+        struct PackedHeader
+        {
+            int32_t attributesSize;
+            uint32_t flags; // 1 normals, 2 texcoords
+            int32_t lodCount;
+            int32_t padding;
+            int32_t lodFirst[maxLods];
+            int32_t lodVertexCount[maxLods];
+            float minBounds[3];
+            float maxBounds[3];
+            uint64_t floatCount;
+            uint32_t bvhNodeCount;
+            uint32_t bvhVertexCount;
+            uint32_t reserved[2];
+        };
+        static_assert(sizeof(PackedHeader) % 16 == 0, "vertices after the header should stay aligned");
+
+        // what a first pass over an obj's text finds, so everything after it is allocated once at its final size
+        struct ObjCounts
+        {
+            size_t positions = 0;
+            size_t normals = 0;
+            size_t texcoords = 0;
+            size_t triangleCorners = 0; // after splitting every face into triangles
+            int minFaceCorners = 0;
+            int maxFaceCorners = 0;
+        };
+
+        // one obj parsed into flat arrays in the load's arena
+        struct MeshData
+        {
+            const float *positions = nullptr; // 3 floats each
+            size_t positionCount = 0;
+            const float *normals = nullptr; // 3 floats each
+            size_t normalCount = 0;
+            const float *texcoords = nullptr; // 2 floats each
+            size_t texcoordCount = 0;
+            const int *corners = nullptr; // position, normal and texcoord index per corner (-1 for none), 3 corners a triangle
+            size_t cornerCount = 0;
+        };
+
+    public:
+        ModelSource(std::string modelPath, std::string texturePath = "", std::string normalPath = "");
+        ModelSource(const ModelSource &) = delete;
+        ModelSource &operator=(const ModelSource &) = delete;
+        ~ModelSource();
+
+        void load();
+
+        // the vertices to upload, wherever they ended up
+        const float *getVertices() const { return mappedVertices ? mappedVertices : vertexData.data(); }
+        size_t getFloatCount() const { return mappedVertices ? mappedFloatCount : vertexData.size(); }
+
+        // everything load() made, as one Mesh entry for the archive
+        void writePacked(std::vector<unsigned char> &out) const;
+
+        // flip puts the rows bottom up like GL's texture coordinates expect (the skybox wants them as they are)
+        static ImageData loadImage(const std::string &path, bool flip = true, bool useArchive = true);
+        static void freeImage(ImageData &image);
+        static std::string getLodPath(const std::string &path, int lod);
+        static std::string getBvhCachePath(const std::string &path);
+
+    private:
+        void loadModel();
+        bool loadMesh(const std::string &path, const char *text, size_t length, const ObjCounts &counts, bool isLod, gd::LinearArena &arena);
+        bool loadMeshWithTinyObj(const std::string &path, bool isLod, gd::LinearArena &arena);
+        bool appendMesh(const std::string &path, const MeshData &mesh, bool isLod, gd::LinearArena &arena);
+        bool loadPacked(const assets::AssetArchive &archive, const assets::AssetArchive::Entry &entry);
+        static ObjCounts countObj(const char *text, size_t length);
+        static size_t alignPacked(size_t offset) { return (offset + 15) & ~size_t(15); }
+    };
+} // namespace model
+
+#endif // !MODEL_SOURCE_HPP
@@ -7,16 +7,36 @@ Player::Player(std::string modelPath, std::string texturePath, std::string norma
 {
 }
 
-void Player::directionalMove(bool isForward)
+Player::Player(ModelSource &source, vec3 color, vec3 pos, vec3 rot, vec3 sca) : Model3D(source, color, pos, rot, sca)
 {
+}
+
+void Player::directionalMove(bool isForward, float deltaTime)
+{
+    float moveDistance = speed * deltaTime;
+
+    // the mesh's +y is where the barrel points, flat on the ground once the model is stood up
+    vec3 forward = orientation.getAxis(1);
+
     if (isForward) // move forward or backward in the direction that the model is facing
-    {
-        position.x -= sin(glm::radians(rotation.z)) * speed;
-        position.z -= cos(glm::radians(rotation.z)) * speed;
-    }
+        position += forward * moveDistance;
     else
+        position -= forward * moveDistance;
+}
+
+void Player::turn(bool isLeft, float deltaTime)
+{
+    // about the mesh's own z, which is world up for the stood up tank. the tick length is fixed
+    // so the step quaternion is built once
+    float degrees = turnSpeed * deltaTime;
+    if (degrees != turnStepDegrees)
     {
-        position.x += sin(glm::radians(rotation.z)) * speed;
-        position.z += cos(glm::radians(rotation.z)) * speed;
+        turnStepDegrees = degrees;
+        turnStep = angleAxis(glm::radians(degrees), vec3(0.f, 0.f, 1.f));
     }
+
+    if (isLeft)
+        orientation.rotateLocal(turnStep);
+    else
+        orientation.rotateLocal(conjugate(turnStep));
 }
@@ -12,12 +12,20 @@ namespace model
     class Player : public Model3D
     {
         public:
-            float speed = 0.5f;
+            float speed = 15.f;      // units per second
+            float turnSpeed = 150.f; // degrees per second
+
+        private:
+            // one tick's turn as a quaternion, only rebuilt if the step size changes
+            float turnStepDegrees = 0.f;
+            quat turnStep = quat(1.f, 0.f, 0.f, 0.f);
 
         public:
             Player(std::string modelPath, std::string texturePath = "", std::string normalPath = "", vec3 color = vec3(1.f), vec3 pos = vec3(0.f), vec3 rot = vec3(0.f), vec3 sca = vec3(1.f));
+            Player(ModelSource &source, vec3 color = vec3(1.f), vec3 pos = vec3(0.f), vec3 rot = vec3(0.f), vec3 sca = vec3(1.f));
 
-            void directionalMove(bool isForward); 
+            void directionalMove(bool isForward, float deltaTime);
+            void turn(bool isLeft, float deltaTime);
     };
 } // namespace model
 
@@ -0,0 +1,161 @@
+#ifndef COLLISION_WORLD_HPP
+#define COLLISION_WORLD_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../Spatial/AabbTree.hpp"
+#include "OrientedBox.hpp"
+#include "SweepAndPrune.hpp"
+
+namespace physics
+{
+    using namespace glm;
+
+    // keeps vehicles out of props and each other. every body is the oriented box of its mesh's bounds and the
+    // box test pushes dynamic bodies apart along the ground. only dynamic bodies go through sweep and prune,
+    // static ones sit in a bounds tree that each dynamic body queries, so props are never sorted or paired with
+    // each other. static bodies never move, two dynamic ones split the push. owned by the simulation thread
+    class CollisionWorld
+    {
+    public:
+        struct Body
+        {
+            OrientedBox box;
+            vec3 localMin;
+            vec3 localMax;
+            vec3 correction; // total push from the last step
+            bool isStatic;
+            int proxy; // in the static tree, -1 for dynamic bodies
+        };
+
+        // passes over the pairs per step, later ones settle pushes that ran into something else
+        int iterations = 2;
+
+    private:
+        std::vector<Body> bodies;
+        std::vector<vec3> minBounds; // world bounds of each body's box, for the broadphase
+        std::vector<vec3> maxBounds;
+        SweepAndPrune broadphase; // dynamic bodies
+        spatial::AabbTree statics;
+        std::vector<int> dynamicIds;
+
+        size_t pairCount = 0;
+        size_t contactCount = 0;
+
+    public:
+        CollisionWorld()
+        {
+            // static boxes only change through setTransform, so the tree can keep them exact
+            statics.margin = 0.f;
+        }
+
+        // localMin/localMax is the mesh's object space box (Model3D::getMinBounds/getMaxBounds)
+        int addBody(const vec3 &localMin, const vec3 &localMax, const mat4 &transform, bool isStatic)
+        {
+            Body body;
+            body.localMin = localMin;
+            body.localMax = localMax;
+            body.correction = vec3(0.f);
+            body.isStatic = isStatic;
+            body.proxy = -1;
+            bodies.push_back(body);
+            minBounds.push_back(vec3(0.f));
+            maxBounds.push_back(vec3(0.f));
+
+            int id = int(bodies.size()) - 1;
+            setTransform(id, transform);
+            if (isStatic)
+                bodies[id].proxy = statics.insert(minBounds[id], maxBounds[id], id);
+            else
+            {
+                broadphase.add(id);
+                dynamicIds.push_back(id);
+            }
+            return id;
+        }
+
+        void setTransform(int id, const mat4 &transform)
+        {
+            bodies[id].box = OrientedBox::fromTransform(transform, bodies[id].localMin, bodies[id].localMax);
+            bodies[id].box.getBounds(minBounds[id], maxBounds[id]);
+            if (bodies[id].proxy >= 0)
+                statics.move(bodies[id].proxy, minBounds[id], maxBounds[id]);
+        }
+
+        // separate everything that overlaps, afterwards add getCorrection to each dynamic body's position
+        void step()
+        {
+            pairCount = 0;
+            contactCount = 0;
+            for (Body &body : bodies)
+                body.correction = vec3(0.f);
+
+            for (int iteration = 0; iteration < iterations; iteration++)
+            {
+                size_t contactsBefore = contactCount;
+                findPairs([this](int a, int b)
+                          {
+                    pairCount++;
+
+                    Contact contact;
+                    if (!separateOnGround(bodies[a].box, bodies[b].box, contact))
+                        return;
+                    contactCount++;
+
+                    // moving a along the normal separates it from b
+                    if (bodies[b].isStatic)
+                        push(a, contact.normal * contact.depth);
+                    else
+                    {
+                        push(a, contact.normal * (contact.depth * 0.5f));
+                        push(b, -contact.normal * (contact.depth * 0.5f));
+                    } });
+
+                if (contactCount == contactsBefore)
+                    break;
+            }
+        }
+
+        // callback(a, b) for every pair whose world bounds overlap and that has a dynamic body in it, each once.
+        // a is always dynamic, b is static or dynamic. dynamic pairs come first, then each dynamic body's statics
+        template <typename Callback>
+        void findPairs(Callback callback)
+        {
+            broadphase.findPairs(minBounds.data(), maxBounds.data(), callback);
+
+            for (int id : dynamicIds)
+            {
+                // bounds are read again per body, pushes from earlier pairs move them
+                statics.queryOverlap(minBounds[id], maxBounds[id], [&](int other)
+                                     {
+                    callback(id, other);
+                    return true; });
+            }
+        }
+
+        const vec3 &getCorrection(int id) const { return bodies[id].correction; }
+        const OrientedBox &getBox(int id) const { return bodies[id].box; }
+        size_t getBodyCount() const { return bodies.size(); }
+
+        // broadphase pairs that reached the box test and how many of them touched, over the last step
+        size_t getPairCount() const { return pairCount; }
+        size_t getContactCount() const { return contactCount; }
+
+    private:
+        void push(int id, const vec3 &offset)
+        {
+            // a hair extra so resting contact doesn't count as touching next tick
+            vec3 move = offset * 1.001f;
+            Body &body = bodies[id];
+            body.box.center += move;
+            body.correction += move;
+            minBounds[id] += move;
+            maxBounds[id] += move;
+        }
+    };
+} // namespace physics
+
+#endif // !COLLISION_WORLD_HPP
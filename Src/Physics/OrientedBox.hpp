@@ -0,0 +1,111 @@
+#ifndef ORIENTED_BOX_HPP
+#define ORIENTED_BOX_HPP
+
+#include <cfloat>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace physics
+{
+    using namespace glm;
+
+    // a mesh's object space bounding box carried into the world by its transform (rotation and scale, no shear)
+    struct OrientedBox
+    {
+        vec3 center = vec3(0.f);
+        vec3 axes[3] = {vec3(1.f, 0.f, 0.f), vec3(0.f, 1.f, 0.f), vec3(0.f, 0.f, 1.f)}; // unit length
+        vec3 halfExtents = vec3(0.f);
+
+        static OrientedBox fromTransform(const mat4 &transform, const vec3 &localMin, const vec3 &localMax)
+        {
+            OrientedBox box;
+            box.center = vec3(transform * vec4((localMin + localMax) * 0.5f, 1.f));
+            for (int i = 0; i < 3; i++)
+            {
+                vec3 column = vec3(transform[i]);
+                float scale = length(column);
+                box.axes[i] = scale > 0.f ? column / scale : box.axes[i];
+                box.halfExtents[i] = (localMax[i] - localMin[i]) * 0.5f * scale;
+            }
+            return box;
+        }
+
+        // half the box's length along axis
+        float projectedRadius(const vec3 &axis) const
+        {
+            return std::fabs(dot(axis, axes[0])) * halfExtents.x + std::fabs(dot(axis, axes[1])) * halfExtents.y +
+                   std::fabs(dot(axis, axes[2])) * halfExtents.z;
+        }
+
+        void getBounds(vec3 &minBounds, vec3 &maxBounds) const
+        {
+            vec3 extents = abs(axes[0]) * halfExtents.x + abs(axes[1]) * halfExtents.y + abs(axes[2]) * halfExtents.z;
+            minBounds = center - extents;
+            maxBounds = center + extents;
+        }
+    };
+
+    // how to move a box out of another
+    struct Contact
+    {
+        vec3 normal = vec3(0.f); // unit, horizontal
+        float depth = 0.f;
+    };
+
+    // separating axis test over the 15 axes of two boxes. vehicles stay on the terrain, so instead of the
+    // smallest overlap the contact is the shortest move along the ground (y stays put) that separates a from b
+    // on some axis. false if they don't overlap, or only a vertical move would separate them
+    inline bool separateOnGround(const OrientedBox &a, const OrientedBox &b, Contact &contact)
+    {
+        vec3 axes[15];
+        int axisCount = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            axes[axisCount++] = a.axes[i];
+            axes[axisCount++] = b.axes[i];
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 3; j++)
+            {
+                // parallel edges give no new axis
+                vec3 axis = cross(a.axes[i], b.axes[j]);
+                float axisLength = length(axis);
+                if (axisLength > 1e-4f)
+                    axes[axisCount++] = axis / axisLength;
+            }
+        }
+
+        vec3 offset = b.center - a.center;
+        float bestMove = FLT_MAX;
+        for (int i = 0; i < axisCount; i++)
+        {
+            const vec3 &axis = axes[i];
+            float distance = dot(offset, axis);
+            float overlap = a.projectedRadius(axis) + b.projectedRadius(axis) - std::fabs(distance);
+            if (overlap <= 0.f)
+                return false;
+
+            // moving h along the ground shifts a by h * horizontal along this axis. steep axes would need huge moves
+            float horizontal = std::sqrt(axis.x * axis.x + axis.z * axis.z);
+            if (horizontal < 0.1f)
+                continue;
+
+            float move = overlap / horizontal;
+            if (move < bestMove)
+            {
+                bestMove = move;
+                float side = distance > 0.f ? -1.f : 1.f; // away from b
+                contact.normal = vec3(axis.x, 0.f, axis.z) * (side / horizontal);
+            }
+        }
+
+        if (bestMove == FLT_MAX)
+            return false;
+        contact.depth = bestMove;
+        return true;
+    }
+} // namespace physics
+
+#endif // !ORIENTED_BOX_HPP
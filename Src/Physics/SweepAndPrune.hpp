@@ -0,0 +1,78 @@
+#ifndef SWEEP_AND_PRUNE_HPP
+#define SWEEP_AND_PRUNE_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace physics
+{
+    using namespace glm;
+
+    // broadphase: boxes kept sorted by their lowest x, then one sweep finds every pair that overlaps on all
+    // three axes. the order survives between calls, and since things only move a little per tick the insertion
+    // sort that repairs it is close to linear. bounds live with the caller (indexed by the ids added here)
+    class SweepAndPrune
+    {
+    private:
+        struct Entry
+        {
+            float minX;
+            int id;
+        };
+
+        std::vector<Entry> order;
+
+    public:
+        void add(int id)
+        {
+            order.push_back({0.f, id});
+        }
+
+        void remove(int id)
+        {
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                if (order[i].id == id)
+                {
+                    order.erase(order.begin() + i);
+                    return;
+                }
+            }
+        }
+
+        size_t size() const { return order.size(); }
+
+        // callback(idA, idB) for every overlapping pair, each once
+        template <typename Callback>
+        void findPairs(const vec3 *minBounds, const vec3 *maxBounds, Callback callback)
+        {
+            for (Entry &entry : order)
+                entry.minX = minBounds[entry.id].x;
+
+            for (size_t i = 1; i < order.size(); i++)
+            {
+                Entry entry = order[i];
+                size_t j = i;
+                for (; j > 0 && order[j - 1].minX > entry.minX; j--)
+                    order[j] = order[j - 1];
+                order[j] = entry;
+            }
+
+            for (size_t i = 0; i < order.size(); i++)
+            {
+                int a = order[i].id;
+                float maxX = maxBounds[a].x;
+                for (size_t j = i + 1; j < order.size() && order[j].minX <= maxX; j++)
+                {
+                    int b = order[j].id;
+                    if (minBounds[b].y <= maxBounds[a].y && maxBounds[b].y >= minBounds[a].y &&
+                        minBounds[b].z <= maxBounds[a].z && maxBounds[b].z >= minBounds[a].z)
+                        callback(a, b);
+                }
+            }
+        }
+    };
+} // namespace physics
+
+#endif // !SWEEP_AND_PRUNE_HPP
@@ -0,0 +1,202 @@
+#ifndef ALLOCATION_TRACKER_HPP
+#define ALLOCATION_TRACKER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// counts heap allocations per thread by replacing the global operator new/delete. define
+// ALLOCATION_TRACKER_IMPLEMENTATION in one file before including this to install it (Main.cpp does), without it
+// or with DISABLE_PROFILER the counters just stay at zero. malloc straight from c code (stb_image, glfw) isn't seen.
+// debug builds on glibc print the call stack of allocations made inside a NoAllocationScope, link with -rdynamic
+// to get function names in it (addr2line -e Main turns the addresses into lines otherwise)
+namespace profiling
+{
+    struct AllocationStats
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0; // total asked for
+        int64_t live = 0;   // allocated minus freed on this thread, memory freed elsewhere can push it below zero
+        int64_t peak = 0;
+    };
+
+    // zero initialised so operator new can touch it before anything else is constructed
+    inline thread_local AllocationStats threadAllocations;
+    inline std::atomic<bool> allocationTrackerInstalled{false};
+
+    // set by the first tracked operator new, so it also says whether the counts mean anything
+    inline bool isTrackingAllocations() { return allocationTrackerInstalled.load(std::memory_order_relaxed); }
+
+    // what the current thread allocated between construction and get(), peak is the most it held at once on top
+    // of what it already had
+    class AllocationScope
+    {
+    private:
+        AllocationStats start;
+
+    public:
+        AllocationScope() : start(threadAllocations)
+        {
+            threadAllocations.peak = threadAllocations.live;
+        }
+
+        ~AllocationScope()
+        {
+            // an outer scope still wants the highest point it saw
+            if (start.peak > threadAllocations.peak)
+                threadAllocations.peak = start.peak;
+        }
+
+        AllocationStats get() const
+        {
+            const AllocationStats &now = threadAllocations;
+            AllocationStats stats;
+            stats.allocations = now.allocations - start.allocations;
+            stats.frees = now.frees - start.frees;
+            stats.bytes = now.bytes - start.bytes;
+            stats.live = now.live - start.live;
+            stats.peak = now.peak - start.live;
+            return stats;
+        }
+    };
+
+    // per thread state for NoAllocationScope
+    struct AllocationGuard
+    {
+        bool armed = false;
+        int allowed = 0; // AllowAllocations nesting
+        uint64_t offending = 0;
+        int stacksPrinted = 0;
+    };
+
+    inline thread_local AllocationGuard threadAllocationGuard;
+
+    // allocating in here is expected (a shader variant compiling, a terrain chunk streaming in) even inside a
+    // NoAllocationScope, it isn't counted against it
+    class AllowAllocations
+    {
+    public:
+        AllowAllocations() { threadAllocationGuard.allowed++; }
+        ~AllowAllocations() { threadAllocationGuard.allowed--; }
+        AllowAllocations(const AllowAllocations &) = delete;
+        AllowAllocations &operator=(const AllowAllocations &) = delete;
+    };
+
+    // a stretch of the current thread (a steady state frame) that shouldn't touch the heap. allocations in it count
+    // as offending unless an AllowAllocations covers them, and debug builds print the first few call stacks
+    class NoAllocationScope
+    {
+    public:
+        static constexpr int maxPrintedStacks = 4;
+
+        explicit NoAllocationScope(bool armed = true)
+        {
+            AllocationGuard &guard = threadAllocationGuard;
+            guard.armed = armed;
+            guard.offending = 0;
+            guard.stacksPrinted = 0;
+        }
+
+        ~NoAllocationScope() { threadAllocationGuard.armed = false; }
+        NoAllocationScope(const NoAllocationScope &) = delete;
+        NoAllocationScope &operator=(const NoAllocationScope &) = delete;
+
+        bool isArmed() const { return threadAllocationGuard.armed; }
+        uint64_t getOffending() const { return threadAllocationGuard.offending; }
+    };
+} // namespace profiling
+
+#if defined(ALLOCATION_TRACKER_IMPLEMENTATION) && !defined(DISABLE_PROFILER)
+
+#if !defined(NDEBUG) && defined(__GLIBC__)
+#define ALLOCATION_TRACKER_STACKS
+#include <cstdio>
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+namespace profiling
+{
+    // an allocation where there shouldn't be one. backtrace_symbols_fd writes straight to the fd, nothing in here
+    // goes through operator new
+    static void reportOffendingAllocation(AllocationGuard &guard, size_t size)
+    {
+        guard.offending++;
+#ifdef ALLOCATION_TRACKER_STACKS
+        if (guard.stacksPrinted >= NoAllocationScope::maxPrintedStacks)
+            return;
+        guard.stacksPrinted++;
+
+        void *frames[32];
+        int frameCount = backtrace(frames, 32);
+        std::fprintf(stderr, "heap allocation of %zu bytes in a no allocation scope:\n", size);
+        std::fflush(stderr);
+        backtrace_symbols_fd(frames + 1, frameCount - 1, STDERR_FILENO); // not this function
+#else
+        (void)size;
+#endif
+    }
+
+    // the size sits in front of each block so delete knows what it's giving back. 16 bytes keeps malloc's alignment
+    static constexpr size_t allocationHeader = 16;
+
+    static void *trackedAllocate(size_t size)
+    {
+        unsigned char *block = (unsigned char *)std::malloc(size + allocationHeader);
+        if (!block)
+            return nullptr;
+
+        *(size_t *)block = size;
+        AllocationStats &stats = threadAllocations;
+        stats.allocations++;
+        stats.bytes += size;
+        stats.live += int64_t(size);
+        stats.peak = stats.live > stats.peak ? stats.live : stats.peak;
+        if (!allocationTrackerInstalled.load(std::memory_order_relaxed))
+            allocationTrackerInstalled.store(true, std::memory_order_relaxed);
+
+        AllocationGuard &guard = threadAllocationGuard;
+        if (guard.armed && !guard.allowed)
+            reportOffendingAllocation(guard, size);
+        return block + allocationHeader;
+    }
+
+    static void trackedFree(void *pointer)
+    {
+        if (!pointer)
+            return;
+
+        unsigned char *block = (unsigned char *)pointer - allocationHeader;
+        AllocationStats &stats = threadAllocations;
+        stats.frees++;
+        stats.live -= int64_t(*(size_t *)block);
+        std::free(block);
+    }
+
+    static void *trackedNew(size_t size)
+    {
+        void *pointer = trackedAllocate(size ? size : 1);
+        if (!pointer)
+            throw std::bad_alloc();
+        return pointer;
+    }
+} // namespace profiling
+
+// over-aligned types keep the library's own new/delete, nothing in here asks for them
+void *operator new(size_t size) { return profiling::trackedNew(size); }
+void *operator new[](size_t size) { return profiling::trackedNew(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return profiling::trackedAllocate(size ? size : 1); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return profiling::trackedAllocate(size ? size : 1); }
+void operator delete(void *pointer) noexcept { profiling::trackedFree(pointer); }
+void operator delete[](void *pointer) noexcept { profiling::trackedFree(pointer); }
+void operator delete(void *pointer, size_t) noexcept { profiling::trackedFree(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { profiling::trackedFree(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { profiling::trackedFree(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { profiling::trackedFree(pointer); }
+
+#endif
+
+#endif // !ALLOCATION_TRACKER_HPP
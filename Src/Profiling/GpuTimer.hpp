@@ -0,0 +1,112 @@
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include "Profiler.hpp"
+
+namespace profiling
+{
+    // GL_TIME_ELAPSED query zone. results come back a few frames late, so each zone keeps a small ring of queries
+    // and never waits on one that isn't ready. these queries can't nest, so keep gpu zones side by side
+    class GpuZone
+    {
+    private:
+        static const int queryCount = 4;
+
+        const char *name;
+        GLuint queries[queryCount] = {};
+        int64_t issueTimes[queryCount] = {}; // cpu time the query was started, to place it on the trace
+        bool pending[queryCount] = {};
+        int current = 0;
+        bool active = false;
+
+    public:
+        double lastMilliseconds = 0.0; // most recent result that came back
+        uint64_t resultCount = 0;      // bumped with every result, to tell a fresh one from last frame's
+
+    public:
+        explicit GpuZone(const char *name) : name(name) {}
+
+        ~GpuZone()
+        {
+            if (queries[0])
+                glDeleteQueries(queryCount, queries);
+        }
+
+        // when always is false the query only runs while a capture is going
+        void begin(bool always = false)
+        {
+            collect();
+
+            if (!always && !Profiler::get().isCapturing())
+                return;
+
+            if (!queries[0])
+                glGenQueries(queryCount, queries);
+
+            // all slots still in flight, skip this frame rather than stall
+            if (pending[current])
+                return;
+
+            issueTimes[current] = Profiler::get().now();
+            glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+            active = true;
+        }
+
+        void end()
+        {
+            if (!active)
+                return;
+
+            glEndQuery(GL_TIME_ELAPSED);
+            pending[current] = true;
+            current = (current + 1) % queryCount;
+            active = false;
+        }
+
+    private:
+        // pick up whichever results are ready without blocking
+        void collect()
+        {
+            for (int i = 0; i < queryCount; i++)
+            {
+                if (!pending[i])
+                    continue;
+
+                GLint available = 0;
+                glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available)
+                    continue;
+
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+                pending[i] = false;
+
+                lastMilliseconds = elapsed / 1e6;
+                resultCount++;
+                if (Profiler::get().isCapturing())
+                    Profiler::get().recordGpu(name, issueTimes[i], int64_t(elapsed));
+            }
+        }
+    };
+
+    class ScopedGpuZone
+    {
+    private:
+        GpuZone &zone;
+
+    public:
+        explicit ScopedGpuZone(GpuZone &zone, bool always = false) : zone(zone) { zone.begin(always); }
+        ~ScopedGpuZone() { zone.end(); }
+    };
+} // namespace profiling
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_GPU_SCOPE(zone) profiling::ScopedGpuZone PROFILE_CONCAT(profileGpuZone, __LINE__)(zone)
+// times every frame while always is true (something other than the profiler needs the result), kept with DISABLE_PROFILER
+#define PROFILE_GPU_SCOPE_ALWAYS(zone, always) profiling::ScopedGpuZone PROFILE_CONCAT(profileGpuZone, __LINE__)(zone, always)
+#else
+#define PROFILE_GPU_SCOPE(zone) ((void)0)
+#define PROFILE_GPU_SCOPE_ALWAYS(zone, always) profiling::ScopedGpuZone PROFILE_CONCAT(profileGpuZone, __LINE__)(zone, always)
+#endif
+
+#endif // !GPU_TIMER_HPP
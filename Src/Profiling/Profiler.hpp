@@ -0,0 +1,294 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AllocationTracker.hpp"
+
+namespace profiling
+{
+    // one finished zone. names must be string literals (or otherwise outlive the capture)
+    struct Event
+    {
+        const char *name;
+        int64_t start;    // nanoseconds since the profiler started
+        int64_t duration; // nanoseconds
+        uint32_t thread;
+    };
+
+    // a sampled value (render scale, gpu time...) shown as a graph on the trace
+    struct CounterSample
+    {
+        const char *name;
+        int64_t time;
+        double value;
+    };
+
+    // single producer (the owning thread) / single consumer (whoever drains) ring of events
+    class EventRing
+    {
+    private:
+        static const uint32_t capacity = 1 << 14;
+
+        Event events[capacity];
+        std::atomic<uint32_t> head{0}; // next write, owner only
+        std::atomic<uint32_t> tail{0}; // next read, consumer only
+
+    public:
+        bool push(const Event &event)
+        {
+            uint32_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) >= capacity)
+                return false; // full, drop it
+
+            events[h & (capacity - 1)] = event;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(Event &event)
+        {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire))
+                return false;
+
+            event = events[t & (capacity - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    // collects zones from every thread and writes captures out as chrome trace-event json
+    // (open in chrome://tracing or https://ui.perfetto.dev)
+    class Profiler
+    {
+    public:
+        static const uint32_t gpuThread = 1000; // fake thread id for the gpu track
+
+    private:
+        struct ThreadInfo
+        {
+            EventRing ring;
+            std::string name;
+            uint32_t id;
+        };
+
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+        std::atomic<bool> capturing{false};
+        std::atomic<int> requestedFrames{0};
+        int framesLeft = 0;
+        int64_t captureStart = 0;
+        std::string capturePath;
+        std::vector<Event> captured;
+        std::vector<CounterSample> counters;
+        std::atomic<int> dropped{0};
+
+        std::mutex threadsMutex;
+        std::vector<std::unique_ptr<ThreadInfo>> threads;
+
+    public:
+        static Profiler &get()
+        {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        // the only check zones make while nothing is being captured
+        bool isCapturing() const { return capturing.load(std::memory_order_relaxed); }
+
+        int64_t now() const
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+        }
+
+        // capture the next few frames into a trace file, any thread
+        void requestCapture(int frames, const std::string &path = "trace.json")
+        {
+            if (isCapturing())
+                return;
+
+            std::lock_guard<std::mutex> lock(threadsMutex);
+            capturePath = path;
+            requestedFrames = frames;
+        }
+
+        // main thread, once at the start of every frame: starts and finishes captures and drains the rings
+        void beginFrame()
+        {
+            if (isCapturing())
+            {
+                AllowAllocations allow; // a capture collects into vectors and writes the trace, that's expected
+                drain();
+
+                if (--framesLeft <= 0)
+                {
+                    capturing = false;
+                    drain(); // pick up anything that finished while we were turning off
+                    write();
+                }
+            }
+            else if (requestedFrames.load(std::memory_order_relaxed) > 0)
+            {
+                framesLeft = requestedFrames.exchange(0);
+                captured.clear();
+                counters.clear();
+                dropped = 0;
+                captureStart = now();
+                capturing = true;
+                std::cout << "profiler: capturing " << framesLeft << " frames" << std::endl;
+            }
+        }
+
+        // record from the calling thread
+        void record(const char *name, int64_t start, int64_t duration)
+        {
+            ThreadInfo &thread = getThread();
+            if (!thread.ring.push({name, start, duration, thread.id}))
+                dropped++;
+        }
+
+        // gpu zones are recorded by the main thread onto their own track
+        void recordGpu(const char *name, int64_t start, int64_t duration)
+        {
+            if (!getThread().ring.push({name, start, duration, gpuThread}))
+                dropped++;
+        }
+
+        // main thread only, once a frame at most
+        void recordCounter(const char *name, double value)
+        {
+            if (isCapturing())
+            {
+                AllowAllocations allow;
+                counters.push_back({name, now(), value});
+            }
+        }
+
+        void setThreadName(const std::string &name)
+        {
+            ThreadInfo &thread = getThread();
+            std::lock_guard<std::mutex> lock(threadsMutex);
+            thread.name = name;
+        }
+
+    private:
+        ThreadInfo &getThread()
+        {
+            thread_local ThreadInfo *info = nullptr;
+            if (!info)
+            {
+                std::lock_guard<std::mutex> lock(threadsMutex);
+                threads.emplace_back(new ThreadInfo());
+                info = threads.back().get();
+                info->id = uint32_t(threads.size());
+                info->name = "Thread " + std::to_string(info->id);
+            }
+            return *info;
+        }
+
+        void drain()
+        {
+            std::lock_guard<std::mutex> lock(threadsMutex);
+            Event event;
+            for (std::unique_ptr<ThreadInfo> &thread : threads)
+            {
+                while (thread->ring.pop(event))
+                {
+                    // skip zones left over from before this capture started
+                    if (event.start >= captureStart)
+                        captured.push_back(event);
+                }
+            }
+        }
+
+        void write()
+        {
+            std::ofstream file(capturePath);
+            if (!file)
+            {
+                std::cout << "profiler: couldn't write " << capturePath << std::endl;
+                return;
+            }
+
+            file << "{\"traceEvents\":[\n";
+
+            // name the tracks
+            {
+                std::lock_guard<std::mutex> lock(threadsMutex);
+                for (std::unique_ptr<ThreadInfo> &thread : threads)
+                    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->id << ",\"args\":{\"name\":\"" << thread->name << "\"}},\n";
+            }
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << gpuThread << ",\"args\":{\"name\":\"GPU\"}}";
+
+            // complete events, timestamps in microseconds
+            for (const Event &event : captured)
+            {
+                file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+                     << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+            }
+
+            for (const CounterSample &counter : counters)
+            {
+                file << ",\n{\"name\":\"" << counter.name << "\",\"ph\":\"C\",\"pid\":0,\"ts\":" << counter.time / 1000.0
+                     << ",\"args\":{\"value\":" << counter.value << "}}";
+            }
+
+            file << "\n]}\n";
+
+            std::cout << "profiler: wrote " << captured.size() << " events to " << capturePath;
+            if (dropped > 0)
+                std::cout << " (" << dropped << " dropped, ring full)";
+            std::cout << std::endl;
+
+            captured.clear();
+            captured.shrink_to_fit();
+            counters.clear();
+        }
+    };
+
+    // times the enclosing scope while a capture is running, otherwise costs one relaxed load
+    class ScopedZone
+    {
+    private:
+        const char *name;
+        int64_t start = -1;
+
+    public:
+        explicit ScopedZone(const char *name) : name(name)
+        {
+            if (Profiler::get().isCapturing())
+                start = Profiler::get().now();
+        }
+
+        ~ScopedZone()
+        {
+            if (start >= 0)
+                Profiler::get().record(name, start, Profiler::get().now() - start);
+        }
+    };
+} // namespace profiling
+
+// define DISABLE_PROFILER to compile every zone out completely
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifndef DISABLE_PROFILER
+#define PROFILE_SCOPE(name) profiling::ScopedZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_THREAD_NAME(name) profiling::Profiler::get().setThreadName(name)
+#define PROFILE_COUNTER(name, value) profiling::Profiler::get().recordCounter(name, value)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#endif
+
+#endif // !PROFILER_HPP
@@ -0,0 +1,85 @@
+#ifndef DYNAMIC_RESOLUTION_HPP
+#define DYNAMIC_RESOLUTION_HPP
+
+#include <algorithm>
+#include <cmath>
+
+namespace gd
+{
+    // picks the internal render scale from measured gpu time so frames stay inside a budget.
+    // pixel cost grows with scale squared, so each sample asks for scale * sqrt(target / measured),
+    // smoothed and rate limited so timer noise and query latency don't make it oscillate
+    class DynamicResolution
+    {
+    public:
+        static constexpr int historySize = 240;
+
+        double targetMilliseconds = 14.0; // gpu budget, a bit under 60 Hz to leave room for the cpu side
+        float minScale = 0.5f;
+        float maxScale = 1.f;
+        float maxStep = 0.05f;  // biggest change per sample
+        float deadZone = 0.02f; // ignore smaller corrections
+        int settleSamples = 4;  // timer results lag a few frames, wait this many after a change before judging it
+
+        float scale = 1.f;
+
+        // most recent samples, oldest first from historyHead
+        float gpuHistory[historySize] = {};
+        float scaleHistory[historySize] = {};
+        int historyHead = 0;
+        int historyCount = 0;
+
+    private:
+        double smoothedMilliseconds = 0.0;
+        int settling = 0;
+
+    public:
+        // feed a fresh gpu time that was measured at the current scale, returns the scale to use from now on
+        float update(double gpuMilliseconds)
+        {
+            if (gpuMilliseconds <= 0.0)
+                return scale;
+
+            gpuHistory[historyHead] = float(gpuMilliseconds);
+            scaleHistory[historyHead] = scale;
+            historyHead = (historyHead + 1) % historySize;
+            historyCount = std::min(historyCount + 1, historySize);
+
+            // results still in flight were measured at the old scale
+            if (settling > 0)
+            {
+                if (--settling == 0)
+                    smoothedMilliseconds = gpuMilliseconds;
+                return scale;
+            }
+
+            smoothedMilliseconds = historyCount > 1 ? smoothedMilliseconds + (gpuMilliseconds - smoothedMilliseconds) * 0.2 : gpuMilliseconds;
+
+            float desired = scale * float(std::sqrt(targetMilliseconds / smoothedMilliseconds));
+            desired = std::max(minScale, std::min(maxScale, desired));
+
+            float change = desired - scale;
+            if (std::fabs(change) < deadZone)
+                return scale;
+
+            scale += std::max(-maxStep, std::min(maxStep, change));
+            settling = settleSamples;
+            return scale;
+        }
+
+        double getAverageMilliseconds() const
+        {
+            if (!historyCount)
+                return 0.0;
+
+            double total = 0.0;
+            for (int i = 0; i < historyCount; i++)
+                total += gpuHistory[i];
+            return total / historyCount;
+        }
+
+        double getSmoothedMilliseconds() const { return smoothedMilliseconds; }
+    };
+}
+
+#endif // !DYNAMIC_RESOLUTION_HPP
@@ -0,0 +1,525 @@
+#ifndef OCCLUSION_CULLER_HPP
+#define OCCLUSION_CULLER_HPP
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE2
+#endif
+
+#include "../Jobs/JobSystem.hpp"
+#include "../Profiling/Profiler.hpp"
+
+namespace gd
+{
+    using namespace glm;
+
+    // masked software occlusion culling (Andersson et al. 2015). occlusion queries stall, and on a software GL
+    // they cost as much as the draw, so big occluders get rasterized on the cpu into a small depth buffer and
+    // object boxes are tested against that before anything is submitted.
+    // the buffer has two levels: an 8x4 pixel subtile keeps one conservative depth for all of its pixels, the
+    // pixels only keep a coverage bit each. four subtiles make a 16x8 tile, one lane of an sse register each.
+    // depth is 1/w, which is linear across the screen (bigger is nearer). an ortho projection has w = 1
+    // everywhere, so the culler only runs for perspective cameras
+    class OcclusionCuller
+    {
+    public:
+        static constexpr int tileWidth = 16;
+        static constexpr int tileHeight = 8;
+        static constexpr int subtileWidth = 8;
+        static constexpr int subtileHeight = 4;
+        static constexpr int bandTileRows = 2; // tile rows per rasterizing job
+
+        // occluders smaller than this on screen (bounding radius over half the screen height, like the lods) would
+        // cost more to rasterize than they hide
+        float minOccluderSize = 0.1f;
+
+        // triangles reaching further off screen than this (in ndc) are skipped instead of clipped, the same goes
+        // for ones behind the camera. dropping an occluder triangle only ever loses occlusion
+        float guardBand = 2.f;
+
+        struct Stats
+        {
+            int occluders = 0;
+            int triangles = 0; // that made it into the buffer
+            int tested = 0;
+            int occluded = 0;
+        };
+
+    private:
+        // four subtiles: bottom left, bottom right, top left, top right
+        struct alignas(16) Tile
+        {
+            int32_t mask[4];  // pixels of the working layer, 8 bits per row from the bottom
+            float zMin[2][4]; // [0] every pixel is at least this near, [1] the farthest pixel of the working layer
+        };
+
+        // a screen space triangle ready to rasterize
+        struct Triangle
+        {
+            float edges[3][4]; // a, b, c with a * x + b * y + c >= 0 inside (either winding), then -1 / a
+            float plane[3];    // 1/w = a * x + b * y + c
+            float zOffset;     // what the plane drops by from a subtile's corner to its farthest corner
+            float zMin;        // farthest vertex
+            int minX, maxX, minY, maxY; // pixels, inclusive. minX > maxX when it was skipped
+        };
+
+        struct Occluder
+        {
+            mat4 transform; // object to clip space
+            const vec3 *vertices;
+            int firstTriangle;
+            int triangleCount;
+            int rasterized; // triangles that survived setup
+            int minY, maxY; // pixel rows they reach, so bands can skip the whole occluder
+            float distance; // nearest view depth of its bounds, occluders go in front to back
+        };
+
+        jobs::JobSystem &jobSystem;
+        int width, height;
+        int tilesX, tilesY;
+        std::vector<Tile> tiles;
+        std::vector<Triangle> triangles;
+        std::vector<Occluder> occluders;
+        int triangleCount = 0;
+        int occluderCount = 0;
+
+        mat4 viewProjection = mat4(1.f);
+        float projectionScale = 1.f;
+        bool perspective = false;
+        bool rendered = false;
+        Stats stats;
+
+    public:
+        // the size gets rounded up to whole tiles. everything is allocated here, a frame never allocates; occluders
+        // past either limit are left out
+        OcclusionCuller(jobs::JobSystem &jobSystem, int width = 256, int height = 128, int maxTriangles = 1 << 16, int maxOccluders = 64)
+            : jobSystem(jobSystem), tilesX((width + tileWidth - 1) / tileWidth), tilesY((height + tileHeight - 1) / tileHeight)
+        {
+            this->width = tilesX * tileWidth;
+            this->height = tilesY * tileHeight;
+            tiles.resize(size_t(tilesX) * tilesY);
+            triangles.resize(maxTriangles);
+            occluders.resize(maxOccluders);
+        }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        const Stats &getStats() const { return stats; }
+
+        // starts a frame. until render() everything counts as visible
+        void begin(const mat4 &viewProjection, const mat4 &projection)
+        {
+            this->viewProjection = viewProjection;
+            projectionScale = std::fabs(projection[1][1]);
+            perspective = projection[2][3] != 0.f;
+            rendered = false;
+            occluderCount = 0;
+            triangleCount = 0;
+            stats = Stats();
+        }
+
+        // queues a mesh (three object space vertices per triangle, kept alive until render()) placed with transform,
+        // worldMin/Max are its world bounds. false when it's too small to bother or nothing's left in the budget
+        bool addOccluder(const vec3 *vertices, int vertexCount, const mat4 &transform, const vec3 &worldMin, const vec3 &worldMax)
+        {
+            int count = vertexCount / 3;
+            if (!perspective || count == 0 || occluderCount == int(occluders.size()) || triangleCount + count > int(triangles.size()))
+                return false;
+
+            vec3 center = (worldMin + worldMax) * 0.5f;
+            float radius = length(worldMax - worldMin) * 0.5f;
+            float w = (viewProjection * vec4(center, 1.f)).w;
+            if (w > radius && radius * projectionScale / w < minOccluderSize)
+                return false; // the camera being inside the bounds counts as big
+
+            Occluder &occluder = occluders[occluderCount++];
+            occluder.transform = viewProjection * transform;
+            occluder.vertices = vertices;
+            occluder.firstTriangle = triangleCount;
+            occluder.triangleCount = count;
+            occluder.rasterized = 0;
+            occluder.distance = w - radius;
+            triangleCount += count;
+            return true;
+        }
+
+        // rasterizes the queued occluders: the triangles get set up one occluder per job, then each job takes a band
+        // of tile rows and draws every triangle that reaches into it, so no two jobs touch the same tile
+        void render()
+        {
+            if (!perspective || occluderCount == 0)
+                return;
+            PROFILE_SCOPE("Occlusion Raster");
+
+            // nearer occluders first fill the reference layer with near depths sooner
+            std::sort(occluders.begin(), occluders.begin() + occluderCount, [](const Occluder &a, const Occluder &b)
+                      { return a.distance < b.distance; });
+
+            jobSystem.parallelFor(0, occluderCount, 1, [this](size_t first, size_t last)
+                                  {
+                for (size_t i = first; i < last; i++)
+                    setupTriangles(occluders[i]); });
+
+            jobSystem.parallelFor(0, tilesY, bandTileRows, [this](size_t first, size_t last)
+                                  { rasterizeBand(int(first), int(last)); });
+
+            stats.occluders = occluderCount;
+            for (int i = 0; i < occluderCount; i++)
+                stats.triangles += occluders[i].rasterized;
+            rendered = true;
+        }
+
+        // false when the world space box is certainly behind what render() drew
+        bool isVisible(const vec3 &worldMin, const vec3 &worldMax)
+        {
+            if (!rendered)
+                return true;
+            stats.tested++;
+
+            // screen rectangle and nearest depth of the corners
+            float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = 0.f;
+            for (int corner = 0; corner < 8; corner++)
+            {
+                vec3 point(corner & 1 ? worldMax.x : worldMin.x, corner & 2 ? worldMax.y : worldMin.y, corner & 4 ? worldMax.z : worldMin.z);
+                vec4 clip = viewProjection * vec4(point, 1.f);
+                if (clip.w <= 1e-6f)
+                    return true; // reaches behind the camera
+
+                float inverseW = 1.f / clip.w;
+                float x = (clip.x * inverseW * 0.5f + 0.5f) * width;
+                float y = (clip.y * inverseW * 0.5f + 0.5f) * height;
+                minX = std::min(minX, x);
+                maxX = std::max(maxX, x);
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+                nearest = std::max(nearest, inverseW);
+            }
+
+            // every pixel the rectangle touches, as subtiles
+            int x0 = std::max(int(std::floor(minX)), 0), x1 = std::min(int(std::floor(maxX)), width - 1);
+            int y0 = std::max(int(std::floor(minY)), 0), y1 = std::min(int(std::floor(maxY)), height - 1);
+            if (x0 > x1 || y0 > y1)
+                return true; // off screen, that's the frustum's call
+            int subtileX0 = x0 / subtileWidth, subtileX1 = x1 / subtileWidth;
+            int subtileY0 = y0 / subtileHeight, subtileY1 = y1 / subtileHeight;
+
+            for (int tileY = y0 / tileHeight; tileY <= y1 / tileHeight; tileY++)
+            {
+                for (int tileX = x0 / tileWidth; tileX <= x1 / tileWidth; tileX++)
+                {
+                    if (testTile(tiles[size_t(tileY) * tilesX + tileX], tileX * 2, tileY * 2, subtileX0, subtileX1, subtileY0, subtileY1, nearest))
+                        return true;
+                }
+            }
+
+            stats.occluded++;
+            return false;
+        }
+
+    private:
+        void setupTriangles(Occluder &occluder)
+        {
+            const vec3 *vertices = occluder.vertices;
+            float halfWidth = width * 0.5f, halfHeight = height * 0.5f;
+            occluder.minY = height;
+            occluder.maxY = -1;
+
+            for (int t = 0; t < occluder.triangleCount; t++)
+            {
+                Triangle &triangle = triangles[occluder.firstTriangle + t];
+                triangle.minX = 1;
+                triangle.maxX = 0;
+
+                vec3 screen[3];
+                bool skip = false;
+                for (int v = 0; v < 3; v++)
+                {
+                    vec4 clip = occluder.transform * vec4(vertices[t * 3 + v], 1.f);
+                    float limit = clip.w * guardBand;
+                    if (clip.w <= 1e-6f || std::fabs(clip.x) > limit || std::fabs(clip.y) > limit)
+                    {
+                        skip = true;
+                        break;
+                    }
+                    float inverseW = 1.f / clip.w;
+                    screen[v] = vec3((clip.x * inverseW + 1.f) * halfWidth, (clip.y * inverseW + 1.f) * halfHeight, inverseW);
+                }
+                if (skip)
+                    continue;
+
+                float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+                if (std::fabs(area) < 1e-6f)
+                    continue;
+
+                // pixels whose centers fall in the bounds, most small triangles slip between them and are done here
+                int minX = std::max(int(std::ceil(std::min(screen[0].x, std::min(screen[1].x, screen[2].x)) - 0.5f)), 0);
+                int maxX = std::min(int(std::floor(std::max(screen[0].x, std::max(screen[1].x, screen[2].x)) - 0.5f)), width - 1);
+                int minY = std::max(int(std::ceil(std::min(screen[0].y, std::min(screen[1].y, screen[2].y)) - 0.5f)), 0);
+                int maxY = std::min(int(std::floor(std::max(screen[0].y, std::max(screen[1].y, screen[2].y)) - 0.5f)), height - 1);
+                if (minX > maxX || minY > maxY)
+                    continue;
+
+                // no back face culling, GL doesn't do any either
+                float sign = area > 0.f ? 1.f : -1.f;
+                for (int e = 0; e < 3; e++)
+                {
+                    const vec3 &from = screen[e];
+                    const vec3 &to = screen[(e + 1) % 3];
+                    float *edge = triangle.edges[e];
+                    edge[0] = sign * (from.y - to.y);
+                    edge[1] = sign * (to.x - from.x);
+                    edge[2] = sign * (from.x * to.y - from.y * to.x);
+                    edge[3] = edge[0] != 0.f ? -1.f / edge[0] : 0.f;
+                }
+
+                float inverseArea = 1.f / area;
+                float dz1 = screen[1].z - screen[0].z, dz2 = screen[2].z - screen[0].z;
+                triangle.plane[0] = (dz1 * (screen[2].y - screen[0].y) - dz2 * (screen[1].y - screen[0].y)) * inverseArea;
+                triangle.plane[1] = (dz2 * (screen[1].x - screen[0].x) - dz1 * (screen[2].x - screen[0].x)) * inverseArea;
+                triangle.plane[2] = screen[0].z - triangle.plane[0] * screen[0].x - triangle.plane[1] * screen[0].y;
+                triangle.zOffset = std::min(triangle.plane[0] * subtileWidth, 0.f) + std::min(triangle.plane[1] * subtileHeight, 0.f);
+                triangle.zMin = std::min(screen[0].z, std::min(screen[1].z, screen[2].z));
+
+                triangle.minX = minX;
+                triangle.maxX = maxX;
+                triangle.minY = minY;
+                triangle.maxY = maxY;
+                occluder.minY = std::min(occluder.minY, minY);
+                occluder.maxY = std::max(occluder.maxY, maxY);
+                occluder.rasterized++;
+            }
+        }
+
+        void rasterizeBand(int firstRow, int lastRow)
+        {
+            for (int tileY = firstRow; tileY < lastRow; tileY++)
+            {
+                for (int tileX = 0; tileX < tilesX; tileX++)
+                {
+                    Tile &tile = tiles[size_t(tileY) * tilesX + tileX];
+                    for (int lane = 0; lane < 4; lane++)
+                    {
+                        tile.mask[lane] = 0;
+                        tile.zMin[0][lane] = 0.f; // infinitely far
+                        tile.zMin[1][lane] = FLT_MAX;
+                    }
+                }
+            }
+
+            int bandMinY = firstRow * tileHeight, bandMaxY = lastRow * tileHeight - 1;
+            for (int o = 0; o < occluderCount; o++)
+            {
+                const Occluder &occluder = occluders[o];
+                if (occluder.maxY < bandMinY || occluder.minY > bandMaxY)
+                    continue;
+
+                for (int t = occluder.firstTriangle; t < occluder.firstTriangle + occluder.triangleCount; t++)
+                {
+                    const Triangle &triangle = triangles[t];
+                    if (triangle.minX > triangle.maxX || triangle.maxY < bandMinY || triangle.minY > bandMaxY)
+                        continue;
+
+                    int tileY0 = std::max(triangle.minY / tileHeight, firstRow), tileY1 = std::min(triangle.maxY / tileHeight, lastRow - 1);
+                    for (int tileY = tileY0; tileY <= tileY1; tileY++)
+                    {
+                        for (int tileX = triangle.minX / tileWidth; tileX <= triangle.maxX / tileWidth; tileX++)
+                            updateTile(tiles[size_t(tileY) * tilesX + tileX], triangle, tileX * tileWidth, tileY * tileHeight);
+                    }
+                }
+            }
+        }
+
+#ifdef OCCLUSION_CULLER_SSE2
+        static __m128 select(__m128 condition, __m128 whenTrue, __m128 whenFalse)
+        {
+            return _mm_or_ps(_mm_and_ps(condition, whenTrue), _mm_andnot_ps(condition, whenFalse));
+        }
+
+        // floor without sse4.1, for values above -16
+        static __m128 floorSmall(__m128 value)
+        {
+            const __m128 offset = _mm_set1_ps(16.f);
+            return _mm_sub_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_add_ps(value, offset))), offset);
+        }
+
+        // 1 << n for whole numbers 0 to 30, built straight as a float's exponent since sse2 has no per lane shifts
+        static __m128i powerOfTwo(__m128 n)
+        {
+            __m128i exponent = _mm_add_epi32(_mm_cvttps_epi32(n), _mm_set1_epi32(127));
+            return _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(exponent, 23)));
+        }
+
+        // merges one triangle into a tile's four subtiles (section 3 of the paper): coverage first, one row of the
+        // four subtiles at a time as the span between where the edges cross it, then the depth layers
+        static void updateTile(Tile &tile, const Triangle &triangle, int x, int y)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 subtileX = _mm_add_ps(_mm_set1_ps(float(x)), _mm_setr_ps(0.f, float(subtileWidth), 0.f, float(subtileWidth)));
+            const __m128 subtileY = _mm_add_ps(_mm_set1_ps(float(y)), _mm_setr_ps(0.f, 0.f, float(subtileHeight), float(subtileHeight)));
+            const __m128 centerX = _mm_add_ps(subtileX, _mm_set1_ps(0.5f));
+
+            __m128i coverage = _mm_setzero_si128();
+            for (int row = 0; row < subtileHeight; row++)
+            {
+                __m128 centerY = _mm_add_ps(subtileY, _mm_set1_ps(row + 0.5f));
+                __m128 left = zero, right = _mm_set1_ps(subtileWidth - 1.f); // pixel span within the subtile
+                for (int e = 0; e < 3; e++)
+                {
+                    const float *edge = triangle.edges[e];
+                    __m128 rowValue = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge[1]), centerY), _mm_set1_ps(edge[2]));
+                    if (edge[0] == 0.f)
+                    {
+                        // horizontal edge, the whole row is in or out
+                        left = _mm_max_ps(left, _mm_and_ps(_mm_cmplt_ps(rowValue, zero), _mm_set1_ps(float(subtileWidth))));
+                        continue;
+                    }
+
+                    // x where the edge crosses this row, from the subtile's first pixel center
+                    __m128 crossing = _mm_sub_ps(_mm_mul_ps(rowValue, _mm_set1_ps(edge[3])), centerX);
+                    crossing = _mm_min_ps(_mm_max_ps(crossing, _mm_set1_ps(-1.f)), _mm_set1_ps(float(subtileWidth) + 1.f));
+                    if (edge[0] > 0.f)
+                        left = _mm_max_ps(left, _mm_sub_ps(zero, floorSmall(_mm_sub_ps(zero, crossing)))); // inside to the right, ceil
+                    else
+                        right = _mm_min_ps(right, floorSmall(crossing));
+                }
+                left = _mm_min_ps(left, _mm_set1_ps(float(subtileWidth)));
+
+                // bits left..right of the row
+                __m128i fromLeft = _mm_sub_epi32(_mm_set1_epi32(1 << subtileWidth), powerOfTwo(left));
+                __m128i toRight = _mm_sub_epi32(powerOfTwo(_mm_add_ps(right, _mm_set1_ps(1.f))), _mm_set1_epi32(1));
+                coverage = _mm_or_si128(coverage, _mm_sll_epi32(_mm_and_si128(fromLeft, toRight), _mm_cvtsi32_si128(row * subtileWidth)));
+            }
+
+            // the farthest the triangle gets inside each subtile: the plane at its farthest corner, but never past
+            // the farthest vertex
+            __m128 zTriangle = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.plane[0]), subtileX), _mm_mul_ps(_mm_set1_ps(triangle.plane[1]), subtileY)),
+                                          _mm_set1_ps(triangle.plane[2] + triangle.zOffset));
+            zTriangle = _mm_max_ps(zTriangle, _mm_set1_ps(triangle.zMin));
+
+            const __m128i allPixels = _mm_set1_epi32(-1);
+            __m128i mask = _mm_load_si128((const __m128i *)tile.mask);
+            __m128 z0 = _mm_load_ps(tile.zMin[0]), z1 = _mm_load_ps(tile.zMin[1]);
+
+            // subtiles it misses, or where it's behind everything already there, are left alone
+            __m128 dead = _mm_or_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(coverage, _mm_setzero_si128())), _mm_cmplt_ps(zTriangle, z0));
+            if (_mm_movemask_ps(dead) == 0xF)
+                return;
+            __m128i covered = _mm_andnot_si128(_mm_castps_si128(dead), coverage);
+
+            // drop the working layer when the triangle is much nearer than it (past halfway from the reference
+            // layer), or covers the whole subtile by itself
+            __m128 farLayer = _mm_cmplt_ps(_mm_sub_ps(_mm_add_ps(z1, z1), _mm_add_ps(zTriangle, z0)), zero);
+            __m128 discard = _mm_andnot_ps(dead, _mm_or_ps(farLayer, _mm_castsi128_ps(_mm_cmpeq_epi32(covered, allPixels))));
+            mask = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(discard), mask), covered);
+
+            // min of both when merging, the triangle's when the layer was dropped, the old one when untouched
+            __m128 merged = _mm_min_ps(select(dead, z1, zTriangle), select(discard, zTriangle, z1));
+
+            // a full working layer becomes the reference layer
+            __m128 full = _mm_castsi128_ps(_mm_cmpeq_epi32(mask, allPixels));
+            _mm_store_ps(tile.zMin[0], select(full, merged, z0));
+            _mm_store_ps(tile.zMin[1], select(full, _mm_set1_ps(FLT_MAX), merged));
+            _mm_store_si128((__m128i *)tile.mask, _mm_andnot_si128(_mm_castps_si128(full), mask));
+        }
+
+        // true if any of the tile's subtiles inside the range could show something at depth nearest
+        static bool testTile(const Tile &tile, int subtileX, int subtileY, int subtileX0, int subtileX1, int subtileY0, int subtileY1, float nearest)
+        {
+            __m128i laneX = _mm_add_epi32(_mm_set1_epi32(subtileX), _mm_setr_epi32(0, 1, 0, 1));
+            __m128i laneY = _mm_add_epi32(_mm_set1_epi32(subtileY), _mm_setr_epi32(0, 0, 1, 1));
+            __m128i outside = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi32(laneX, _mm_set1_epi32(subtileX0)), _mm_cmpgt_epi32(laneX, _mm_set1_epi32(subtileX1))),
+                                           _mm_or_si128(_mm_cmplt_epi32(laneY, _mm_set1_epi32(subtileY0)), _mm_cmpgt_epi32(laneY, _mm_set1_epi32(subtileY1))));
+            __m128 visible = _mm_cmpge_ps(_mm_set1_ps(nearest), _mm_load_ps(tile.zMin[0]));
+            return _mm_movemask_ps(_mm_andnot_ps(_mm_castsi128_ps(outside), visible)) != 0;
+        }
+#else
+        // the same as the sse2 version, one subtile at a time
+        static void updateTile(Tile &tile, const Triangle &triangle, int x, int y)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                float subtileX = float(x + (lane & 1) * subtileWidth);
+                float subtileY = float(y + (lane >> 1) * subtileHeight);
+
+                uint32_t coverage = 0;
+                for (int row = 0; row < subtileHeight; row++)
+                {
+                    float centerY = subtileY + row + 0.5f;
+                    float left = 0.f, right = subtileWidth - 1.f;
+                    for (int e = 0; e < 3; e++)
+                    {
+                        const float *edge = triangle.edges[e];
+                        float rowValue = edge[1] * centerY + edge[2];
+                        if (edge[0] == 0.f)
+                        {
+                            if (rowValue < 0.f)
+                                left = float(subtileWidth);
+                            continue;
+                        }
+
+                        float crossing = std::min(std::max(rowValue * edge[3] - (subtileX + 0.5f), -1.f), float(subtileWidth) + 1.f);
+                        if (edge[0] > 0.f)
+                            left = std::max(left, std::ceil(crossing));
+                        else
+                            right = std::min(right, std::floor(crossing));
+                    }
+                    left = std::min(left, float(subtileWidth));
+
+                    uint32_t fromLeft = (1u << subtileWidth) - (1u << int(left));
+                    uint32_t toRight = (1u << int(right + 1.f)) - 1u;
+                    coverage |= (fromLeft & toRight) << (row * subtileWidth);
+                }
+
+                float zTriangle = (triangle.plane[0] * subtileX + triangle.plane[1] * subtileY) + (triangle.plane[2] + triangle.zOffset);
+                zTriangle = std::max(zTriangle, triangle.zMin);
+
+                float &z0 = tile.zMin[0][lane];
+                float &z1 = tile.zMin[1][lane];
+                uint32_t mask = uint32_t(tile.mask[lane]);
+                if (!coverage || zTriangle < z0)
+                    continue;
+
+                if (z1 + z1 - (zTriangle + z0) < 0.f || coverage == ~0u)
+                {
+                    mask = coverage;
+                    z1 = zTriangle;
+                }
+                else
+                {
+                    mask |= coverage;
+                    z1 = std::min(z1, zTriangle);
+                }
+
+                if (mask == ~0u)
+                {
+                    z0 = z1;
+                    z1 = FLT_MAX;
+                    mask = 0;
+                }
+                tile.mask[lane] = int32_t(mask);
+            }
+        }
+
+        static bool testTile(const Tile &tile, int subtileX, int subtileY, int subtileX0, int subtileX1, int subtileY0, int subtileY1, float nearest)
+        {
+            for (int lane = 0; lane < 4; lane++)
+            {
+                int laneX = subtileX + (lane & 1), laneY = subtileY + (lane >> 1);
+                if (laneX >= subtileX0 && laneX <= subtileX1 && laneY >= subtileY0 && laneY <= subtileY1 && nearest >= tile.zMin[0][lane])
+                    return true;
+            }
+            return false;
+        }
+#endif
+    };
+} // namespace gd
+
+#endif // !OCCLUSION_CULLER_HPP
@@ -0,0 +1,195 @@
+#ifndef POST_PROCESS_HPP
+#define POST_PROCESS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../Profiling/Profiler.hpp"
+#include "../Shaders/Shader.hpp"
+
+namespace gd
+{
+    using namespace glm;
+
+    // offscreen hdr color + depth the scene renders into
+    class RenderTarget
+    {
+    public:
+        GLuint framebuffer = 0;
+        GLuint colorTexture = 0;
+        GLuint depthTexture = 0;
+        int width = 0;
+        int height = 0;
+
+        // mips of the color texture, post effects sample them for cheap blurs
+        static const int mipLevels = 5;
+
+    public:
+        ~RenderTarget() { release(); }
+
+        // (re)allocate at this size, does nothing if it already matches
+        void resize(int newWidth, int newHeight)
+        {
+            newWidth = std::max(newWidth, 1);
+            newHeight = std::max(newHeight, 1);
+            if (framebuffer && newWidth == width && newHeight == height)
+                return;
+
+            release();
+            width = newWidth;
+            height = newHeight;
+
+            glGenTextures(1, &colorTexture);
+            glBindTexture(GL_TEXTURE_2D, colorTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipLevels - 1);
+            // mips have to exist for the texture to be complete, they're only refreshed when an effect wants them
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+            glGenTextures(1, &depthTexture);
+            glBindTexture(GL_TEXTURE_2D, depthTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glGenFramebuffers(1, &framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "render target " << width << "x" << height << " is incomplete" << std::endl;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        void release()
+        {
+            if (!framebuffer)
+                return;
+
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteTextures(1, &colorTexture);
+            glDeleteTextures(1, &depthTexture);
+            framebuffer = colorTexture = depthTexture = 0;
+        }
+    };
+
+    // the scene renders into an hdr target at renderScale of the window, then one fullscreen pass
+    // applies every enabled effect (fog, night vision, sharpening, tonemapping) on the way to the screen.
+    // the target is allocated at full window size and the scene only uses a corner of it, so the scale
+    // can change every frame without reallocating anything
+    class PostProcess
+    {
+    public:
+        // feature bits of Shaders/post.frag
+        static const uint32_t NightVision = 1 << 0;
+        static const uint32_t Fog = 1 << 1;
+        static const uint32_t Sharpen = 1 << 2; // added automatically while upscaling
+
+        // internal resolution relative to the window, below 1 saves fill rate and gets upscaled
+        float renderScale = 1.f;
+
+        float sharpness = 0.2f;
+        float exposure = 1.f;
+        float fogStart = 5.f;
+        float fogEnd = 50.f;
+        vec3 fogColor = vec3(0.02f, 0.02f, 0.05f);
+
+        shader::ShaderVariants shaders;
+        RenderTarget target;
+
+    private:
+        GLuint emptyVAO = 0;
+        int windowWidth = 0;
+        int windowHeight = 0;
+        int sceneWidth = 0;
+        int sceneHeight = 0;
+
+    public:
+        // needs a current context
+        PostProcess() : shaders("Shaders/post.vert", "Shaders/post.frag", {"NIGHT_VISION", "FOG", "SHARPEN"})
+        {
+            // the fullscreen triangle comes from gl_VertexID, but core profiles still want a VAO bound
+            glGenVertexArrays(1, &emptyVAO);
+        }
+
+        ~PostProcess() { glDeleteVertexArrays(1, &emptyVAO); }
+
+        // bind the scene target, everything drawn until apply() goes in it at renderScale of this window size
+        void begin(int width, int height)
+        {
+            windowWidth = width;
+            windowHeight = height;
+            target.resize(width, height);
+
+            float scale = clamp(renderScale, 0.1f, 1.f);
+            sceneWidth = std::max(int(width * scale + 0.5f), 1);
+            sceneHeight = std::max(int(height * scale + 0.5f), 1);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+            glViewport(0, 0, sceneWidth, sceneHeight);
+        }
+
+        int getSceneWidth() const { return sceneWidth; }
+        int getSceneHeight() const { return sceneHeight; }
+
+        // resolve the scene to the window with the effects in features
+        void apply(uint32_t features, const mat4 &inverseProjection, float time)
+        {
+            PROFILE_SCOPE("Post Process");
+
+            // night vision glow reads the blurry mips
+            if (features & NightVision)
+            {
+                glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+                glGenerateMipmap(GL_TEXTURE_2D);
+            }
+
+            if (sceneWidth < target.width || sceneHeight < target.height)
+                features |= Sharpen;
+
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, windowWidth, windowHeight);
+            glDisable(GL_DEPTH_TEST);
+
+            shader::Shader &post = shaders.get(features);
+            glUseProgram(post.shaderProgram);
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+            glUniform1i(post.getUniformLocation("sceneColor"), 0);
+
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, target.depthTexture);
+            glUniform1i(post.getUniformLocation("sceneDepth"), 1);
+
+            glUniform2f(post.getUniformLocation("uvScale"), float(sceneWidth) / target.width, float(sceneHeight) / target.height);
+            glUniform2f(post.getUniformLocation("texelSize"), 1.f / target.width, 1.f / target.height);
+            glUniform1f(post.getUniformLocation("sharpness"), sharpness);
+            glUniformMatrix4fv(post.getUniformLocation("inverseProjection"), 1, GL_FALSE, value_ptr(inverseProjection));
+            glUniform1f(post.getUniformLocation("time"), time);
+            glUniform1f(post.getUniformLocation("exposure"), exposure);
+            glUniform1f(post.getUniformLocation("fogStart"), fogStart);
+            glUniform1f(post.getUniformLocation("fogEnd"), fogEnd);
+            glUniform3fv(post.getUniformLocation("fogColor"), 1, value_ptr(fogColor));
+
+            glBindVertexArray(emptyVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            glEnable(GL_DEPTH_TEST);
+        }
+    };
+}
+
+#endif // !POST_PROCESS_HPP
@@ -0,0 +1,513 @@
+#ifndef SCENE_FILE_HPP
+#define SCENE_FILE_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace scene
+{
+    using namespace glm;
+
+    // what gets loaded and where it goes, instead of hardcoding it in main(). written by hand as text (see
+    // Scenes/tanks.scene for the syntax) and compiled to a binary copy in ModelCache/ the first time it's
+    // loaded, later loads read the binary while the text's hash still matches. a compiled file can also be
+    // loaded on its own. placements point at assets by index, so each mesh and texture is loaded once
+    // however many times it's placed
+    class SceneFile
+    {
+    public:
+        // mesh plus its textures, names are only for the text form and the window title
+        struct Asset
+        {
+            std::string name;
+            std::string model;
+            std::string texture;
+            std::string normal;
+        };
+
+        enum PlacementFlags : uint32_t
+        {
+            Player = 1 << 0, // the tank we drive, everything else never moves
+        };
+
+        // plain data, the binary form stores these as they are
+        struct Placement
+        {
+            uint32_t asset;
+            uint32_t flags;
+            vec3 position; // y is the height above the ground
+            vec3 rotation; // euler degrees, x then y then z
+            vec3 scale;
+        };
+
+        enum LightType : uint32_t
+        {
+            Directional = 0,
+            Point = 1,
+        };
+
+        enum LightFlags : uint32_t
+        {
+            Attached = 1 << 0, // rides on the player, position is an offset in its heading frame
+        };
+
+        struct Light
+        {
+            std::string name; // struct name in the shader
+            uint32_t type;
+            uint32_t flags;
+            vec3 vector; // direction or position
+            float ambientStr;
+            float specStr;
+            float specPhong;
+            vec3 color;
+            vec3 ambientColor;
+        };
+
+        enum CameraRole : uint32_t
+        {
+            ThirdPerson = 0,
+            FirstPerson = 1,
+            Top = 2,
+        };
+
+        struct Camera
+        {
+            uint32_t role;
+            float fov;
+            vec3 position;
+            vec3 rotation;
+        };
+
+        static constexpr uint32_t magic = 0x43534447; // "GDSC"
+        static constexpr uint32_t version = 1;
+
+        std::vector<Asset> assets;
+        std::vector<Placement> placements;
+        std::vector<Light> lights;
+        std::vector<Camera> cameras;
+
+    private:
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;
+            uint32_t assetCount;
+            uint32_t placementCount;
+            uint32_t lightCount;
+            uint32_t cameraCount;
+            uint32_t stringBytes;
+            uint32_t padding;
+        };
+
+        struct AssetRecord
+        {
+            uint32_t name, model, texture, normal; // offsets into the string block
+        };
+
+        struct LightRecord
+        {
+            uint32_t name;
+            uint32_t type;
+            uint32_t flags;
+            float values[12]; // vector, strengths, phong, color, ambient color
+        };
+
+        static_assert(sizeof(Placement) == 44, "placements are read straight into memory");
+
+    public:
+        // a text scene (.scene, using the compiled copy when it's current) or a compiled one
+        bool load(const std::string &path)
+        {
+            clear();
+            std::string text;
+            if (!readFile(path, text))
+            {
+                std::cout << "Error loading scene file! " << path << std::endl;
+                return false;
+            }
+
+            if (text.size() >= sizeof(Header) && *(const uint32_t *)text.data() == magic)
+                return readBinary(text, 0, path);
+
+            uint64_t hash = hashText(text);
+            std::string compiledPath = getCompiledPath(path);
+            std::string compiled;
+            if (readFile(compiledPath, compiled) && readBinary(compiled, hash, compiledPath))
+                return true;
+
+            clear();
+            if (!parseText(text, path))
+                return false;
+            save(compiledPath, hash);
+            return true;
+        }
+
+        // text form, one entry per line:
+        //   asset <name> <model> [texture] [normal]                 "-" leaves a texture out
+        //   place <asset> <x y z> [rx ry rz] [sx sy sz]             rotation in degrees, y above the ground
+        //   player <asset> <x y z> [rx ry rz] [sx sy sz]
+        //   dirlight <name> <dx dy dz> <ambient> <spec> <phong> <r g b> <ambient r g b>
+        //   pointlight <name> <x y z> <ambient> <spec> <phong> <r g b> <ambient r g b> [attached]
+        //   camera <third|first|top> <fov> <x y z> [rx ry rz]
+        // # starts a comment, paths with spaces go in quotes. bad lines are reported and skipped
+        bool parseText(const std::string &text, const std::string &path)
+        {
+            std::unordered_map<std::string, uint32_t> assetsByName;
+            std::unordered_map<std::string, uint32_t> assetsByFiles;
+            std::vector<std::string> tokens;
+            int lineNumber = 0;
+
+            size_t lineStart = 0;
+            while (lineStart < text.size())
+            {
+                size_t lineEnd = text.find('\n', lineStart);
+                if (lineEnd == std::string::npos)
+                    lineEnd = text.size();
+                lineNumber++;
+                tokenize(text, lineStart, lineEnd, tokens);
+                lineStart = lineEnd + 1;
+                if (tokens.empty())
+                    continue;
+
+                auto fail = [&](const char *message)
+                {
+                    std::cout << "Error in scene file! " << path << ":" << lineNumber << " " << message << std::endl;
+                };
+                const std::string &keyword = tokens[0];
+
+                if (keyword == "asset")
+                {
+                    if (tokens.size() < 3 || tokens.size() > 5)
+                    {
+                        fail("asset needs a name and a model");
+                        continue;
+                    }
+                    if (assetsByName.count(tokens[1]))
+                    {
+                        fail("asset name used twice");
+                        continue;
+                    }
+                    Asset asset{tokens[1], tokens[2], optionalPath(tokens, 3), optionalPath(tokens, 4)};
+
+                    // the same files under another name share one load
+                    std::string files = asset.model + '\n' + asset.texture + '\n' + asset.normal;
+                    auto found = assetsByFiles.find(files);
+                    if (found != assetsByFiles.end())
+                    {
+                        assetsByName[asset.name] = found->second;
+                        continue;
+                    }
+                    uint32_t index = uint32_t(assets.size());
+                    assets.push_back(asset);
+                    assetsByName[asset.name] = index;
+                    assetsByFiles[files] = index;
+                }
+                else if (keyword == "place" || keyword == "player")
+                {
+                    auto found = assetsByName.find(tokens.size() > 1 ? tokens[1] : "");
+                    if (found == assetsByName.end())
+                    {
+                        fail("placement of an unknown asset (assets have to come first)");
+                        continue;
+                    }
+                    Placement placement{found->second, keyword == "player" ? uint32_t(Player) : 0u, vec3(0.f), vec3(0.f), vec3(1.f)};
+                    if ((tokens.size() != 5 && tokens.size() != 8 && tokens.size() != 11) ||
+                        !readVec3(tokens, 2, placement.position) ||
+                        (tokens.size() > 5 && !readVec3(tokens, 5, placement.rotation)) ||
+                        (tokens.size() > 8 && !readVec3(tokens, 8, placement.scale)))
+                    {
+                        fail("placement needs a position, then optionally a rotation and a scale");
+                        continue;
+                    }
+                    placements.push_back(placement);
+                }
+                else if (keyword == "dirlight" || keyword == "pointlight")
+                {
+                    Light light;
+                    light.type = keyword == "dirlight" ? Directional : Point;
+                    light.flags = 0;
+                    size_t count = tokens.size();
+                    if (light.type == Point && count == 15 && tokens[14] == "attached")
+                    {
+                        light.flags |= Attached;
+                        count--;
+                    }
+                    if (count != 14 || !readVec3(tokens, 2, light.vector) || !readFloat(tokens[5], light.ambientStr) ||
+                        !readFloat(tokens[6], light.specStr) || !readFloat(tokens[7], light.specPhong) ||
+                        !readVec3(tokens, 8, light.color) || !readVec3(tokens, 11, light.ambientColor))
+                    {
+                        fail("light needs a name, vector, ambient, spec, phong, color and ambient color");
+                        continue;
+                    }
+                    light.name = tokens[1];
+                    lights.push_back(light);
+                }
+                else if (keyword == "camera")
+                {
+                    Camera camera{0, 60.f, vec3(0.f), vec3(0.f)};
+                    bool roleKnown = tokens.size() > 1 && readRole(tokens[1], camera.role);
+                    if (!roleKnown || (tokens.size() != 6 && tokens.size() != 9) || !readFloat(tokens[2], camera.fov) ||
+                        !readVec3(tokens, 3, camera.position) || (tokens.size() > 6 && !readVec3(tokens, 6, camera.rotation)))
+                    {
+                        fail("camera needs third, first or top, a fov and a position, then optionally a rotation");
+                        continue;
+                    }
+                    cameras.push_back(camera);
+                }
+                else
+                    fail("unknown keyword");
+            }
+            return true;
+        }
+
+        // the compiled form: header, string block, then each table as fixed size records
+        bool save(const std::string &path, uint64_t sourceHash) const
+        {
+            std::string strings(1, '\0'); // offset 0 is the empty string
+            auto addString = [&strings](const std::string &value)
+            {
+                if (value.empty())
+                    return uint32_t(0);
+                uint32_t offset = uint32_t(strings.size());
+                strings.append(value).push_back('\0');
+                return offset;
+            };
+
+            std::vector<AssetRecord> assetRecords;
+            for (const Asset &asset : assets)
+                assetRecords.push_back({addString(asset.name), addString(asset.model), addString(asset.texture), addString(asset.normal)});
+
+            std::vector<LightRecord> lightRecords;
+            for (const Light &light : lights)
+            {
+                LightRecord record{addString(light.name), light.type, light.flags, {}};
+                const float values[12]{light.vector.x, light.vector.y, light.vector.z, light.ambientStr, light.specStr, light.specPhong,
+                                       light.color.x, light.color.y, light.color.z, light.ambientColor.x, light.ambientColor.y, light.ambientColor.z};
+                std::copy(values, values + 12, record.values);
+                lightRecords.push_back(record);
+            }
+            strings.resize((strings.size() + 3) & ~size_t(3), '\0');
+
+            Header header{magic, version, sourceHash, uint32_t(assets.size()), uint32_t(placements.size()), uint32_t(lights.size()),
+                          uint32_t(cameras.size()), uint32_t(strings.size()), 0};
+
+            std::error_code error;
+            std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+            // temp file first so a crash never leaves half a scene behind
+            std::string tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                file.write((const char *)&header, sizeof(header));
+                file.write(strings.data(), strings.size());
+                file.write((const char *)assetRecords.data(), assetRecords.size() * sizeof(AssetRecord));
+                file.write((const char *)placements.data(), placements.size() * sizeof(Placement));
+                file.write((const char *)lightRecords.data(), lightRecords.size() * sizeof(LightRecord));
+                file.write((const char *)cameras.data(), cameras.size() * sizeof(Camera));
+                if (!file)
+                    return false;
+            }
+            std::filesystem::rename(tempPath, path, error);
+            return !error;
+        }
+
+        void clear()
+        {
+            assets.clear();
+            placements.clear();
+            lights.clear();
+            cameras.clear();
+        }
+
+        // index of the player's placement, -1 if there isn't one
+        int getPlayer() const
+        {
+            for (size_t i = 0; i < placements.size(); i++)
+            {
+                if (placements[i].flags & Player)
+                    return int(i);
+            }
+            return -1;
+        }
+
+        const Camera *getCamera(uint32_t role) const
+        {
+            for (const Camera &camera : cameras)
+            {
+                if (camera.role == role)
+                    return &camera;
+            }
+            return nullptr;
+        }
+
+        static std::string getCompiledPath(const std::string &path)
+        {
+            return "ModelCache/" + std::filesystem::path(path).stem().string() + ".sceneb";
+        }
+
+        // fnv-1a of the text, decides whether the compiled copy is still current
+        static uint64_t hashText(const std::string &text)
+        {
+            uint64_t h = 14695981039346656037ull ^ version;
+            for (unsigned char c : text)
+            {
+                h ^= c;
+                h *= 1099511628211ull;
+            }
+            return h;
+        }
+
+    private:
+        // sourceHash 0 takes any compiled file, otherwise it has to have been compiled from that text
+        bool readBinary(const std::string &data, uint64_t sourceHash, const std::string &path)
+        {
+            Header header;
+            if (data.size() < sizeof(header))
+                return false;
+            std::copy(data.data(), data.data() + sizeof(header), (char *)&header);
+            if (header.magic != magic || header.version != version || (sourceHash && header.sourceHash != sourceHash))
+                return false;
+
+            size_t stringsAt = sizeof(header);
+            size_t assetsAt = stringsAt + header.stringBytes;
+            size_t placementsAt = assetsAt + size_t(header.assetCount) * sizeof(AssetRecord);
+            size_t lightsAt = placementsAt + size_t(header.placementCount) * sizeof(Placement);
+            size_t camerasAt = lightsAt + size_t(header.lightCount) * sizeof(LightRecord);
+            size_t end = camerasAt + size_t(header.cameraCount) * sizeof(Camera);
+            if (end != data.size() || header.stringBytes == 0 || data[stringsAt + header.stringBytes - 1] != '\0')
+            {
+                std::cout << "Error loading scene file! " << path << " is truncated" << std::endl;
+                return false;
+            }
+
+            const char *strings = data.data() + stringsAt;
+            auto getString = [&](uint32_t offset)
+            {
+                return offset < header.stringBytes ? std::string(strings + offset) : std::string();
+            };
+
+            assets.resize(header.assetCount);
+            for (uint32_t i = 0; i < header.assetCount; i++)
+            {
+                AssetRecord record;
+                std::copy(data.data() + assetsAt + i * sizeof(record), data.data() + assetsAt + (i + 1) * sizeof(record), (char *)&record);
+                assets[i] = {getString(record.name), getString(record.model), getString(record.texture), getString(record.normal)};
+            }
+
+            // the bulk of a big scene, one copy
+            placements.resize(header.placementCount);
+            std::copy(data.data() + placementsAt, data.data() + lightsAt, (char *)placements.data());
+
+            lights.resize(header.lightCount);
+            for (uint32_t i = 0; i < header.lightCount; i++)
+            {
+                LightRecord record;
+                std::copy(data.data() + lightsAt + i * sizeof(record), data.data() + lightsAt + (i + 1) * sizeof(record), (char *)&record);
+                const float *v = record.values;
+                lights[i] = {getString(record.name), record.type, record.flags, vec3(v[0], v[1], v[2]), v[3], v[4], v[5],
+                             vec3(v[6], v[7], v[8]), vec3(v[9], v[10], v[11])};
+            }
+
+            cameras.resize(header.cameraCount);
+            std::copy(data.data() + camerasAt, data.data() + end, (char *)cameras.data());
+
+            for (const Placement &placement : placements)
+            {
+                if (placement.asset >= assets.size())
+                {
+                    std::cout << "Error loading scene file! " << path << " places an asset it doesn't have" << std::endl;
+                    clear();
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        static bool readFile(const std::string &path, std::string &data)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+                return false;
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            data = contents.str();
+            return true;
+        }
+
+        // whitespace separated, "quoted" tokens may have spaces, # comments out the rest
+        static void tokenize(const std::string &text, size_t first, size_t last, std::vector<std::string> &tokens)
+        {
+            tokens.clear();
+            size_t i = first;
+            while (i < last)
+            {
+                char c = text[i];
+                if (c == '#')
+                    break;
+                if (c == ' ' || c == '\t' || c == '\r')
+                {
+                    i++;
+                    continue;
+                }
+
+                size_t start = i;
+                if (c == '"')
+                {
+                    size_t close = text.find('"', i + 1);
+                    if (close == std::string::npos || close > last)
+                        close = last;
+                    tokens.emplace_back(text, start + 1, close - start - 1);
+                    i = close + 1;
+                    continue;
+                }
+                while (i < last && text[i] != ' ' && text[i] != '\t' && text[i] != '\r' && text[i] != '#')
+                    i++;
+                tokens.emplace_back(text, start, i - start);
+            }
+        }
+
+        static std::string optionalPath(const std::vector<std::string> &tokens, size_t index)
+        {
+            return index < tokens.size() && tokens[index] != "-" ? tokens[index] : std::string();
+        }
+
+        static bool readFloat(const std::string &token, float &value)
+        {
+            char *end;
+            value = std::strtof(token.c_str(), &end);
+            return end != token.c_str() && *end == '\0';
+        }
+
+        static bool readVec3(const std::vector<std::string> &tokens, size_t first, vec3 &value)
+        {
+            return first + 3 <= tokens.size() && readFloat(tokens[first], value.x) && readFloat(tokens[first + 1], value.y) &&
+                   readFloat(tokens[first + 2], value.z);
+        }
+
+        static bool readRole(const std::string &token, uint32_t &role)
+        {
+            if (token == "third")
+                role = ThirdPerson;
+            else if (token == "first")
+                role = FirstPerson;
+            else if (token == "top")
+                role = Top;
+            else
+                return false;
+            return true;
+        }
+    };
+} // namespace scene
+
+#endif // !SCENE_FILE_HPP
@@ -0,0 +1,80 @@
+#ifndef SCENE_GRAPH_HPP
+#define SCENE_GRAPH_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace scene
+{
+    using namespace glm;
+
+    // transform hierarchy for things that ride along with something else (cameras and lights on the tank,
+    // turret and barrel on the hull). nodes are stored in topological order, a parent always before its
+    // children, so one front to back pass over flat arrays updates everything: a node's world matrix is only
+    // recomputed when its own local matrix changed or its parent's world matrix did, untouched subtrees cost
+    // a flag test per node. parents have to exist before their children, nodes can't be moved to another parent
+    class SceneGraph
+    {
+    public:
+        static constexpr int root = -1;
+
+    private:
+        std::vector<int> parents;
+        std::vector<mat4> localMatrices;
+        std::vector<mat4> worldMatrices;
+        std::vector<uint8_t> dirty;   // local matrix changed since the last update
+        std::vector<uint8_t> changed; // world matrix changed in the current update
+        int lastUpdateCount = 0;
+
+    public:
+        int createNode(int parent = root, const mat4 &localMatrix = mat4(1.f))
+        {
+            parents.push_back(parent);
+            localMatrices.push_back(localMatrix);
+            worldMatrices.push_back(localMatrix);
+            dirty.push_back(1);
+            changed.push_back(0);
+            return int(parents.size()) - 1;
+        }
+
+        // only marks the node dirty if the matrix is different
+        void setLocalMatrix(int node, const mat4 &localMatrix)
+        {
+            if (localMatrices[node] == localMatrix)
+                return;
+            localMatrices[node] = localMatrix;
+            dirty[node] = 1;
+        }
+
+        // recompute the world matrices of dirty nodes and everything under them
+        void update()
+        {
+            lastUpdateCount = 0;
+            for (size_t node = 0; node < parents.size(); node++)
+            {
+                int parent = parents[node];
+                bool parentChanged = parent != root && changed[parent];
+                changed[node] = dirty[node] || parentChanged;
+                if (!changed[node])
+                    continue;
+
+                worldMatrices[node] = parent == root ? localMatrices[node] : worldMatrices[parent] * localMatrices[node];
+                dirty[node] = 0;
+                lastUpdateCount++;
+            }
+        }
+
+        const mat4 &getLocalMatrix(int node) const { return localMatrices[node]; }
+        const mat4 &getWorldMatrix(int node) const { return worldMatrices[node]; }
+        vec3 getWorldPosition(int node) const { return vec3(worldMatrices[node][3]); }
+        int getParent(int node) const { return parents[node]; }
+        int getNodeCount() const { return int(parents.size()); }
+
+        // nodes the last update() had to recompute
+        int getLastUpdateCount() const { return lastUpdateCount; }
+    };
+} // namespace scene
+
+#endif // !SCENE_GRAPH_HPP
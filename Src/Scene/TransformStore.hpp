@@ -0,0 +1,268 @@
+#ifndef TRANSFORM_STORE_HPP
+#define TRANSFORM_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#define TRANSFORM_STORE_SSE2
+#endif
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace scene
+{
+    using namespace glm;
+
+    // transforms of every scene object as structure of arrays: one float array per component, so four objects
+    // fill an sse register and the world matrices (same as Model3D::buildTransform, translate * scale * rotate
+    // with the rotation a unit quaternion) are built four at a time with no trig. only dirty objects are rebuilt, in blocks of four. each object also has its
+    // mesh's object space box, and its world bounds come out of the same pass for culling.
+    // arrays are padded to a multiple of four with objects that are never dirty
+    class TransformStore
+    {
+    public:
+        std::vector<float> positionX, positionY, positionZ;
+        std::vector<float> rotationX, rotationY, rotationZ, rotationW; // unit quaternion
+        std::vector<float> scaleX, scaleY, scaleZ;
+
+        // object space box as center and half size
+        std::vector<float> centerX, centerY, centerZ;
+        std::vector<float> extentX, extentY, extentZ;
+
+        // results, valid after updateWorldMatrices
+        std::vector<mat4> worldMatrices;
+        std::vector<float> worldMinX, worldMinY, worldMinZ;
+        std::vector<float> worldMaxX, worldMaxY, worldMaxZ;
+
+    private:
+        std::vector<uint8_t> dirty;
+        size_t count = 0;
+
+    public:
+        size_t size() const { return count; }
+
+        int create(const vec3 &position, const quat &rotation, const vec3 &scale, const vec3 &localMin = vec3(0.f), const vec3 &localMax = vec3(0.f))
+        {
+            if (count == worldMatrices.size())
+                grow(count + 4);
+
+            int entity = int(count++);
+            vec3 center = (localMin + localMax) * 0.5f;
+            vec3 extent = (localMax - localMin) * 0.5f;
+            centerX[entity] = center.x;
+            centerY[entity] = center.y;
+            centerZ[entity] = center.z;
+            extentX[entity] = extent.x;
+            extentY[entity] = extent.y;
+            extentZ[entity] = extent.z;
+
+            setPosition(entity, position);
+            setRotation(entity, rotation);
+            setScale(entity, scale);
+            dirty[entity] = 1;
+            return entity;
+        }
+
+        // the setters only mark the object dirty when something changed, so static ones are never rebuilt
+        void setPosition(int entity, const vec3 &position)
+        {
+            assign(entity, positionX, positionY, positionZ, position);
+        }
+
+        void setRotation(int entity, const quat &rotation)
+        {
+            if (rotationX[entity] == rotation.x && rotationY[entity] == rotation.y && rotationZ[entity] == rotation.z && rotationW[entity] == rotation.w)
+                return;
+            rotationX[entity] = rotation.x;
+            rotationY[entity] = rotation.y;
+            rotationZ[entity] = rotation.z;
+            rotationW[entity] = rotation.w;
+            dirty[entity] = 1;
+        }
+
+        void setScale(int entity, const vec3 &scale)
+        {
+            assign(entity, scaleX, scaleY, scaleZ, scale);
+        }
+
+        void setTransform(int entity, const vec3 &position, const quat &rotation, const vec3 &scale)
+        {
+            setPosition(entity, position);
+            setRotation(entity, rotation);
+            setScale(entity, scale);
+        }
+
+        // object space box, when the mesh behind an object changes
+        void setLocalBounds(int entity, const vec3 &localMin, const vec3 &localMax)
+        {
+            assign(entity, centerX, centerY, centerZ, (localMin + localMax) * 0.5f);
+            assign(entity, extentX, extentY, extentZ, (localMax - localMin) * 0.5f);
+        }
+
+        vec3 getPosition(int entity) const { return vec3(positionX[entity], positionY[entity], positionZ[entity]); }
+        quat getRotation(int entity) const { return quat(rotationW[entity], rotationX[entity], rotationY[entity], rotationZ[entity]); }
+        vec3 getScale(int entity) const { return vec3(scaleX[entity], scaleY[entity], scaleZ[entity]); }
+        const mat4 &getWorldMatrix(int entity) const { return worldMatrices[entity]; }
+
+        void getWorldBounds(int entity, vec3 &minBounds, vec3 &maxBounds) const
+        {
+            minBounds = vec3(worldMinX[entity], worldMinY[entity], worldMinZ[entity]);
+            maxBounds = vec3(worldMaxX[entity], worldMaxY[entity], worldMaxZ[entity]);
+        }
+
+        bool isDirty(int entity) const { return dirty[entity] != 0; }
+        void markAllDirty()
+        {
+            for (size_t i = 0; i < count; i++)
+                dirty[i] = 1;
+        }
+
+        // rebuild the world matrix and bounds of everything dirty, returns how many blocks of four it took
+        size_t updateWorldMatrices()
+        {
+            size_t blocks = 0;
+            for (size_t first = 0; first < count; first += 4)
+            {
+                // one flag test per block, padding is never dirty
+                uint32_t flags;
+                std::memcpy(&flags, &dirty[first], sizeof(flags));
+                if (!flags)
+                    continue;
+
+                updateBlock(first);
+                std::memset(&dirty[first], 0, 4);
+                blocks++;
+            }
+            return blocks;
+        }
+
+    private:
+        void assign(int entity, std::vector<float> &x, std::vector<float> &y, std::vector<float> &z, const vec3 &value)
+        {
+            if (x[entity] == value.x && y[entity] == value.y && z[entity] == value.z)
+                return;
+            x[entity] = value.x;
+            y[entity] = value.y;
+            z[entity] = value.z;
+            dirty[entity] = 1;
+        }
+
+        void grow(size_t capacity)
+        {
+            for (std::vector<float> *array : {&positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ,
+                                              &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ,
+                                              &worldMinX, &worldMinY, &worldMinZ, &worldMaxX, &worldMaxY, &worldMaxZ})
+                array->resize(capacity, 0.f);
+            rotationW.resize(capacity, 1.f);
+            scaleX.resize(capacity, 1.f);
+            scaleY.resize(capacity, 1.f);
+            scaleZ.resize(capacity, 1.f);
+            worldMatrices.resize(capacity, mat4(1.f));
+            dirty.resize(capacity, 0);
+        }
+
+#ifdef TRANSFORM_STORE_SSE2
+        static __m128 absolute(__m128 value)
+        {
+            return _mm_andnot_ps(_mm_set1_ps(-0.f), value);
+        }
+
+        void updateBlock(size_t first)
+        {
+            __m128 qx = _mm_loadu_ps(&rotationX[first]);
+            __m128 qy = _mm_loadu_ps(&rotationY[first]);
+            __m128 qz = _mm_loadu_ps(&rotationZ[first]);
+            __m128 qw = _mm_loadu_ps(&rotationW[first]);
+            __m128 sx = _mm_loadu_ps(&scaleX[first]);
+            __m128 sy = _mm_loadu_ps(&scaleY[first]);
+            __m128 sz = _mm_loadu_ps(&scaleZ[first]);
+
+            // rotation matrix of each quaternion, rows scaled by their axis' scale
+            __m128 one = _mm_set1_ps(1.f), two = _mm_set1_ps(2.f);
+            __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+            __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+            __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+            __m128 m00 = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+            __m128 m01 = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xy, wz)));
+            __m128 m02 = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xz, wy)));
+            __m128 m10 = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(xy, wz)));
+            __m128 m11 = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))));
+            __m128 m12 = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(yz, wx)));
+            __m128 m20 = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(xz, wy)));
+            __m128 m21 = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(yz, wx)));
+            __m128 m22 = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+            __m128 tx = _mm_loadu_ps(&positionX[first]);
+            __m128 ty = _mm_loadu_ps(&positionY[first]);
+            __m128 tz = _mm_loadu_ps(&positionZ[first]);
+
+            // world box: transformed center, extents grown by the absolute matrix
+            __m128 cx = _mm_loadu_ps(&centerX[first]), cy = _mm_loadu_ps(&centerY[first]), cz = _mm_loadu_ps(&centerZ[first]);
+            __m128 ex = _mm_loadu_ps(&extentX[first]), ey = _mm_loadu_ps(&extentY[first]), ez = _mm_loadu_ps(&extentZ[first]);
+            __m128 worldX = _mm_add_ps(tx, _mm_add_ps(_mm_mul_ps(m00, cx), _mm_add_ps(_mm_mul_ps(m01, cy), _mm_mul_ps(m02, cz))));
+            __m128 worldY = _mm_add_ps(ty, _mm_add_ps(_mm_mul_ps(m10, cx), _mm_add_ps(_mm_mul_ps(m11, cy), _mm_mul_ps(m12, cz))));
+            __m128 worldZ = _mm_add_ps(tz, _mm_add_ps(_mm_mul_ps(m20, cx), _mm_add_ps(_mm_mul_ps(m21, cy), _mm_mul_ps(m22, cz))));
+            __m128 spanX = _mm_add_ps(_mm_mul_ps(absolute(m00), ex), _mm_add_ps(_mm_mul_ps(absolute(m01), ey), _mm_mul_ps(absolute(m02), ez)));
+            __m128 spanY = _mm_add_ps(_mm_mul_ps(absolute(m10), ex), _mm_add_ps(_mm_mul_ps(absolute(m11), ey), _mm_mul_ps(absolute(m12), ez)));
+            __m128 spanZ = _mm_add_ps(_mm_mul_ps(absolute(m20), ex), _mm_add_ps(_mm_mul_ps(absolute(m21), ey), _mm_mul_ps(absolute(m22), ez)));
+            _mm_storeu_ps(&worldMinX[first], _mm_sub_ps(worldX, spanX));
+            _mm_storeu_ps(&worldMinY[first], _mm_sub_ps(worldY, spanY));
+            _mm_storeu_ps(&worldMinZ[first], _mm_sub_ps(worldZ, spanZ));
+            _mm_storeu_ps(&worldMaxX[first], _mm_add_ps(worldX, spanX));
+            _mm_storeu_ps(&worldMaxY[first], _mm_add_ps(worldY, spanY));
+            _mm_storeu_ps(&worldMaxZ[first], _mm_add_ps(worldZ, spanZ));
+
+            // each transpose turns one column's x, y, z, w across four objects into that column of each matrix
+            __m128 zero = _mm_setzero_ps();
+            __m128 column0[4] = {m00, m10, m20, zero};
+            __m128 column1[4] = {m01, m11, m21, zero};
+            __m128 column2[4] = {m02, m12, m22, zero};
+            __m128 column3[4] = {tx, ty, tz, one};
+            _MM_TRANSPOSE4_PS(column0[0], column0[1], column0[2], column0[3]);
+            _MM_TRANSPOSE4_PS(column1[0], column1[1], column1[2], column1[3]);
+            _MM_TRANSPOSE4_PS(column2[0], column2[1], column2[2], column2[3]);
+            _MM_TRANSPOSE4_PS(column3[0], column3[1], column3[2], column3[3]);
+
+            for (int lane = 0; lane < 4; lane++)
+            {
+                float *matrix = &worldMatrices[first + lane][0][0];
+                _mm_storeu_ps(matrix, column0[lane]);
+                _mm_storeu_ps(matrix + 4, column1[lane]);
+                _mm_storeu_ps(matrix + 8, column2[lane]);
+                _mm_storeu_ps(matrix + 12, column3[lane]);
+            }
+        }
+#else
+        void updateBlock(size_t first)
+        {
+            for (size_t i = first; i < first + 4; i++)
+            {
+                mat3 rotation = mat3_cast(quat(rotationW[i], rotationX[i], rotationY[i], rotationZ[i]));
+                vec3 scale(scaleX[i], scaleY[i], scaleZ[i]);
+
+                mat4 &matrix = worldMatrices[i];
+                matrix[0] = vec4(rotation[0] * scale, 0.f);
+                matrix[1] = vec4(rotation[1] * scale, 0.f);
+                matrix[2] = vec4(rotation[2] * scale, 0.f);
+                matrix[3] = vec4(positionX[i], positionY[i], positionZ[i], 1.f);
+
+                vec3 center = vec3(matrix * vec4(centerX[i], centerY[i], centerZ[i], 1.f));
+                vec3 span = abs(vec3(matrix[0])) * extentX[i] + abs(vec3(matrix[1])) * extentY[i] + abs(vec3(matrix[2])) * extentZ[i];
+                worldMinX[i] = center.x - span.x;
+                worldMinY[i] = center.y - span.y;
+                worldMinZ[i] = center.z - span.z;
+                worldMaxX[i] = center.x + span.x;
+                worldMaxY[i] = center.y + span.y;
+                worldMaxZ[i] = center.z + span.z;
+            }
+        }
+#endif
+    };
+} // namespace scene
+
+#endif // !TRANSFORM_STORE_HPP
@@ -1,51 +1,465 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Assets/AssetArchive.hpp"
+#include "../Profiling/AllocationTracker.hpp"
+#include "../Profiling/Profiler.hpp"
+
+// program binaries are core in 4.1 (or ARB_get_program_binary), glad is only generated for 3.3
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
 namespace shader
 {
     using namespace glm;
+
+    // linked programs saved to disk so later launches skip compiling. entries are named by a hash of
+    // everything that goes into the binary, so editing a shader or changing driver just misses the cache
+    class ProgramCache
+    {
+    private:
+        typedef void(APIENTRYP GetProgramBinaryProc)(GLuint, GLsizei, GLsizei *, GLenum *, void *);
+        typedef void(APIENTRYP ProgramBinaryProc)(GLuint, GLenum, const void *, GLsizei);
+        typedef void(APIENTRYP ProgramParameteriProc)(GLuint, GLenum, GLint);
+
+        static const uint32_t magic = 0x52484350; // "PCHR"
+
+        GetProgramBinaryProc getProgramBinary = nullptr;
+        ProgramBinaryProc programBinary = nullptr;
+        ProgramParameteriProc programParameteri = nullptr;
+        bool supported = false;
+        std::string driver;
+
+    public:
+        std::string directory = "ShaderCache";
+        bool enabled = true;
+
+    public:
+        // needs a current context, so this is first called once glad is loaded
+        static ProgramCache &get()
+        {
+            static ProgramCache cache;
+            return cache;
+        }
+
+        bool isSupported() const { return enabled && supported; }
+
+        // fnv-1a, chained so several strings can go into one key
+        static uint64_t hash(const std::string &text, uint64_t seed = 14695981039346656037ull)
+        {
+            uint64_t h = seed;
+            for (unsigned char c : text)
+            {
+                h ^= c;
+                h *= 1099511628211ull;
+            }
+            // separator so ("ab", "c") and ("a", "bc") don't collide
+            h ^= 0xff;
+            h *= 1099511628211ull;
+            return h;
+        }
+
+        uint64_t makeKey(const std::string &vert, const std::string &frag, const std::string &defines) const
+        {
+            return hash(driver, hash(defines, hash(frag, hash(vert))));
+        }
+
+        // true if program now holds a working program from the cache
+        bool load(uint64_t key, GLuint program)
+        {
+            if (!isSupported())
+                return false;
+
+            std::ifstream file(getPath(key), std::ios::binary);
+            if (!file)
+                return false;
+
+            uint32_t fileMagic = 0;
+            GLenum format = 0;
+            uint32_t length = 0;
+            file.read((char *)&fileMagic, sizeof(fileMagic));
+            file.read((char *)&format, sizeof(format));
+            file.read((char *)&length, sizeof(length));
+            if (!file || fileMagic != magic || length == 0)
+                return false;
+
+            std::vector<char> binary(length);
+            if (!file.read(binary.data(), length))
+                return false;
+
+            programBinary(program, format, binary.data(), (GLsizei)length);
+
+            // the driver refuses binaries it can no longer use (e.g. after an update that kept the same strings)
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            return linked == GL_TRUE;
+        }
+
+        // call before linking so the driver keeps the binary around
+        void prepare(GLuint program)
+        {
+            if (isSupported())
+                programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        void store(uint64_t key, GLuint program)
+        {
+            if (!isSupported())
+                return;
+
+            GLint length = 0;
+            glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+            if (length <= 0)
+                return;
+
+            std::vector<char> binary(length);
+            GLenum format = 0;
+            getProgramBinary(program, length, nullptr, &format, binary.data());
+
+            std::error_code error;
+            std::filesystem::create_directories(directory, error);
+
+            // write to a temp file first so a crash never leaves half an entry behind
+            std::string path = getPath(key);
+            std::string tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                uint32_t size = (uint32_t)length;
+                file.write((const char *)&magic, sizeof(magic));
+                file.write((const char *)&format, sizeof(format));
+                file.write((const char *)&size, sizeof(size));
+                file.write(binary.data(), length);
+                if (!file)
+                {
+                    std::cout << "couldn't write shader cache entry " << path << std::endl;
+                    return;
+                }
+            }
+            std::filesystem::rename(tempPath, path, error);
+        }
+
+    private:
+        ProgramCache()
+        {
+            getProgramBinary = (GetProgramBinaryProc)glfwGetProcAddress("glGetProgramBinary");
+            programBinary = (ProgramBinaryProc)glfwGetProcAddress("glProgramBinary");
+            programParameteri = (ProgramParameteriProc)glfwGetProcAddress("glProgramParameteri");
+
+            GLint formats = 0;
+            if (getProgramBinary && programBinary && programParameteri)
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            supported = formats > 0;
+
+            const char *strings[] = {(const char *)glGetString(GL_VENDOR),
+                                     (const char *)glGetString(GL_RENDERER),
+                                     (const char *)glGetString(GL_VERSION)};
+            for (const char *s : strings)
+            {
+                driver += s ? s : "?";
+                driver += '\n';
+            }
+
+            if (!supported)
+                std::cout << "program binaries not supported, shaders will compile every launch" << std::endl;
+        }
+
+        std::string getPath(uint64_t key) const
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+            return directory + "/" + name;
+        }
+    };
+
     class Shader
     {
     public:
-        // where the shader program gets stored
+        // where the shader program gets stored. hot reloading swaps this for a new program
         GLuint shaderProgram;
 
+    private:
+        std::string vertPath;
+        std::string fragPath;
+        std::string defines;
+        std::string vertSource;
+        std::string fragSource;
+
+        // filled as locations are asked for, cleared whenever the program is swapped
+        std::unordered_map<std::string, GLint> uniformLocations;
+        std::string lookupName; // literal names are copied in here to look them up, so long ones don't allocate every call
+
     public:
-        Shader(std::string vert, std::string frag)
-        {
-            std::fstream vertSrc(vert);
-            std::fstream fragSrc(frag);
-            // vertex shader file
-            std::stringstream vertBuff;
-            vertBuff << vertSrc.rdbuf();
-            std::string vertS = vertBuff.str();
-            const char *v = vertS.c_str();
-
-            // frag shader file
-            std::stringstream fragBuff;
-            fragBuff << fragSrc.rdbuf();
-            std::string fragS = fragBuff.str();
-            const char *f = fragS.c_str();
-
-            // vertex shader creation
-            GLuint vertShader = glCreateShader(GL_VERTEX_SHADER);
-            glShaderSource(vertShader, 1, &v, NULL);
-            glCompileShader(vertShader);
-
-            // frag shader creation
-            GLuint fragShader = glCreateShader(GL_FRAGMENT_SHADER);
-            glShaderSource(fragShader, 1, &f, NULL);
-            glCompileShader(fragShader);
+        // defines are extra lines (e.g. "#define FOO\n") inserted after the #version line.
+        // a non empty vertText/fragText is used instead of reading that file (a source hot reloading already read)
+        Shader(std::string vert, std::string frag, std::string defines = "", const std::string &vertText = "", const std::string &fragText = "")
+            : vertPath(vert), fragPath(frag), defines(defines)
+        {
+            PROFILE_SCOPE("Load Shader");
+
+            vertSource = vertText.empty() ? readFile(vert) : vertText;
+            fragSource = fragText.empty() ? readFile(frag) : fragText;
 
             // creation of the shader program
             shaderProgram = glCreateProgram();
+            build(shaderProgram);
+        }
+
+        GLint getUniformLocation(const std::string &name)
+        {
+            auto found = uniformLocations.find(name);
+            if (found != uniformLocations.end())
+                return found->second;
+
+            GLint location = glGetUniformLocation(shaderProgram, name.c_str());
+            uniformLocations.emplace(name, location);
+            return location;
+        }
+
+        GLint getUniformLocation(const char *name)
+        {
+            lookupName.assign(name);
+            return getUniformLocation(lookupName);
+        }
+
+        bool usesFile(const std::string &path) const { return path == vertPath || path == fragPath; }
+
+        // rebuild with new contents for one of our source files. the old program keeps
+        // running unless the new one links, so a typo never takes the shader down
+        bool reload(const std::string &path, const std::string &source)
+        {
+            if (!usesFile(path))
+                return false;
+
+            PROFILE_SCOPE("Reload Shader");
+
+            if (path == vertPath)
+                vertSource = source;
+            if (path == fragPath)
+                fragSource = source;
+
+            GLuint program = glCreateProgram();
+            if (!build(program))
+            {
+                std::cout << "kept the previous " << vertPath << " + " << fragPath << std::endl;
+                glDeleteProgram(program);
+                return false;
+            }
+
+            glDeleteProgram(shaderProgram);
+            shaderProgram = program;
+            uniformLocations.clear();
+            return true;
+        }
+
+    private:
+        // from the cache if it's there, otherwise compiled and stored
+        bool build(GLuint program)
+        {
+            std::string vertS = injectDefines(vertSource, defines);
+            std::string fragS = injectDefines(fragSource, defines);
+
+            ProgramCache &cache = ProgramCache::get();
+            uint64_t key = cache.makeKey(vertS, fragS, defines);
+
+            if (cache.load(key, program))
+                return true;
+
+            // cache miss (or the driver rejected the binary), build it from source
+            if (!compileAndLink(program, vertS, fragS, vertPath + " + " + fragPath))
+                return false;
+
+            cache.store(key, program);
+            return true;
+        }
+
+    private:
+        static std::string readFile(const std::string &path)
+        {
+            // packed sources first, hot reloading still reads the loose files when they change
+            const assets::AssetArchive &archive = assets::AssetArchive::get();
+            if (const assets::AssetArchive::Entry *packed = archive.find(path, assets::Text))
+            {
+                std::string source(packed->size, '\0');
+                if (archive.unpack(*packed, (unsigned char *)&source[0]))
+                    return source;
+            }
+
+            std::fstream src(path);
+            if (!src)
+                std::cout << "couldn't open shader " << path << std::endl;
+
+            std::stringstream buff;
+            buff << src.rdbuf();
+            return buff.str();
+        }
+
+        // defines have to come after #version, which must stay the first line
+        static std::string injectDefines(const std::string &source, const std::string &defines)
+        {
+            if (defines.empty())
+                return source;
+
+            size_t versionLine = source.find("#version");
+            if (versionLine == std::string::npos)
+                return defines + source;
+
+            size_t lineEnd = source.find('\n', versionLine);
+            if (lineEnd == std::string::npos)
+                return source + "\n" + defines;
+
+            return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+        }
+
+        static GLuint compile(GLenum type, const std::string &source, const std::string &name)
+        {
+            const char *s = source.c_str();
+
+            GLuint shader = glCreateShader(type);
+            glShaderSource(shader, 1, &s, NULL);
+            glCompileShader(shader);
+
+            GLint compiled = GL_FALSE;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+            if (!compiled)
+            {
+                char log[1024];
+                glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+                std::cout << "failed to compile " << name << ":\n"
+                          << log << std::endl;
+            }
+            return shader;
+        }
+
+        static bool compileAndLink(GLuint shaderProgram, const std::string &vertS, const std::string &fragS, const std::string &name)
+        {
+            PROFILE_SCOPE("Compile Shader");
+
+            // vertex and frag shader creation
+            GLuint vertShader = compile(GL_VERTEX_SHADER, vertS, name);
+            GLuint fragShader = compile(GL_FRAGMENT_SHADER, fragS, name);
+
             glAttachShader(shaderProgram, vertShader);
             glAttachShader(shaderProgram, fragShader);
 
             // linking of the shader program
+            ProgramCache::get().prepare(shaderProgram);
             glLinkProgram(shaderProgram);
+
+            GLint linked = GL_FALSE;
+            glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linked);
+            if (!linked)
+            {
+                char log[1024];
+                glGetProgramInfoLog(shaderProgram, sizeof(log), NULL, log);
+                std::cout << "failed to link " << name << ":\n"
+                          << log << std::endl;
+            }
+
+            // the program keeps what it needs once linked
+            glDetachShader(shaderProgram, vertShader);
+            glDetachShader(shaderProgram, fragShader);
+            glDeleteShader(vertShader);
+            glDeleteShader(fragShader);
+
+            return linked == GL_TRUE;
         }
     };
+
+    // feature bits of Shaders/sample.*, each one adds a #define (named in sampleFeatureNames) to the variant
+    namespace feature
+    {
+        const uint32_t Texture = 1 << 0;    // HAS_TEXTURE: multiply by tex0
+        const uint32_t NormalMap = 1 << 1;  // HAS_NORMAL_MAP: perturb normals with norm_tex, otherwise use the vertex normal
+        const uint32_t DirLight = 1 << 2;   // DIR_LIGHT_COUNT 1
+        const uint32_t PointLight = 1 << 3; // POINT_LIGHT_COUNT 1
+        const uint32_t Instanced = 1 << 4;  // INSTANCED: the transform comes per instance (attributes 5-8), not from the uniform
+
+        // what a model brings, the rest is decided per frame by the scene
+        const uint32_t material = Texture | NormalMap;
+    }
+
+    static const std::vector<std::string> sampleFeatureNames = {
+        "HAS_TEXTURE", "HAS_NORMAL_MAP", "DIR_LIGHT_COUNT 1", "POINT_LIGHT_COUNT 1", "INSTANCED"};
+
+    // one source pair compiled into specialised programs, one per combination of feature bits.
+    // a variant is only compiled (or pulled from the program cache) the first time it's asked for
+    class ShaderVariants
+    {
+    private:
+        std::string vert;
+        std::string frag;
+        std::vector<std::string> featureNames;
+        std::unordered_map<uint32_t, Shader> variants;
+
+        // the last source hot reloading handed over for each file, empty until then. variants built later start
+        // from these, not from the archive or the file on disk
+        std::string vertSource;
+        std::string fragSource;
+
+    public:
+        ShaderVariants(std::string vert, std::string frag, std::vector<std::string> featureNames)
+            : vert(vert), frag(frag), featureNames(featureNames) {}
+
+        // references stay valid, variants are never removed
+        Shader &get(uint32_t features)
+        {
+            auto found = variants.find(features);
+            if (found != variants.end())
+                return found->second;
+
+            // first use of a combination, fine to allocate even in a steady frame
+            profiling::AllowAllocations allow;
+            return variants.try_emplace(features, vert, frag, getDefines(features), vertSource, fragSource).first->second;
+        }
+
+        std::string getDefines(uint32_t features) const
+        {
+            std::string defines;
+            for (size_t i = 0; i < featureNames.size(); i++)
+            {
+                if (features & (1u << i))
+                    defines += "#define " + featureNames[i] + "\n";
+            }
+            return defines;
+        }
+
+        // hand a changed source file to every variant built from it, returns how many swapped
+        int reload(const std::string &path, const std::string &source)
+        {
+            if (path == vert)
+                vertSource = source;
+            if (path == frag)
+                fragSource = source;
+
+            int reloaded = 0;
+            for (auto &variant : variants)
+            {
+                if (variant.second.reload(path, source))
+                    reloaded++;
+            }
+            return reloaded;
+        }
+
+        bool usesFile(const std::string &path) const { return path == vert || path == frag; }
+
+        size_t getVariantCount() const { return variants.size(); }
+    };
 }
 
 #endif
@@ -0,0 +1,80 @@
+#ifndef SHADER_WATCHER_HPP
+#define SHADER_WATCHER_HPP
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Core/FileWatcher.hpp"
+
+namespace shader
+{
+    // a watched file that changed, already read back in
+    struct SourceChange
+    {
+        std::string path;
+        std::string source;
+    };
+
+    // watches shader sources on a background thread (inotify on linux, polling timestamps elsewhere) and
+    // reads whatever changed. compiling needs the GL context, so the render thread picks the results up with takeChanges()
+    class ShaderWatcher
+    {
+    private:
+        gd::FileWatcher watcher;
+
+        std::mutex mutex;
+        std::vector<SourceChange> changes;
+
+    public:
+        ~ShaderWatcher() { stop(); } // before the members the callback uses go away
+
+        // add every file before start()
+        void watch(const std::string &path) { watcher.watch(path); }
+
+        void start()
+        {
+            watcher.start("Shader Watcher", [this](const std::string &path)
+                          { changed(path); });
+        }
+
+        void stop() { watcher.stop(); }
+
+        // render thread, once a frame
+        std::vector<SourceChange> takeChanges()
+        {
+            std::vector<SourceChange> taken;
+            std::lock_guard<std::mutex> lock(mutex);
+            taken.swap(changes);
+            return taken;
+        }
+
+    private:
+        void changed(const std::string &path)
+        {
+            std::ifstream file(path);
+            if (!file)
+                return; // mid-save, the write that follows will bring us back here
+
+            std::stringstream buff;
+            buff << file.rdbuf();
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            // editors often write a file more than once per save, only keep the newest
+            for (SourceChange &change : changes)
+            {
+                if (change.path == path)
+                {
+                    change.source = buff.str();
+                    return;
+                }
+            }
+            changes.push_back({path, buff.str()});
+        }
+    };
+}
+
+#endif
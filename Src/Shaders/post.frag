@@ -0,0 +1,86 @@
+#version 330 core
+
+// every post effect fused into one pass over the hdr scene, each one switched on with a #define (see gd::PostProcess)
+
+in vec2 uv;
+
+out vec4 FragColor;
+
+uniform sampler2D sceneColor;
+uniform sampler2D sceneDepth;
+
+// the scene only fills the corner of the target it was rendered into (see gd::PostProcess::renderScale)
+uniform vec2 uvScale = vec2(1.f);
+uniform vec2 texelSize;
+uniform float sharpness = 0.2f;
+
+uniform mat4 inverseProjection;
+uniform float time;
+uniform float exposure = 1.f;
+uniform float tonemapKnee = 0.8f;
+
+uniform float fogStart = 5.f;
+uniform float fogEnd = 50.f;
+uniform vec3 fogColor = vec3(0.02f, 0.02f, 0.05f);
+
+uniform float bloomLevel = 3.f;
+uniform float bloomStrength = 0.6f;
+uniform float noiseStrength = 0.08f;
+
+// view space distance of whatever was drawn at this pixel
+float viewDistance(float depth)
+{
+	vec4 ndc = vec4(uv * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+	vec4 viewPos = inverseProjection * ndc;
+	return length(viewPos.xyz / viewPos.w);
+}
+
+// scene color, kept inside the rendered area so filtering never picks up stale texels past its edge
+vec3 scene(vec2 coord)
+{
+	return texture(sceneColor, clamp(coord, texelSize * 0.5, uvScale - texelSize * 0.5)).rgb;
+}
+
+float hash(vec2 p)
+{
+	return fract(sin(dot(p, vec2(12.9898, 78.233))) * 43758.5453);
+}
+
+void main(){
+	vec2 sceneUV = uv * uvScale;
+	vec3 color = scene(sceneUV);
+
+#ifdef SHARPEN
+	// upscaling from a lower internal resolution blurs, push back against the neighbours to recover some edges
+	vec3 neighbours = scene(sceneUV + vec2(texelSize.x, 0.0)) + scene(sceneUV - vec2(texelSize.x, 0.0)) +
+	                  scene(sceneUV + vec2(0.0, texelSize.y)) + scene(sceneUV - vec2(0.0, texelSize.y));
+	color = max(color + sharpness * (4.0 * color - neighbours), 0.0);
+#endif
+
+#ifdef FOG
+	// linear fog to limit view distance, the skybox (cleared depth) stays clear
+	float depth = texture(sceneDepth, sceneUV).r;
+	if (depth < 1.0)
+	{
+		float fog_factor = clamp((viewDistance(depth) - fogStart) / (fogEnd - fogStart), 0, 1);
+		color = mix(color, fogColor, fog_factor);
+	}
+#endif
+
+#ifdef NIGHT_VISION
+	// green only, with a glow from a blurry mip of the scene and some animated grain
+	vec3 glow = textureLod(sceneColor, sceneUV, bloomLevel).rgb;
+	float green = color.g + bloomStrength * glow.g;
+	float grain = hash(gl_FragCoord.xy + fract(time) * 100.0) - 0.5;
+	color = vec3(0.f, green * (1.0 + grain * 2.0 * noiseStrength), 0.f);
+#endif
+
+	// hdr back down to the screen. untouched below the knee, brighter values roll off towards 1 instead of clipping.
+	// the top of the ldr range is compressed too, 1.0 comes out at about 0.93 with the knee at 0.8
+	color *= exposure;
+	vec3 over = max(color - tonemapKnee, 0.0);
+	vec3 rolled = tonemapKnee + (1.0 - tonemapKnee) * (1.0 - exp(-over / (1.0 - tonemapKnee)));
+	color = mix(color, rolled, step(tonemapKnee, color));
+
+	FragColor = vec4(color, 1.f);
+}
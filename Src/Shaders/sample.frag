@@ -6,15 +6,22 @@ uniform sampler2D norm_tex;
 uniform vec3 cameraPos;
 uniform vec4 rgba = vec4(1.f);
 
-uniform bool usePerspectiveCamera;
-uniform bool useThirdPersonCamera;
+// variants are specialised with #defines (see shader::feature), these are the defaults
+#ifndef DIR_LIGHT_COUNT
+#define DIR_LIGHT_COUNT 0
+#endif
+#ifndef POINT_LIGHT_COUNT
+#define POINT_LIGHT_COUNT 0
+#endif
 
 out vec4 FragColor;
 
 in vec3 normCoord;
 in vec3 fragPos;
 in vec2 texCoord;
+#ifdef HAS_NORMAL_MAP
 in mat3 TBN;
+#endif
 
 struct DirLight {
     vec3 direction;
@@ -56,72 +63,42 @@ uniform PointLight pointLight;
 vec4 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir); 
 vec4 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir); 
 
-float getFogFactor(float d)
-{
-    const float FogMax = 20.0;
-    const float FogMin = 10.0;
-
-    if (d>=FogMax) return 1;
-    if (d<=FogMin) return 0;
-
-    return 1 - (FogMax - d) / (FogMax - FogMin);
-}
-
 void main(){
 	//				     r     g      b      a
 	// FragColor = vec4(1.0f, 0.72f, 0.77f, 1.0f);
 	// FragColor = rgba;
 
 	// normal info and view direction from light source
+#ifdef HAS_NORMAL_MAP
 	vec3 normal = texture(norm_tex, texCoord).rgb;
 	normal = normalize(normal * 2.0 - 1.0);
 	normal = normalize(TBN * normal);
-	vec3 viewDir = normalize(cameraPos - fragPos);	
-
-	// calculate texture, direction light, and point light vectors
-	vec4 tex = texture(tex0, texCoord);
-	vec4 dir = CalcDirLight(dirLight, normal, viewDir);
-	vec4 point = CalcPointLight(pointLight, normal, fragPos, viewDir);
+#else
+	vec3 normal = normalize(normCoord);
+#endif
+	vec3 viewDir = normalize(cameraPos - fragPos);
 
-	vec4 light = vec4(0.f);
 	FragColor = vec4(1.f); // initialize fragColor to 1.f in case nothing gets applied
 
-	float d = distance(cameraPos, fragPos);
-	float alpha = getFogFactor(d);
-	float fog_start = 5.f;
-	float fog_end = 50.f;
+	// apply the texture
+#ifdef HAS_TEXTURE
+	FragColor *= texture(tex0, texCoord);
+#endif
 
-	// if (d > fog_end)
-	// 	discard;
-
-	//linear interpolation
-	float fog_factor = (d - fog_start) / ( fog_end - fog_start);
-	fog_factor = clamp(fog_factor, 0, 1);
-
-	// if there is a texture, apply it
-	if (all(greaterThan(tex, vec4(0.f))))
-		FragColor *= tex;
-
-	// if there is a point light, apply it
-	if (any(greaterThan(point.xyz, vec3(0.f))))
-		light += point;
-		
-	// if there is a direction light, apply it
-	if (any(greaterThan(dir.xyz, vec3(0.f))))
-		light += dir;
+	// apply whichever lights this variant was built with
+#if DIR_LIGHT_COUNT > 0 || POINT_LIGHT_COUNT > 0
+	vec4 light = vec4(0.f);
+#if DIR_LIGHT_COUNT > 0
+	light += CalcDirLight(dirLight, normal, viewDir);
+#endif
+#if POINT_LIGHT_COUNT > 0
+	light += CalcPointLight(pointLight, normal, fragPos, viewDir);
+#endif
+	FragColor *= vec4(light.rgb, 1.f);
+#endif
 
-	if (any(greaterThan(light.xyz, vec3(0.f))))
-		FragColor *= light;
-	
 	// if there's any changes to the colors, apply it
-	if (any(lessThan(rgba.xyz, vec3(1.f))))
-		FragColor *= rgba;
-
-
-	if (!useThirdPersonCamera)
-		FragColor *= vec4(0.f, 1.f, 0.f, 1.f); // simple nightvision
-	else if (usePerspectiveCamera)
-		FragColor = mix(vec4(0.02f, 0.02f, 0.05f, 1.f), FragColor, 1.f - fog_factor); // fog to limit view distance
+	FragColor *= rgba;
 }
 
 vec4 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
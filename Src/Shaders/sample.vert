@@ -6,14 +6,22 @@ layout(location = 2) in vec2 aTex;
 layout(location = 3) in vec3 m_tan;
 layout(location = 4) in vec3 m_btan;
 
+#ifdef INSTANCED
+// one placement per instance, from the batch's instance buffer
+layout(location = 5) in mat4 instanceTransform;
+#define transform instanceTransform
+#else
 uniform mat4 transform;
+#endif
 uniform mat4 view;
 uniform mat4 projection;
 
 out vec3 normCoord;
 out vec3 fragPos;
 out vec2 texCoord;
+#ifdef HAS_NORMAL_MAP
 out mat3 TBN;
+#endif
 
 void main(){
     // do the usual vertex shader things
@@ -22,8 +30,10 @@ void main(){
     texCoord = aTex;
     mat3 modelMat = mat3(transpose(inverse(transform)));
     normCoord = modelMat * vertexNormal;
+#ifdef HAS_NORMAL_MAP
     vec3 T = normalize(modelMat * m_tan);
     vec3 B = normalize(modelMat * m_btan);
     vec3 N = normalize(normCoord);
     TBN = mat3(T, B, N);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+#version 330 core
+
+// one terrain chunk, drawn with Terrain's index buffers and no vertex attributes.
+// pairs with sample.frag, so it hands over the same outputs as sample.vert
+
+// heights with one extra sample around the chunk (read with texelFetch)
+uniform sampler2D heights;
+uniform vec2 chunkOrigin;
+uniform float cellSize;
+uniform int samplesPerSide;
+uniform float textureScale;
+
+// this chunk's lod and the neighbours' (-x, +x, -z, +z)
+uniform int lod;
+uniform ivec4 neighbourLod;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 normCoord;
+out vec3 fragPos;
+out vec2 texCoord;
+
+float heightAt(ivec2 grid)
+{
+    return texelFetch(heights, grid + 1, 0).r;
+}
+
+// on an edge shared with a coarser chunk only every stride-th sample exists over there,
+// so the ones in between follow the straight line the neighbour draws
+float edgeHeight(ivec2 grid, ivec2 along, int position, int neighbour)
+{
+    int stride = 1 << max(lod, neighbour);
+    int offset = position % stride;
+    if (offset == 0)
+        return heightAt(grid);
+
+    float start = heightAt(grid - along * offset);
+    float end = heightAt(grid + along * (stride - offset));
+    return mix(start, end, float(offset) / float(stride));
+}
+
+void main(){
+    ivec2 grid = ivec2(gl_VertexID % samplesPerSide, gl_VertexID / samplesPerSide);
+    int last = samplesPerSide - 1;
+
+    float height = heightAt(grid);
+    if (grid.x == 0)
+        height = edgeHeight(grid, ivec2(0, 1), grid.y, neighbourLod.x);
+    else if (grid.x == last)
+        height = edgeHeight(grid, ivec2(0, 1), grid.y, neighbourLod.y);
+    else if (grid.y == 0)
+        height = edgeHeight(grid, ivec2(1, 0), grid.x, neighbourLod.z);
+    else if (grid.y == last)
+        height = edgeHeight(grid, ivec2(1, 0), grid.x, neighbourLod.w);
+
+    // central differences, the border samples make these match across chunks
+    float left = heightAt(grid - ivec2(1, 0));
+    float right = heightAt(grid + ivec2(1, 0));
+    float back = heightAt(grid - ivec2(0, 1));
+    float front = heightAt(grid + ivec2(0, 1));
+    normCoord = normalize(vec3(left - right, 2.0 * cellSize, back - front));
+
+    fragPos = vec3(chunkOrigin.x + float(grid.x) * cellSize, height, chunkOrigin.y + float(grid.y) * cellSize);
+    texCoord = fragPos.xz * textureScale;
+    gl_Position = projection * view * vec4(fragPos, 1.0);
+}
@@ -0,0 +1,637 @@
+#ifndef AABB_TREE_HPP
+#define AABB_TREE_HPP
+
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../Camera/Frustum.hpp"
+
+namespace spatial
+{
+    using namespace glm;
+
+    // dynamic bounding volume tree over boxes (Model3D world bounds) for culling, picking and overlap tests
+    // without looking at every object. leaves keep "fat" boxes grown by margin, so objects that move a little
+    // don't touch the tree; ones that leave theirs are reinserted by a surface area heuristic descent and the
+    // path back up is kept balanced with AVL style rotations (the same scheme as box2d's b2DynamicTree).
+    // rebuild() redoes the whole hierarchy top down with a binned SAH, for bulk loads or once incremental
+    // updates have worn it down. proxy ids stay the same through everything
+    class AabbTree
+    {
+    public:
+        static constexpr int nullNode = -1;
+
+        struct Node
+        {
+            vec3 minBounds;
+            vec3 maxBounds;
+            int parent; // next free node while on the free list
+            int left;
+            int right;
+            int height; // 0 for leaves, -1 while free
+            int userData;
+
+            bool isLeaf() const { return left == nullNode; }
+        };
+
+        float margin = 0.1f; // how far leaf boxes are grown on each side
+
+    private:
+        std::vector<Node> nodes;
+        int root = nullNode;
+        int freeList = nullNode;
+        int proxyCount = 0;
+
+        // traversal stack that only touches the heap for very deep trees
+        struct NodeStack
+        {
+            int fixed[128];
+            std::vector<int> overflow;
+            int count = 0;
+
+            void push(int node)
+            {
+                if (count < 128)
+                    fixed[count] = node;
+                else
+                    overflow.push_back(node);
+                count++;
+            }
+
+            int pop()
+            {
+                count--;
+                if (count < 128)
+                    return fixed[count];
+                int node = overflow.back();
+                overflow.pop_back();
+                return node;
+            }
+
+            bool empty() const { return count == 0; }
+        };
+
+    public:
+        // returns the proxy id for move/remove
+        int insert(const vec3 &minBounds, const vec3 &maxBounds, int userData)
+        {
+            int proxy = allocateNode();
+            nodes[proxy].minBounds = minBounds - vec3(margin);
+            nodes[proxy].maxBounds = maxBounds + vec3(margin);
+            nodes[proxy].userData = userData;
+            nodes[proxy].height = 0;
+
+            insertLeaf(proxy);
+            proxyCount++;
+            return proxy;
+        }
+
+        void remove(int proxy)
+        {
+            removeLeaf(proxy);
+            freeNode(proxy);
+            proxyCount--;
+        }
+
+        // reinserts the proxy if the box left its fat one, true if the tree changed
+        bool move(int proxy, const vec3 &minBounds, const vec3 &maxBounds)
+        {
+            Node &leaf = nodes[proxy];
+            if (minBounds.x >= leaf.minBounds.x && minBounds.y >= leaf.minBounds.y && minBounds.z >= leaf.minBounds.z &&
+                maxBounds.x <= leaf.maxBounds.x && maxBounds.y <= leaf.maxBounds.y && maxBounds.z <= leaf.maxBounds.z)
+                return false;
+
+            removeLeaf(proxy);
+            nodes[proxy].minBounds = minBounds - vec3(margin);
+            nodes[proxy].maxBounds = maxBounds + vec3(margin);
+            insertLeaf(proxy);
+            return true;
+        }
+
+        // change a leaf box without restructuring, call refit() once they're all set
+        void setBounds(int proxy, const vec3 &minBounds, const vec3 &maxBounds)
+        {
+            nodes[proxy].minBounds = minBounds - vec3(margin);
+            nodes[proxy].maxBounds = maxBounds + vec3(margin);
+        }
+
+        // grow or shrink every internal box to fit its children again, keeps the structure as it is
+        void refit()
+        {
+            if (root != nullNode)
+                refitNode(root);
+        }
+
+        // throw the internal nodes away and build them again top down with a binned SAH
+        void rebuild()
+        {
+            std::vector<int> leaves;
+            leaves.reserve(proxyCount);
+            for (int i = 0; i < int(nodes.size()); i++)
+            {
+                if (nodes[i].height == 0)
+                    leaves.push_back(i);
+                else if (nodes[i].height > 0)
+                    freeNode(i);
+            }
+
+            root = leaves.empty() ? nullNode : buildRange(leaves, 0, int(leaves.size()));
+            if (root != nullNode)
+                nodes[root].parent = nullNode;
+        }
+
+        // callback(userData) for every proxy whose box touches the given one, return false from it to stop
+        template <typename Callback>
+        void queryOverlap(const vec3 &minBounds, const vec3 &maxBounds, Callback callback) const
+        {
+            if (root == nullNode)
+                return;
+
+            NodeStack stack;
+            stack.push(root);
+            while (!stack.empty())
+            {
+                const Node &node = nodes[stack.pop()];
+                if (!overlaps(node.minBounds, node.maxBounds, minBounds, maxBounds))
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    if (!callback(node.userData))
+                        return;
+                }
+                else
+                {
+                    stack.push(node.left);
+                    stack.push(node.right);
+                }
+            }
+        }
+
+        // callback(userData) for every proxy inside or crossing the frustum, return false from it to stop.
+        // a node fully inside a plane stops testing that plane for everything below it
+        template <typename Callback>
+        void queryFrustum(const gd::Frustum &frustum, Callback callback) const
+        {
+            if (root == nullNode)
+                return;
+
+            NodeStack stack;
+            stack.push(root << 6 | 0x3f);
+            while (!stack.empty())
+            {
+                int entry = stack.pop();
+                const Node &node = nodes[entry >> 6];
+                int planeMask = entry & 0x3f;
+
+                bool outside = false;
+                for (int i = 0; i < 6 && !outside; i++)
+                {
+                    if (!(planeMask & (1 << i)))
+                        continue;
+
+                    const vec4 &plane = frustum.planes[i];
+                    vec3 furthest(plane.x >= 0.f ? node.maxBounds.x : node.minBounds.x,
+                                  plane.y >= 0.f ? node.maxBounds.y : node.minBounds.y,
+                                  plane.z >= 0.f ? node.maxBounds.z : node.minBounds.z);
+                    vec3 nearest(plane.x >= 0.f ? node.minBounds.x : node.maxBounds.x,
+                                 plane.y >= 0.f ? node.minBounds.y : node.maxBounds.y,
+                                 plane.z >= 0.f ? node.minBounds.z : node.maxBounds.z);
+
+                    if (dot(vec3(plane), furthest) + plane.w < 0.f)
+                        outside = true;
+                    else if (dot(vec3(plane), nearest) + plane.w >= 0.f)
+                        planeMask &= ~(1 << i);
+                }
+                if (outside)
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    if (!callback(node.userData))
+                        return;
+                }
+                else
+                {
+                    stack.push(node.left << 6 | planeMask);
+                    stack.push(node.right << 6 | planeMask);
+                }
+            }
+        }
+
+        // closest hit along origin + direction * t for t in [0, maxDistance]. callback(userData, boxDistance, maxDistance)
+        // tests the actual object and returns its hit distance, or a negative number for a miss. the ray gets
+        // shorter with every hit so only closer candidates are tested after that. returns the hit's userData or -1
+        template <typename Callback>
+        int raycast(const vec3 &origin, const vec3 &direction, float maxDistance, float &hitDistance, Callback callback) const
+        {
+            int hit = -1;
+            hitDistance = maxDistance;
+            if (root == nullNode)
+                return hit;
+
+            vec3 inverseDirection = 1.f / direction;
+
+            NodeStack stack;
+            stack.push(root);
+            while (!stack.empty())
+            {
+                const Node &node = nodes[stack.pop()];
+                float entry = rayEntry(origin, inverseDirection, node.minBounds, node.maxBounds, hitDistance);
+                if (entry < 0.f)
+                    continue;
+
+                if (node.isLeaf())
+                {
+                    float distance = callback(node.userData, entry, hitDistance);
+                    if (distance >= 0.f && distance <= hitDistance)
+                    {
+                        hit = node.userData;
+                        hitDistance = distance;
+                    }
+                    continue;
+                }
+
+                // nearer child on top so its hits shorten the ray before the other one is looked at
+                float leftEntry = rayEntry(origin, inverseDirection, nodes[node.left].minBounds, nodes[node.left].maxBounds, hitDistance);
+                float rightEntry = rayEntry(origin, inverseDirection, nodes[node.right].minBounds, nodes[node.right].maxBounds, hitDistance);
+                if (leftEntry <= rightEntry)
+                {
+                    if (rightEntry >= 0.f)
+                        stack.push(node.right);
+                    if (leftEntry >= 0.f)
+                        stack.push(node.left);
+                }
+                else
+                {
+                    if (leftEntry >= 0.f)
+                        stack.push(node.left);
+                    if (rightEntry >= 0.f)
+                        stack.push(node.right);
+                }
+            }
+            return hit;
+        }
+
+        // same, with the (fat) leaf boxes standing in for the objects
+        int raycast(const vec3 &origin, const vec3 &direction, float maxDistance, float &hitDistance) const
+        {
+            return raycast(origin, direction, maxDistance, hitDistance, [](int, float boxDistance, float)
+                           { return boxDistance; });
+        }
+
+        int getUserData(int proxy) const { return nodes[proxy].userData; }
+        const vec3 &getFatMin(int proxy) const { return nodes[proxy].minBounds; }
+        const vec3 &getFatMax(int proxy) const { return nodes[proxy].maxBounds; }
+        int getProxyCount() const { return proxyCount; }
+        int getHeight() const { return root == nullNode ? 0 : nodes[root].height; }
+
+        // total internal node area over the root's, what SAH minimises. lower means cheaper queries
+        float getAreaRatio() const
+        {
+            if (root == nullNode)
+                return 0.f;
+
+            float total = 0.f;
+            for (const Node &node : nodes)
+            {
+                if (node.height > 0)
+                    total += area(node.minBounds, node.maxBounds);
+            }
+            return total / area(nodes[root].minBounds, nodes[root].maxBounds);
+        }
+
+    private:
+        static float area(const vec3 &minBounds, const vec3 &maxBounds)
+        {
+            vec3 size = maxBounds - minBounds;
+            return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+        }
+
+        static float unionArea(const Node &a, const Node &b)
+        {
+            return area(min(a.minBounds, b.minBounds), max(a.maxBounds, b.maxBounds));
+        }
+
+        static bool overlaps(const vec3 &minA, const vec3 &maxA, const vec3 &minB, const vec3 &maxB)
+        {
+            return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y && minA.z <= maxB.z && maxA.z >= minB.z;
+        }
+
+        // slab test, distance the ray enters the box at (0 if it starts inside) or -1 if it misses within maxDistance
+        static float rayEntry(const vec3 &origin, const vec3 &inverseDirection, const vec3 &minBounds, const vec3 &maxBounds, float maxDistance)
+        {
+            vec3 t1 = (minBounds - origin) * inverseDirection;
+            vec3 t2 = (maxBounds - origin) * inverseDirection;
+            vec3 entry = min(t1, t2);
+            vec3 exit = max(t1, t2);
+
+            float enter = std::max(std::max(entry.x, entry.y), std::max(entry.z, 0.f));
+            float leave = std::min(std::min(exit.x, exit.y), std::min(exit.z, maxDistance));
+            return enter <= leave ? enter : -1.f;
+        }
+
+        int allocateNode()
+        {
+            int index;
+            if (freeList != nullNode)
+            {
+                index = freeList;
+                freeList = nodes[index].parent;
+            }
+            else
+            {
+                index = int(nodes.size());
+                nodes.push_back(Node());
+            }
+
+            Node &node = nodes[index];
+            node.parent = node.left = node.right = nullNode;
+            node.height = 0;
+            node.userData = -1;
+            return index;
+        }
+
+        void freeNode(int index)
+        {
+            nodes[index].parent = freeList;
+            nodes[index].height = -1;
+            freeList = index;
+        }
+
+        void fitToChildren(int index)
+        {
+            Node &node = nodes[index];
+            const Node &left = nodes[node.left];
+            const Node &right = nodes[node.right];
+            node.minBounds = min(left.minBounds, right.minBounds);
+            node.maxBounds = max(left.maxBounds, right.maxBounds);
+            node.height = 1 + std::max(left.height, right.height);
+        }
+
+        void insertLeaf(int leaf)
+        {
+            if (root == nullNode)
+            {
+                root = leaf;
+                nodes[leaf].parent = nullNode;
+                return;
+            }
+
+            // walk down to the cheapest sibling: pairing with a node costs the new parent's area, going past
+            // it costs the growth of every box on the way
+            int index = root;
+            while (!nodes[index].isLeaf())
+            {
+                const Node &node = nodes[index];
+                float nodeArea = area(node.minBounds, node.maxBounds);
+                float combinedArea = unionArea(node, nodes[leaf]);
+
+                float cost = 2.f * combinedArea;
+                float inheritanceCost = 2.f * (combinedArea - nodeArea);
+
+                const Node &left = nodes[node.left];
+                const Node &right = nodes[node.right];
+                float leftCost = unionArea(left, nodes[leaf]) - (left.isLeaf() ? 0.f : area(left.minBounds, left.maxBounds)) + inheritanceCost;
+                float rightCost = unionArea(right, nodes[leaf]) - (right.isLeaf() ? 0.f : area(right.minBounds, right.maxBounds)) + inheritanceCost;
+
+                if (cost < leftCost && cost < rightCost)
+                    break;
+
+                index = leftCost < rightCost ? node.left : node.right;
+            }
+
+            int sibling = index;
+            int oldParent = nodes[sibling].parent;
+            int newParent = allocateNode();
+
+            nodes[newParent].parent = oldParent;
+            nodes[newParent].left = sibling;
+            nodes[newParent].right = leaf;
+            nodes[sibling].parent = newParent;
+            nodes[leaf].parent = newParent;
+            fitToChildren(newParent);
+
+            if (oldParent == nullNode)
+                root = newParent;
+            else if (nodes[oldParent].left == sibling)
+                nodes[oldParent].left = newParent;
+            else
+                nodes[oldParent].right = newParent;
+
+            fixUpwards(oldParent);
+        }
+
+        void removeLeaf(int leaf)
+        {
+            if (leaf == root)
+            {
+                root = nullNode;
+                return;
+            }
+
+            int parent = nodes[leaf].parent;
+            int grandParent = nodes[parent].parent;
+            int sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+
+            nodes[sibling].parent = grandParent;
+            if (grandParent == nullNode)
+                root = sibling;
+            else if (nodes[grandParent].left == parent)
+                nodes[grandParent].left = sibling;
+            else
+                nodes[grandParent].right = sibling;
+
+            freeNode(parent);
+            fixUpwards(grandParent);
+        }
+
+        // rebalance and refit from index to the root
+        void fixUpwards(int index)
+        {
+            while (index != nullNode)
+            {
+                index = balance(index);
+                fitToChildren(index);
+                index = nodes[index].parent;
+            }
+        }
+
+        // rotates the taller grandchild up if the children's heights differ by more than one, returns the
+        // node now at this position
+        int balance(int indexA)
+        {
+            Node &a = nodes[indexA];
+            if (a.isLeaf() || a.height < 2)
+                return indexA;
+
+            int indexB = a.left;
+            int indexC = a.right;
+            int difference = nodes[indexC].height - nodes[indexB].height;
+
+            if (difference > 1)
+                return rotateUp(indexA, indexC, false);
+            if (difference < -1)
+                return rotateUp(indexA, indexB, true);
+            return indexA;
+        }
+
+        // child takes a's place with a under it, a keeps its other child plus the shorter of child's two
+        int rotateUp(int indexA, int indexChild, bool childIsLeft)
+        {
+            Node &a = nodes[indexA];
+            Node &child = nodes[indexChild];
+
+            int indexF = child.left;
+            int indexG = child.right;
+            int taller = nodes[indexF].height > nodes[indexG].height ? indexF : indexG;
+            int shorter = taller == indexF ? indexG : indexF;
+
+            child.left = indexA;
+            child.parent = a.parent;
+            a.parent = indexChild;
+
+            if (child.parent == nullNode)
+                root = indexChild;
+            else if (nodes[child.parent].left == indexA)
+                nodes[child.parent].left = indexChild;
+            else
+                nodes[child.parent].right = indexChild;
+
+            child.right = taller;
+            if (childIsLeft)
+                a.left = shorter;
+            else
+                a.right = shorter;
+            nodes[shorter].parent = indexA;
+
+            fitToChildren(indexA);
+            fitToChildren(indexChild);
+            return indexChild;
+        }
+
+        void refitNode(int index)
+        {
+            Node &node = nodes[index];
+            if (node.isLeaf())
+                return;
+
+            refitNode(node.left);
+            refitNode(node.right);
+            fitToChildren(index);
+        }
+
+        int buildRange(std::vector<int> &leaves, int first, int last)
+        {
+            if (last - first == 1)
+                return leaves[first];
+
+            vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+            for (int i = first; i < last; i++)
+            {
+                vec3 centroid = (nodes[leaves[i]].minBounds + nodes[leaves[i]].maxBounds) * 0.5f;
+                centroidMin = min(centroidMin, centroid);
+                centroidMax = max(centroidMax, centroid);
+            }
+
+            vec3 extent = centroidMax - centroidMin;
+            int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+            int middle = (first + last) / 2;
+
+            if (extent[axis] > 0.f)
+            {
+                // bin the centroids along the longest axis and take the cheapest boundary between bins
+                const int binCount = 16;
+                int counts[binCount] = {};
+                vec3 binMin[binCount], binMax[binCount];
+                for (int b = 0; b < binCount; b++)
+                {
+                    binMin[b] = vec3(FLT_MAX);
+                    binMax[b] = vec3(-FLT_MAX);
+                }
+
+                float scale = binCount / extent[axis] * 0.9999f;
+                for (int i = first; i < last; i++)
+                {
+                    const Node &leaf = nodes[leaves[i]];
+                    int bin = int(((leaf.minBounds[axis] + leaf.maxBounds[axis]) * 0.5f - centroidMin[axis]) * scale);
+                    counts[bin]++;
+                    binMin[bin] = min(binMin[bin], leaf.minBounds);
+                    binMax[bin] = max(binMax[bin], leaf.maxBounds);
+                }
+
+                float rightArea[binCount];
+                int rightCount[binCount];
+                vec3 sweepMin(FLT_MAX), sweepMax(-FLT_MAX);
+                int sweepCount = 0;
+                for (int b = binCount - 1; b > 0; b--)
+                {
+                    sweepCount += counts[b];
+                    if (counts[b])
+                    {
+                        sweepMin = min(sweepMin, binMin[b]);
+                        sweepMax = max(sweepMax, binMax[b]);
+                    }
+                    rightCount[b] = sweepCount;
+                    rightArea[b] = sweepCount ? area(sweepMin, sweepMax) : 0.f;
+                }
+
+                float bestCost = FLT_MAX;
+                int bestSplit = -1;
+                sweepMin = vec3(FLT_MAX);
+                sweepMax = vec3(-FLT_MAX);
+                sweepCount = 0;
+                for (int b = 1; b < binCount; b++)
+                {
+                    sweepCount += counts[b - 1];
+                    if (counts[b - 1])
+                    {
+                        sweepMin = min(sweepMin, binMin[b - 1]);
+                        sweepMax = max(sweepMax, binMax[b - 1]);
+                    }
+                    if (!sweepCount || !rightCount[b])
+                        continue;
+
+                    float cost = sweepCount * area(sweepMin, sweepMax) + rightCount[b] * rightArea[b];
+                    if (cost < bestCost)
+                    {
+                        bestCost = cost;
+                        bestSplit = b;
+                    }
+                }
+
+                if (bestSplit > 0)
+                {
+                    float boundary = centroidMin[axis] + bestSplit / scale;
+                    middle = int(std::partition(leaves.begin() + first, leaves.begin() + last, [&](int leaf)
+                                                { return (nodes[leaf].minBounds[axis] + nodes[leaf].maxBounds[axis]) * 0.5f < boundary; }) -
+                                 leaves.begin());
+                }
+            }
+
+            // everything on one spot (or on one side of the boundary), halve by position instead
+            if (middle <= first || middle >= last)
+            {
+                middle = (first + last) / 2;
+                std::nth_element(leaves.begin() + first, leaves.begin() + middle, leaves.begin() + last, [&](int a, int b)
+                                 { return nodes[a].minBounds[axis] + nodes[a].maxBounds[axis] < nodes[b].minBounds[axis] + nodes[b].maxBounds[axis]; });
+            }
+
+            int left = buildRange(leaves, first, middle);
+            int right = buildRange(leaves, middle, last);
+
+            int index = allocateNode();
+            nodes[index].left = left;
+            nodes[index].right = right;
+            nodes[left].parent = index;
+            nodes[right].parent = index;
+            fitToChildren(index);
+            return index;
+        }
+    };
+}
+
+#endif // !AABB_TREE_HPP
@@ -0,0 +1,147 @@
+#ifndef HEIGHT_FIELD_HPP
+#define HEIGHT_FIELD_HPP
+
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define HEIGHT_FIELD_SSE2
+#endif
+
+#include "HeightGenerator.hpp"
+
+namespace terrain
+{
+    // ground height queries for gameplay (vehicles, cameras), bilinear over the same samples the terrain draws.
+    // samples live in square tiles with one extra row and column, so a lookup never reads from two tiles, and
+    // the tiles sit in a direct mapped cache indexed by tile coordinates: anything within tileCells * cacheSide
+    // cells of itself never evicts its neighbours. tiles refill from the generator on a miss.
+    // not thread safe, every thread that queries gets its own (about a MB, tiles are cheap to refill)
+    class HeightField
+    {
+    public:
+        static constexpr int tileShift = 5;
+        static constexpr int tileCells = 1 << tileShift;
+        static constexpr int tileSide = tileCells + 1;
+        static constexpr int cacheSide = 16; // power of two
+
+        struct Tile
+        {
+            int x = INT_MIN;
+            int z = INT_MIN;
+            float samples[tileSide * tileSide];
+        };
+
+    private:
+        HeightGenerator generator;
+        float cellSize;
+        float inverseCellSize;
+        std::vector<Tile> tiles;
+        size_t misses = 0;
+
+    public:
+        // cellSize has to match the terrain's (chunk size / cells per chunk) for the heights to line up
+        HeightField(const HeightGenerator &generator, float cellSize = 1.f)
+            : generator(generator), cellSize(cellSize), inverseCellSize(1.f / cellSize), tiles(cacheSide * cacheSide) {}
+
+        float getHeight(float x, float z)
+        {
+            float fx = x * inverseCellSize;
+            float fz = z * inverseCellSize;
+            float cellX = std::floor(fx);
+            float cellZ = std::floor(fz);
+            int ix = int(cellX);
+            int iz = int(cellZ);
+
+            const float *corner = getTile(ix >> tileShift, iz >> tileShift).samples + (iz & (tileCells - 1)) * tileSide + (ix & (tileCells - 1));
+            float tx = fx - cellX;
+            float tz = fz - cellZ;
+
+            float lower = corner[0] + (corner[1] - corner[0]) * tx;
+            float upper = corner[tileSide] + (corner[tileSide + 1] - corner[tileSide]) * tx;
+            return lower + (upper - lower) * tz;
+        }
+
+        // heights[i] = getHeight(x[i], z[i]), four at a time. the arrays can't overlap heights
+        void getHeights(const float *x, const float *z, float *heights, size_t count)
+        {
+            size_t i = 0;
+#ifdef HEIGHT_FIELD_SSE2
+            const __m128 scale = _mm_set1_ps(inverseCellSize);
+            const __m128 one = _mm_set1_ps(1.f);
+
+            alignas(16) int cellX[4], cellZ[4];
+            alignas(16) float c00[4], c10[4], c01[4], c11[4];
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 fx = _mm_mul_ps(_mm_loadu_ps(x + i), scale);
+                __m128 fz = _mm_mul_ps(_mm_loadu_ps(z + i), scale);
+
+                // floor without sse4.1: truncate, then step down where that rounded up (negatives)
+                __m128 floorX = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+                __m128 floorZ = _mm_cvtepi32_ps(_mm_cvttps_epi32(fz));
+                floorX = _mm_sub_ps(floorX, _mm_and_ps(_mm_cmpgt_ps(floorX, fx), one));
+                floorZ = _mm_sub_ps(floorZ, _mm_and_ps(_mm_cmpgt_ps(floorZ, fz), one));
+
+                _mm_store_si128((__m128i *)cellX, _mm_cvttps_epi32(floorX));
+                _mm_store_si128((__m128i *)cellZ, _mm_cvttps_epi32(floorZ));
+
+                // no gathers in sse2, the corners are fetched one lane at a time
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    const float *corner = getTile(cellX[lane] >> tileShift, cellZ[lane] >> tileShift).samples +
+                                          (cellZ[lane] & (tileCells - 1)) * tileSide + (cellX[lane] & (tileCells - 1));
+                    c00[lane] = corner[0];
+                    c10[lane] = corner[1];
+                    c01[lane] = corner[tileSide];
+                    c11[lane] = corner[tileSide + 1];
+                }
+
+                __m128 tx = _mm_sub_ps(fx, floorX);
+                __m128 tz = _mm_sub_ps(fz, floorZ);
+                __m128 a = _mm_load_ps(c00), b = _mm_load_ps(c10), c = _mm_load_ps(c01), d = _mm_load_ps(c11);
+
+                __m128 lower = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), tx));
+                __m128 upper = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), tx));
+                _mm_storeu_ps(heights + i, _mm_add_ps(lower, _mm_mul_ps(_mm_sub_ps(upper, lower), tz)));
+            }
+#endif
+            for (; i < count; i++)
+                heights[i] = getHeight(x[i], z[i]);
+        }
+
+        // tiles that had to be generated since construction
+        size_t getMissCount() const { return misses; }
+
+    private:
+        const Tile &getTile(int tileX, int tileZ)
+        {
+            Tile &tile = tiles[(tileZ & (cacheSide - 1)) * cacheSide + (tileX & (cacheSide - 1))];
+            if (tile.x != tileX || tile.z != tileZ)
+                fill(tile, tileX, tileZ);
+            return tile;
+        }
+
+        void fill(Tile &tile, int tileX, int tileZ)
+        {
+            tile.x = tileX;
+            tile.z = tileZ;
+            misses++;
+
+            // same global sample positions as the terrain chunks use
+            int firstX = tileX * tileCells;
+            int firstZ = tileZ * tileCells;
+            for (int row = 0; row < tileSide; row++)
+            {
+                for (int column = 0; column < tileSide; column++)
+                    tile.samples[row * tileSide + column] = generator.getHeight(float(firstX + column) * cellSize, float(firstZ + row) * cellSize);
+            }
+        }
+    };
+}
+
+#endif // !HEIGHT_FIELD_HPP
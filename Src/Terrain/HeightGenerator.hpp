@@ -0,0 +1,77 @@
+#ifndef HEIGHT_GENERATOR_HPP
+#define HEIGHT_GENERATOR_HPP
+
+#include <cmath>
+#include <cstdint>
+
+namespace terrain
+{
+    // procedural heights as a pure function of world x/z, so any thread can generate any chunk
+    // and neighbouring chunks always agree on their shared edge
+    class HeightGenerator
+    {
+    public:
+        uint32_t seed = 1337;
+        float amplitude = 40.f;           // roughly the tallest hill
+        float baseFrequency = 1.f / 256.f; // the widest features are this many units apart
+        int octaves = 5;
+
+        // the area the scene was built on stays flat at y = 0 and rises into hills further out
+        float flatRadius = 150.f;
+        float blendDistance = 150.f;
+
+    public:
+        float getHeight(float x, float z) const
+        {
+            float total = 0.f;
+            float weight = 1.f;
+            float weights = 0.f;
+            float frequency = baseFrequency;
+
+            for (int octave = 0; octave < octaves; octave++)
+            {
+                total += valueNoise(x * frequency, z * frequency, seed + uint32_t(octave)) * weight;
+                weights += weight;
+                weight *= 0.5f;
+                frequency *= 2.f;
+            }
+
+            float t = (std::sqrt(x * x + z * z) - flatRadius) / blendDistance;
+            t = t < 0.f ? 0.f : (t > 1.f ? 1.f : t);
+            t = t * t * (3.f - 2.f * t);
+
+            return total / weights * amplitude * t;
+        }
+
+    private:
+        // -1..1 from a lattice point
+        static float lattice(int x, int z, uint32_t seed)
+        {
+            uint32_t h = uint32_t(x) * 0x8da6b343u ^ uint32_t(z) * 0xd8163841u ^ seed * 0xcb1ab31fu;
+            h ^= h >> 13;
+            h *= 0x5bd1e995u;
+            h ^= h >> 15;
+            return float(h & 0xffffff) * (2.f / float(0xffffff)) - 1.f;
+        }
+
+        // smoothly interpolated lattice values, the quintic fade keeps slopes continuous across cells
+        static float valueNoise(float x, float z, uint32_t seed)
+        {
+            float cellX = std::floor(x), cellZ = std::floor(z);
+            int ix = int(cellX), iz = int(cellZ);
+            float fx = x - cellX, fz = z - cellZ;
+
+            float u = fx * fx * fx * (fx * (fx * 6.f - 15.f) + 10.f);
+            float v = fz * fz * fz * (fz * (fz * 6.f - 15.f) + 10.f);
+
+            float a = lattice(ix, iz, seed), b = lattice(ix + 1, iz, seed);
+            float c = lattice(ix, iz + 1, seed), d = lattice(ix + 1, iz + 1, seed);
+
+            float top = a + (b - a) * u;
+            float bottom = c + (d - c) * u;
+            return top + (bottom - top) * v;
+        }
+    };
+}
+
+#endif // !HEIGHT_GENERATOR_HPP
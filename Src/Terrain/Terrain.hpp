@@ -0,0 +1,417 @@
+#ifndef TERRAIN_HPP
+#define TERRAIN_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "../Camera/Frustum.hpp"
+#include "../Jobs/JobSystem.hpp"
+#include "../Models/Model3D.hpp"
+#include "../Profiling/AllocationTracker.hpp"
+#include "../Profiling/Profiler.hpp"
+#include "../Shaders/Shader.hpp"
+#include "HeightGenerator.hpp"
+
+namespace terrain
+{
+    using namespace glm;
+
+    // one square of terrain. heights are generated on a worker, the texture is made on the render thread
+    struct Chunk
+    {
+        int x = 0; // chunk coordinates, the chunk starts at (x, z) * chunk size
+        int z = 0;
+        int cellsPerSide = 0;
+        float cellSize = 1.f;
+
+        // (cellsPerSide + 3)^2 samples: the chunk's own plus one extra all around so normals match the neighbours
+        std::vector<float> heights;
+        float minHeight = 0.f;
+        float maxHeight = 0.f;
+
+        jobs::Counter generated;
+        bool uploaded = false;
+        GLuint heightTexture = 0;
+        int lod = 0;
+
+        int getSide() const { return cellsPerSide + 3; }
+
+        void generate(const HeightGenerator &generator)
+        {
+            PROFILE_SCOPE("Generate Chunk");
+
+            int side = getSide();
+            heights.resize(size_t(side) * side);
+            minHeight = std::numeric_limits<float>::max();
+            maxHeight = -std::numeric_limits<float>::max();
+
+            // positions come from the global sample index so shared edges are bit for bit the same
+            int firstX = x * cellsPerSide - 1;
+            int firstZ = z * cellsPerSide - 1;
+
+            for (int row = 0; row < side; row++)
+            {
+                for (int column = 0; column < side; column++)
+                {
+                    float height = generator.getHeight(float(firstX + column) * cellSize, float(firstZ + row) * cellSize);
+                    heights[size_t(row) * side + column] = height;
+
+                    // the border only feeds normals, it isn't drawn
+                    if (row > 0 && row < side - 1 && column > 0 && column < side - 1)
+                    {
+                        minHeight = std::min(minHeight, height);
+                        maxHeight = std::max(maxHeight, height);
+                    }
+                }
+            }
+        }
+    };
+
+    // heightfield terrain split into square chunks that stream in and out around a point (the player).
+    // chunks generate on the job system and upload a few per frame, then draw as geomipmaps: one shared
+    // index buffer per lod over a grid the vertex shader displaces with the chunk's height texture.
+    // edges next to a coarser chunk follow that chunk's edge in the vertex shader so seams never crack
+    class Terrain
+    {
+    public:
+        static const int cellsPerChunk = 64;
+        static const int samplesPerSide = cellsPerChunk + 1;
+        static const int lodLevels = 5; // the coarsest lod is 4x4 quads
+
+        struct DrawStats
+        {
+            int chunks = 0;
+            long long triangles = 0;
+            long long fullDetailTriangles = 0;
+        };
+
+        float chunkSize = 64.f;
+        int loadRadius = 8;         // chunks kept loaded in each direction around the center
+        size_t maxChunks = 320;     // budget, the furthest chunks are dropped to stay under it
+        int maxJobsPerFrame = 8;    // new chunks queued per update
+        int maxUploadsPerFrame = 4; // finished chunks turned into textures per update
+        float lodDistance = 96.f;   // full detail closer than this, a level coarser every time the distance doubles
+        float textureScale = 1.f / 8.f;
+
+        // don't change while chunks are generating
+        HeightGenerator generator;
+
+    private:
+        jobs::JobSystem &jobSystem;
+        std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunks;
+
+        GLuint emptyVAO = 0;
+        GLuint indexBuffers[lodLevels] = {};
+        int indexCounts[lodLevels] = {};
+        GLuint grassTexture = 0;
+
+    public:
+        // needs a current context
+        Terrain(jobs::JobSystem &jobSystem, const std::string &texturePath) : jobSystem(jobSystem)
+        {
+            // positions come from gl_VertexID and the height texture, so there's nothing to put in the VAO
+            glGenVertexArrays(1, &emptyVAO);
+            glBindVertexArray(emptyVAO);
+
+            glGenBuffers(lodLevels, indexBuffers);
+            for (int lod = 0; lod < lodLevels; lod++)
+            {
+                int step = 1 << lod;
+                std::vector<GLushort> indices;
+                for (int z = 0; z < cellsPerChunk; z += step)
+                {
+                    for (int x = 0; x < cellsPerChunk; x += step)
+                    {
+                        GLushort a = GLushort(z * samplesPerSide + x);
+                        GLushort b = GLushort(z * samplesPerSide + x + step);
+                        GLushort c = GLushort((z + step) * samplesPerSide + x);
+                        GLushort d = GLushort((z + step) * samplesPerSide + x + step);
+                        indices.insert(indices.end(), {a, c, b, b, c, d});
+                    }
+                }
+
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffers[lod]);
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+                indexCounts[lod] = int(indices.size());
+            }
+            glBindVertexArray(0);
+
+            model::ImageData grass = model::ModelSource::loadImage(texturePath);
+            grassTexture = model::Model3D::uploadTexture(grass, GL_TEXTURE0);
+            if (grassTexture)
+            {
+                // it tiles a lot, nearest sampling shimmers badly at a distance
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            }
+        }
+
+        ~Terrain()
+        {
+            clear();
+            glDeleteBuffers(lodLevels, indexBuffers);
+            glDeleteVertexArrays(1, &emptyVAO);
+            glDeleteTextures(1, &grassTexture);
+        }
+
+        // render thread, once a frame: queue chunks that came into range, upload finished ones, drop far ones
+        void update(const vec3 &center)
+        {
+            PROFILE_SCOPE("Terrain Update");
+
+            int centerX = int(std::floor(center.x / chunkSize));
+            int centerZ = int(std::floor(center.z / chunkSize));
+
+            int uploads = 0;
+            for (auto &entry : chunks)
+            {
+                Chunk &chunk = *entry.second;
+                if (uploads < maxUploadsPerFrame && !chunk.uploaded && chunk.generated.isDone())
+                {
+                    upload(chunk);
+                    uploads++;
+                }
+            }
+
+            // a little past the load radius before anything goes, so driving along a chunk border doesn't thrash
+            for (auto it = chunks.begin(); it != chunks.end();)
+            {
+                Chunk &chunk = *it->second;
+                if (getRing(chunk.x, chunk.z, centerX, centerZ) > loadRadius + 1 && chunk.generated.isDone())
+                {
+                    glDeleteTextures(1, &chunk.heightTexture);
+                    it = chunks.erase(it);
+                }
+                else
+                    ++it;
+            }
+
+            requestAround(centerX, centerZ, maxJobsPerFrame);
+        }
+
+        // generate and upload everything in range before the first frame
+        void loadAround(const vec3 &center)
+        {
+            PROFILE_SCOPE("Terrain Load");
+
+            int centerX = int(std::floor(center.x / chunkSize));
+            int centerZ = int(std::floor(center.z / chunkSize));
+            requestAround(centerX, centerZ, std::numeric_limits<int>::max());
+
+            for (auto &entry : chunks)
+            {
+                jobSystem.wait(entry.second->generated);
+                if (!entry.second->uploaded)
+                    upload(*entry.second);
+            }
+        }
+
+        // the terrain only has a color texture, lights come from the scene
+        uint32_t getShaderFeatures(uint32_t sceneFeatures) const
+        {
+            return (sceneFeatures & ~shader::feature::material) | (grassTexture ? shader::feature::Texture : 0u);
+        }
+
+        // shader needs its per frame uniforms (camera, lights) set already
+        DrawStats draw(shader::Shader &shader, const gd::Frustum &frustum, const vec3 &cameraPosition)
+        {
+            PROFILE_SCOPE("Terrain Draw");
+            DrawStats stats;
+            glUseProgram(shader.shaderProgram);
+
+            // every lod first, each chunk needs its neighbours' to stitch its edges
+            for (auto &entry : chunks)
+            {
+                Chunk &chunk = *entry.second;
+                if (chunk.uploaded)
+                    chunk.lod = selectLod(chunk, cameraPosition);
+            }
+
+            glUniform1f(shader.getUniformLocation("cellSize"), getCellSize());
+            glUniform1i(shader.getUniformLocation("samplesPerSide"), samplesPerSide);
+            glUniform1f(shader.getUniformLocation("textureScale"), textureScale);
+            glUniform4f(shader.getUniformLocation("rgba"), 1.f, 1.f, 1.f, 1.f);
+            glUniform1i(shader.getUniformLocation("tex0"), 0);
+            glUniform1i(shader.getUniformLocation("heights"), 2);
+
+            GLint originLoc = shader.getUniformLocation("chunkOrigin");
+            GLint lodLoc = shader.getUniformLocation("lod");
+            GLint neighbourLoc = shader.getUniformLocation("neighbourLod");
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, grassTexture);
+            glActiveTexture(GL_TEXTURE2);
+            glBindVertexArray(emptyVAO);
+
+            for (auto &entry : chunks)
+            {
+                Chunk &chunk = *entry.second;
+                if (!chunk.uploaded)
+                    continue;
+
+                vec3 minBounds(chunk.x * chunkSize, chunk.minHeight, chunk.z * chunkSize);
+                vec3 maxBounds = minBounds + vec3(chunkSize, chunk.maxHeight - chunk.minHeight, chunkSize);
+                if (!frustum.intersectsAABB(minBounds, maxBounds))
+                    continue;
+
+                // -x, +x, -z, +z. a missing neighbour leaves a gap there anyway, so it counts as the same lod
+                glUniform4i(neighbourLoc, getNeighbourLod(chunk, -1, 0), getNeighbourLod(chunk, 1, 0),
+                            getNeighbourLod(chunk, 0, -1), getNeighbourLod(chunk, 0, 1));
+                glUniform2f(originLoc, minBounds.x, minBounds.z);
+                glUniform1i(lodLoc, chunk.lod);
+
+                glBindTexture(GL_TEXTURE_2D, chunk.heightTexture);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffers[chunk.lod]);
+                glDrawElements(GL_TRIANGLES, indexCounts[chunk.lod], GL_UNSIGNED_SHORT, 0);
+
+                stats.chunks++;
+                stats.triangles += indexCounts[chunk.lod] / 3;
+                stats.fullDetailTriangles += indexCounts[0] / 3;
+            }
+
+            glActiveTexture(GL_TEXTURE0);
+            return stats;
+        }
+
+        size_t getChunkCount() const { return chunks.size(); }
+        float getCellSize() const { return chunkSize / cellsPerChunk; }
+
+        // drop every chunk, call before the job system goes away
+        void clear()
+        {
+            // jobs write into the chunks, let them finish first
+            for (auto &entry : chunks)
+                jobSystem.wait(entry.second->generated);
+            for (auto &entry : chunks)
+                glDeleteTextures(1, &entry.second->heightTexture);
+            chunks.clear();
+        }
+
+    private:
+        static uint64_t getKey(int x, int z) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(z); }
+
+        // how many chunks away, in the square rings the loading goes by
+        static int getRing(int x, int z, int centerX, int centerZ) { return std::max(std::abs(x - centerX), std::abs(z - centerZ)); }
+
+        // queue the missing chunks in range, nearest first. streaming is expected to allocate (the list, the chunks,
+        // their jobs), with nothing missing it doesn't
+        void requestAround(int centerX, int centerZ, int limit)
+        {
+            profiling::AllowAllocations allow;
+            std::vector<std::pair<int, uint64_t>> missing;
+            for (int z = centerZ - loadRadius; z <= centerZ + loadRadius; z++)
+            {
+                for (int x = centerX - loadRadius; x <= centerX + loadRadius; x++)
+                {
+                    uint64_t key = getKey(x, z);
+                    if (!chunks.count(key))
+                        missing.push_back({(x - centerX) * (x - centerX) + (z - centerZ) * (z - centerZ), key});
+                }
+            }
+            std::sort(missing.begin(), missing.end());
+
+            int queued = 0;
+            for (const auto &request : missing)
+            {
+                if (queued >= limit)
+                    break;
+
+                int x = int(int32_t(uint32_t(request.second >> 32)));
+                int z = int(int32_t(uint32_t(request.second)));
+
+                // over budget, make room by dropping something further away than this one
+                if (chunks.size() >= maxChunks && !evictFurthest(centerX, centerZ, request.first))
+                    break;
+
+                std::unique_ptr<Chunk> chunk(new Chunk());
+                chunk->x = x;
+                chunk->z = z;
+                chunk->cellsPerSide = cellsPerChunk;
+                chunk->cellSize = getCellSize();
+
+                Chunk *target = chunk.get();
+                const HeightGenerator *source = &generator;
+                chunks[request.second] = std::move(chunk);
+
+                jobSystem.run([target, source]()
+                              { target->generate(*source); },
+                              &target->generated);
+                queued++;
+            }
+        }
+
+        // drops the furthest finished chunk if it's further than distanceSquared (in chunks), false if there's none
+        bool evictFurthest(int centerX, int centerZ, int distanceSquared)
+        {
+            auto furthest = chunks.end();
+            int furthestDistance = distanceSquared;
+            for (auto it = chunks.begin(); it != chunks.end(); ++it)
+            {
+                Chunk &chunk = *it->second;
+                int distance = (chunk.x - centerX) * (chunk.x - centerX) + (chunk.z - centerZ) * (chunk.z - centerZ);
+                if (distance > furthestDistance && chunk.generated.isDone())
+                {
+                    furthest = it;
+                    furthestDistance = distance;
+                }
+            }
+
+            if (furthest == chunks.end())
+                return false;
+
+            glDeleteTextures(1, &furthest->second->heightTexture);
+            chunks.erase(furthest);
+            return true;
+        }
+
+        void upload(Chunk &chunk)
+        {
+            PROFILE_SCOPE("Upload Chunk");
+
+            int side = chunk.getSide();
+            glActiveTexture(GL_TEXTURE2);
+            glGenTextures(1, &chunk.heightTexture);
+            glBindTexture(GL_TEXTURE_2D, chunk.heightTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, side, side, 0, GL_RED, GL_FLOAT, chunk.heights.data());
+            // only read with texelFetch, but it still has to be complete without mips
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glActiveTexture(GL_TEXTURE0);
+
+            chunk.uploaded = true;
+        }
+
+        int selectLod(const Chunk &chunk, const vec3 &cameraPosition) const
+        {
+            vec3 minBounds(chunk.x * chunkSize, chunk.minHeight, chunk.z * chunkSize);
+            vec3 maxBounds = minBounds + vec3(chunkSize, chunk.maxHeight - chunk.minHeight, chunkSize);
+            float distance = length(cameraPosition - clamp(cameraPosition, minBounds, maxBounds));
+
+            if (distance < lodDistance)
+                return 0;
+            return std::min(lodLevels - 1, 1 + int(std::log2(distance / lodDistance)));
+        }
+
+        int getNeighbourLod(const Chunk &chunk, int offsetX, int offsetZ) const
+        {
+            auto it = chunks.find(getKey(chunk.x + offsetX, chunk.z + offsetZ));
+            if (it == chunks.end() || !it->second->uploaded)
+                return chunk.lod;
+            return it->second->lod;
+        }
+    };
+}
+
+#endif // !TERRAIN_HPP
@@ -0,0 +1,1154 @@
+// micro benchmarks for the cpu side systems, no window or GL needed
+// build from Src/: g++ -std=c++17 -O2 Tools/Benchmarks.cpp -o Benchmarks -pthread
+// run: ./Benchmarks            (everything)
+//      ./Benchmarks jobs       (only benchmarks whose name starts with "jobs")
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb_image.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "../Extensions/tiny_obj_loader.h"
+
+#define ALLOCATION_TRACKER_IMPLEMENTATION
+#include "../Profiling/AllocationTracker.hpp"
+
+#include "../Assets/AssetArchive.hpp"
+#include "../Core/Orientation.hpp"
+#include "../Jobs/JobSystem.hpp"
+#include "../Models/MeshBvh.hpp"
+#include "../Physics/CollisionWorld.hpp"
+#include "../Rendering/OcclusionCuller.hpp"
+#include "../Scene/SceneFile.hpp"
+#include "../Scene/TransformStore.hpp"
+#include "../Spatial/AabbTree.hpp"
+#include "../Terrain/HeightField.hpp"
+
+#include "../Models/ModelSource.cpp"
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// ---------------------------------------------------------------- jobs
+
+// cost of submitting and finishing empty jobs
+static void benchmarkJobSpawn()
+{
+    const int jobCount = 1000000;
+
+    // the default is 0 or 1 on small machines, each count runs once
+    std::vector<int> workerCounts{0, 1};
+    if (std::find(workerCounts.begin(), workerCounts.end(), jobs::JobSystem::defaultWorkerCount()) == workerCounts.end())
+        workerCounts.push_back(jobs::JobSystem::defaultWorkerCount());
+    for (int workers : workerCounts)
+    {
+        jobs::JobSystem system(workers);
+        jobs::Counter counter;
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < jobCount; i++)
+            system.run([]() {}, &counter);
+        system.wait(counter);
+        double elapsed = secondsSince(start);
+
+        std::cout << "jobs.spawn     workers " << workers << ": " << elapsed * 1e9 / jobCount << " ns/job" << std::endl;
+    }
+}
+
+// parallelFor over a fixed amount of math at 1 to 32 workers
+static void benchmarkJobScaling()
+{
+    const size_t count = 1 << 22;
+    std::vector<float> values(count, 1.f);
+
+    auto work = [&values](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+            values[i] = std::sqrt(values[i] * 1.0001f + 0.5f);
+    };
+
+    std::cout << "jobs.scaling   hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    double baseline = 0.0;
+    for (int threads : {1, 2, 4, 8, 16, 32})
+    {
+        // the submitting thread helps, so n threads means n - 1 workers
+        jobs::JobSystem system(threads - 1);
+
+        Clock::time_point start = Clock::now();
+        for (int pass = 0; pass < 20; pass++)
+            system.parallelFor(0, count, 16384, work);
+        double elapsed = secondsSince(start);
+
+        if (threads == 1)
+            baseline = elapsed;
+
+        std::cout << "jobs.scaling   threads " << threads << ": " << elapsed * 1000.0 << " ms, speedup " << baseline / elapsed << "x" << std::endl;
+    }
+}
+
+// ---------------------------------------------------------------- terrain
+
+// ground queries the way gameplay makes them: vehicles spread around one area, out in the hills
+static void benchmarkHeightQueries()
+{
+    const size_t count = 1 << 20;
+    const int passes = 20;
+
+    std::vector<float> x(count), z(count), heights(count);
+    uint32_t random = 12345;
+    for (size_t i = 0; i < count; i++)
+    {
+        random = random * 1664525u + 1013904223u;
+        x[i] = 1000.f + float(random >> 8) / float(1 << 24) * 400.f;
+        random = random * 1664525u + 1013904223u;
+        z[i] = -800.f + float(random >> 8) / float(1 << 24) * 400.f;
+    }
+
+    terrain::HeightGenerator generator;
+    terrain::HeightField field(generator);
+    field.getHeights(x.data(), z.data(), heights.data(), count); // fill the tiles first
+
+    Clock::time_point start = Clock::now();
+    float checksum = 0.f;
+    for (int pass = 0; pass < passes; pass++)
+    {
+        for (size_t i = 0; i < count; i++)
+            heights[i] = field.getHeight(x[i], z[i]);
+        checksum += heights[pass];
+    }
+    double scalar = secondsSince(start);
+
+    start = Clock::now();
+    for (int pass = 0; pass < passes; pass++)
+    {
+        field.getHeights(x.data(), z.data(), heights.data(), count);
+        checksum += heights[pass];
+    }
+    double batched = secondsSince(start);
+
+    // worst case: every query on a new tile
+    const size_t coldCount = 20000;
+    terrain::HeightField cold(generator);
+    start = Clock::now();
+    for (size_t i = 0; i < coldCount; i++)
+        checksum += cold.getHeight(float(i) * 33.f, float(i % 7) * 1000.f);
+    double coldTime = secondsSince(start);
+
+    std::cout << "terrain.height scalar:  " << count * passes / scalar / 1e6 << " M queries/s" << std::endl;
+    std::cout << "terrain.height batched: " << count * passes / batched / 1e6 << " M queries/s" << std::endl;
+    std::cout << "terrain.height tile miss: " << coldTime * 1e6 / cold.getMissCount() << " us/tile (checksum " << checksum << ")" << std::endl;
+}
+
+// ---------------------------------------------------------------- spatial
+
+// boxes spread over ground at the same density for every count, the way vehicles and props would be
+static void benchmarkAabbTree()
+{
+    using glm::vec3;
+
+    for (int count : {10000, 100000, 1000000})
+    {
+        float worldSize = std::sqrt(float(count)) * 20.f;
+        uint32_t random = 777;
+        auto next = [&random]()
+        {
+            random = random * 1664525u + 1013904223u;
+            return float(random >> 8) / float(1 << 24);
+        };
+
+        std::vector<vec3> minBounds(count), maxBounds(count);
+        for (int i = 0; i < count; i++)
+        {
+            minBounds[i] = vec3(next() * worldSize, next() * 5.f, next() * worldSize);
+            maxBounds[i] = minBounds[i] + vec3(2.f + next() * 6.f, 2.f + next() * 3.f, 2.f + next() * 6.f);
+        }
+
+        spatial::AabbTree tree;
+        tree.margin = 1.f; // a couple of frames of driving
+        std::vector<int> proxies(count);
+
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < count; i++)
+            proxies[i] = tree.insert(minBounds[i], maxBounds[i], i);
+        double insertTime = secondsSince(start);
+        float insertedRatio = tree.getAreaRatio();
+        int insertedHeight = tree.getHeight();
+
+        start = Clock::now();
+        tree.rebuild();
+        double rebuildTime = secondsSince(start);
+
+        // a tenth of everything drives a little each frame
+        const int frames = 30;
+        int reinserted = 0;
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int i = 0; i < count; i += 10)
+            {
+                vec3 step(next() - 0.5f, 0.f, next() - 0.5f);
+                minBounds[i] += step;
+                maxBounds[i] += step;
+                reinserted += tree.move(proxies[i], minBounds[i], maxBounds[i]) ? 1 : 0;
+            }
+        }
+        double moveTime = secondsSince(start) / frames;
+
+        // a camera in the middle looking along the ground, 300 units of view distance
+        gd::Frustum frustum;
+        vec3 eye(worldSize * 0.5f, 10.f, worldSize * 0.5f);
+        frustum.extract(glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 300.f) * glm::lookAt(eye, eye + vec3(1.f, -0.1f, 0.3f), vec3(0.f, 1.f, 0.f)));
+
+        const int frustumQueries = 200;
+        int visible = 0;
+        start = Clock::now();
+        for (int q = 0; q < frustumQueries; q++)
+            tree.queryFrustum(frustum, [&visible](int)
+                              { visible++; return true; });
+        double frustumTime = secondsSince(start) / frustumQueries;
+
+        const int rayCount = 200000;
+        int hits = 0;
+        start = Clock::now();
+        for (int r = 0; r < rayCount; r++)
+        {
+            vec3 origin(next() * worldSize, 3.f, next() * worldSize);
+            vec3 direction = glm::normalize(vec3(next() - 0.5f, (next() - 0.5f) * 0.1f, next() - 0.5f));
+            float distance;
+            hits += tree.raycast(origin, direction, 200.f, distance) >= 0 ? 1 : 0;
+        }
+        double rayTime = secondsSince(start);
+
+        const int overlapCount = 200000;
+        int overlaps = 0;
+        start = Clock::now();
+        for (int o = 0; o < overlapCount; o++)
+        {
+            vec3 corner(next() * worldSize, 0.f, next() * worldSize);
+            tree.queryOverlap(corner, corner + vec3(10.f), [&overlaps](int)
+                              { overlaps++; return true; });
+        }
+        double overlapTime = secondsSince(start);
+
+        std::cout << "spatial.aabb   " << count << " objects: insert " << insertTime * 1e9 / count << " ns each (height " << insertedHeight
+                  << ", area ratio " << insertedRatio << "), SAH rebuild " << rebuildTime * 1000.0 << " ms (height " << tree.getHeight()
+                  << ", area ratio " << tree.getAreaRatio() << ")" << std::endl;
+        std::cout << "spatial.aabb   " << count << " objects: move 10% " << moveTime * 1000.0 << " ms/frame (" << reinserted / frames
+                  << " reinserted), frustum " << frustumTime * 1e6 << " us (" << visible / frustumQueries << " visible), "
+                  << rayCount / rayTime / 1e6 << " M rays/s (" << hits * 100 / rayCount << "% hit), "
+                  << overlapCount / overlapTime / 1e6 << " M overlap queries/s" << std::endl;
+    }
+}
+
+// ---------------------------------------------------------------- models
+
+// ray casts against a real mesh (run from Src/ so the obj is found), single threaded
+static void benchmarkMeshBvh()
+{
+    using glm::vec3;
+
+    const char *path = "Models/source/t90broken.obj";
+    tinyobj::attrib_t attributes;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warning, error;
+    if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warning, &error, path) || shapes.empty())
+    {
+        std::cout << "mesh.bvh couldn't load " << path << std::endl;
+        return;
+    }
+
+    std::vector<float> positions;
+    for (const tinyobj::index_t &index : shapes[0].mesh.indices)
+    {
+        for (int axis = 0; axis < 3; axis++)
+            positions.push_back(attributes.vertices[index.vertex_index * 3 + axis]);
+    }
+    int vertexCount = int(positions.size() / 3);
+
+    model::MeshBvh bvh;
+    Clock::time_point start = Clock::now();
+    bvh.build(positions.data(), 3, 0, vertexCount);
+    double buildTime = secondsSince(start);
+
+    vec3 minBounds = bvh.nodes[0].minBounds, maxBounds = bvh.nodes[0].maxBounds;
+    vec3 center = (minBounds + maxBounds) * 0.5f;
+    float radius = glm::length(maxBounds - minBounds);
+
+    // from a sphere around the mesh towards random points in its box, so about half of them hit
+    uint32_t random = 4242;
+    auto next = [&random]()
+    {
+        random = random * 1664525u + 1013904223u;
+        return float(random >> 8) / float(1 << 24);
+    };
+    const int rayCount = 1000000;
+    std::vector<vec3> origins(rayCount), directions(rayCount);
+    for (int r = 0; r < rayCount; r++)
+    {
+        vec3 onSphere = glm::normalize(vec3(next() - 0.5f, next() - 0.5f, next() - 0.5f) + vec3(1e-6f));
+        origins[r] = center + onSphere * radius;
+        vec3 target = minBounds + (maxBounds - minBounds) * vec3(next(), next(), next());
+        directions[r] = glm::normalize(target - origins[r]);
+    }
+
+    int hits = 0;
+    double distanceSum = 0.0;
+    start = Clock::now();
+    for (int r = 0; r < rayCount; r++)
+    {
+        float distance;
+        if (bvh.raycast(origins[r], directions[r], radius * 2.f, distance))
+        {
+            hits++;
+            distanceSum += distance;
+        }
+    }
+    double rayTime = secondsSince(start);
+
+    int segmentHits = 0;
+    start = Clock::now();
+    for (int r = 0; r < rayCount; r++)
+        segmentHits += bvh.intersectsSegment(origins[r], origins[r] + directions[r] * radius) ? 1 : 0;
+    double segmentTime = secondsSince(start);
+
+    // every triangle for every ray, on a few of the same rays, and check both agree
+    const int bruteCount = 2000;
+    int mismatches = 0;
+    start = Clock::now();
+    for (int r = 0; r < bruteCount; r++)
+    {
+        float nearest = radius * 2.f;
+        bool bruteHit = false;
+        for (int i = 0; i + 2 < vertexCount; i += 3)
+        {
+            const float *p = positions.data() + i * 3;
+            float t = model::MeshBvh::intersectTriangle(origins[r], directions[r], vec3(p[0], p[1], p[2]), vec3(p[3], p[4], p[5]), vec3(p[6], p[7], p[8]));
+            if (t <= nearest)
+            {
+                nearest = t;
+                bruteHit = true;
+            }
+        }
+
+        float distance;
+        bool bvhHit = bvh.raycast(origins[r], directions[r], radius * 2.f, distance);
+        if (bvhHit != bruteHit || (bvhHit && std::fabs(distance - nearest) > 1e-4f))
+            mismatches++;
+    }
+    double bruteTime = secondsSince(start);
+
+    std::cout << "mesh.bvh       " << bvh.getTriangleCount() << " triangles: build " << buildTime * 1000.0 << " ms, " << bvh.nodes.size()
+              << " nodes (" << bvh.nodes.size() * sizeof(model::BvhNode) / 1024 << " KB)" << std::endl;
+    std::cout << "mesh.bvh       " << rayCount / rayTime / 1e6 << " M rays/s/core (" << hits * 100 / rayCount << "% hit, avg "
+              << distanceSum / std::max(hits, 1) << "), " << rayCount / segmentTime / 1e6 << " M segments/s (" << segmentHits * 100 / rayCount << "% blocked), brute force "
+              << bruteCount / bruteTime / 1e3 << " K rays/s (" << mismatches << " mismatches)" << std::endl;
+}
+
+// ---------------------------------------------------------------- physics
+
+// vehicles driving between static props at the same density for every count, one collision step per frame.
+// the last run is the game's case, one tank among lots of props
+static void benchmarkCollision()
+{
+    using glm::vec3;
+
+    // roughly a tank, in its own frame (z up like the objs, rotated onto the ground below)
+    const vec3 localMin(-1.8f, -3.5f, -0.7f), localMax(1.8f, 3.5f, 1.6f);
+
+    const int counts[][2] = {{100, 100}, {500, 500}, {2000, 2000}, {1, 10000}};
+    for (const int *count : counts)
+    {
+        int vehicleCount = count[0];
+        int propCount = count[1];
+        float worldSize = std::sqrt(float(vehicleCount + propCount)) * 12.f;
+        uint32_t random = 99;
+        auto next = [&random]()
+        {
+            random = random * 1664525u + 1013904223u;
+            return float(random >> 8) / float(1 << 24);
+        };
+        auto transformAt = [](const vec3 &position, float heading)
+        {
+            glm::mat4 transform = glm::translate(glm::mat4(1.f), position);
+            transform = glm::rotate(transform, glm::radians(heading), vec3(0.f, 1.f, 0.f));
+            return glm::rotate(transform, glm::radians(-90.f), vec3(1.f, 0.f, 0.f));
+        };
+
+        physics::CollisionWorld world;
+        for (int i = 0; i < propCount; i++)
+            world.addBody(localMin, localMax, transformAt(vec3(next() * worldSize, 0.f, next() * worldSize), next() * 360.f), true);
+
+        std::vector<vec3> positions(vehicleCount);
+        std::vector<float> headings(vehicleCount);
+        std::vector<int> ids(vehicleCount);
+        for (int i = 0; i < vehicleCount; i++)
+        {
+            positions[i] = vec3(next() * worldSize, 0.f, next() * worldSize);
+            headings[i] = next() * 360.f;
+            ids[i] = world.addBody(localMin, localMax, transformAt(positions[i], headings[i]), false);
+        }
+
+        // the sweep and the static tree have to find exactly the pairs a brute force box check finds, leaving out
+        // the ones between two props
+        size_t bodyCount = world.getBodyCount();
+        std::vector<vec3> minBounds(bodyCount), maxBounds(bodyCount);
+        for (size_t i = 0; i < bodyCount; i++)
+            world.getBox(int(i)).getBounds(minBounds[i], maxBounds[i]);
+        size_t sweptPairs = 0, brutePairs = 0;
+        world.findPairs([&sweptPairs](int, int)
+                        { sweptPairs++; });
+        for (size_t a = 0; a < bodyCount; a++)
+        {
+            for (size_t b = a + 1; b < bodyCount; b++)
+            {
+                if (int(b) < propCount)
+                    continue;
+                if (minBounds[a].x <= maxBounds[b].x && maxBounds[a].x >= minBounds[b].x && minBounds[a].y <= maxBounds[b].y &&
+                    maxBounds[a].y >= minBounds[b].y && minBounds[a].z <= maxBounds[b].z && maxBounds[a].z >= minBounds[b].z)
+                    brutePairs++;
+            }
+        }
+
+        // 60 ticks a second of driving in circles
+        const int frames = 300;
+        size_t pairs = 0, contacts = 0;
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int i = 0; i < vehicleCount; i++)
+            {
+                headings[i] += 1.f;
+                float heading = glm::radians(headings[i]);
+                positions[i] += vec3(std::sin(heading), 0.f, std::cos(heading)) * 0.25f;
+                world.setTransform(ids[i], transformAt(positions[i], headings[i]));
+            }
+
+            world.step();
+            pairs += world.getPairCount();
+            contacts += world.getContactCount();
+
+            for (int i = 0; i < vehicleCount; i++)
+                positions[i] += world.getCorrection(ids[i]);
+        }
+        double frameTime = secondsSince(start) / frames;
+
+        // the box test on its own, over pairs that were close enough to reach it
+        std::vector<physics::OrientedBox> boxes;
+        for (size_t i = 0; i < world.getBodyCount(); i++)
+            boxes.push_back(world.getBox(int(i)));
+        const int testCount = 5000000;
+        int touching = 0;
+        start = Clock::now();
+        for (int t = 0; t < testCount; t++)
+        {
+            physics::OrientedBox a = boxes[t % boxes.size()];
+            physics::OrientedBox b = boxes[(t * 7 + 1) % boxes.size()];
+            b.center = a.center + vec3(next() - 0.5f, 0.f, next() - 0.5f) * 20.f;
+            physics::Contact contact;
+            touching += physics::separateOnGround(a, b, contact) ? 1 : 0;
+        }
+        double testTime = secondsSince(start);
+
+        std::cout << "physics.collision " << vehicleCount << " vehicles + " << propCount << " props: step " << frameTime * 1000.0
+                  << " ms/frame, " << pairs / frames << " pair tests/frame (" << contacts / frames << " contacts), broadphase "
+                  << sweptPairs << " pairs vs " << brutePairs << " brute force" << std::endl;
+        std::cout << "physics.collision box test: " << testCount / testTime / 1e6 << " M pairs/s (" << touching * 100 / testCount << "% touching)" << std::endl;
+    }
+}
+
+// ---------------------------------------------------------------- scene
+
+// world matrices and bounds for every object, the soa store against the per object glm path Model3D used
+static void benchmarkTransforms()
+{
+    using glm::vec3;
+    using glm::mat4;
+
+    struct ObjectTransform
+    {
+        vec3 position, rotation, scale;
+    };
+    auto buildTransform = [](const ObjectTransform &object)
+    {
+        mat4 transform = glm::translate(mat4(1.f), object.position);
+        transform = glm::scale(transform, object.scale);
+        transform = glm::rotate(transform, glm::radians(object.rotation.x), vec3(1.f, 0.f, 0.f));
+        transform = glm::rotate(transform, glm::radians(object.rotation.y), vec3(0.f, 1.f, 0.f));
+        return glm::rotate(transform, glm::radians(object.rotation.z), vec3(0.f, 0.f, 1.f));
+    };
+    const vec3 localMin(-1.8f, -3.5f, -0.7f), localMax(1.8f, 3.5f, 1.6f);
+
+    for (int count : {100000, 1000000})
+    {
+        uint32_t random = 5;
+        auto next = [&random]()
+        {
+            random = random * 1664525u + 1013904223u;
+            return float(random >> 8) / float(1 << 24);
+        };
+
+        std::vector<ObjectTransform> objects(count);
+        scene::TransformStore store;
+        for (int i = 0; i < count; i++)
+        {
+            objects[i] = {vec3(next(), next(), next()) * 1000.f, vec3(-90.f, 0.f, next() * 360.f), vec3(1.f)};
+            store.create(objects[i].position, gd::Orientation::eulerToQuat(objects[i].rotation), objects[i].scale, localMin, localMax);
+        }
+
+        const int frames = 20;
+        std::vector<mat4> matrices(count);
+        std::vector<vec3> minBounds(count), maxBounds(count);
+        Clock::time_point start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                objects[i].rotation.z += 1.f;
+                matrices[i] = buildTransform(objects[i]);
+
+                vec3 center = vec3(matrices[i] * glm::vec4((localMin + localMax) * 0.5f, 1.f));
+                vec3 extents = (localMax - localMin) * 0.5f;
+                vec3 span = glm::abs(vec3(matrices[i][0])) * extents.x + glm::abs(vec3(matrices[i][1])) * extents.y + glm::abs(vec3(matrices[i][2])) * extents.z;
+                minBounds[i] = center - span;
+                maxBounds[i] = center + span;
+            }
+        }
+        double objectTime = secondsSince(start) / frames;
+
+        // the same degree a frame as a quaternion step in each object's own frame
+        const glm::quat step = glm::angleAxis(glm::radians(1.f), vec3(0.f, 0.f, 1.f));
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int i = 0; i < count; i++)
+                store.setRotation(i, store.getRotation(i) * step);
+            store.updateWorldMatrices();
+        }
+        double storeTime = secondsSince(start) / frames;
+
+        // both went through the same rotations, they should agree
+        float error = 0.f;
+        for (int i = 0; i < count; i += 97)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                for (int row = 0; row < 4; row++)
+                    error = std::max(error, std::fabs(matrices[i][column][row] - store.getWorldMatrix(i)[column][row]));
+            }
+        }
+
+        // a tenth of them moving, the rest stay clean and are skipped
+        start = Clock::now();
+        for (int frame = 0; frame < frames; frame++)
+        {
+            for (int i = frame % 10; i < count; i += 10)
+                store.setRotation(i, store.getRotation(i) * step);
+            store.updateWorldMatrices();
+        }
+        double sparseTime = secondsSince(start) / frames;
+
+        std::cout << "scene.transforms " << count << " objects: per object glm " << objectTime * 1000.0 << " ms/frame, soa simd "
+                  << storeTime * 1000.0 << " ms/frame (" << objectTime / storeTime << "x, max error " << error << "), 10% dirty "
+                  << sparseTime * 1000.0 << " ms/frame" << std::endl;
+    }
+}
+
+// a scene with tens of thousands of placements: parsing the text form against reading the compiled one
+static void benchmarkSceneFile()
+{
+    const int placementCount = 50000;
+    const char *assetNames[]{"fictionaltank", "generictank", "ozelot", "sherman", "deadtree"};
+    uint32_t random = 29;
+    auto next = [&random]()
+    {
+        random = random * 1664525u + 1013904223u;
+        return float(random >> 8) / float(1 << 24);
+    };
+
+    std::string text = "asset tank Models/source/tanknew.obj Models/texture/tank.jpg Models/texture/tank_normal.jpg\n";
+    for (const char *name : assetNames)
+        text += std::string("asset ") + name + " Models/source/" + name + ".obj Models/texture/" + name + ".jpg\n";
+    // same files under another name, loads once
+    text += "asset tree Models/source/deadtree.obj Models/texture/deadtree.jpg\n";
+    text += "player tank 0 0.7 0 -90 0 0\n";
+    char line[160];
+    for (int i = 0; i < placementCount; i++)
+    {
+        snprintf(line, sizeof(line), "place %s %.2f 1 %.2f -90 0 %.1f\n", assetNames[i % 5], next() * 2000.f - 1000.f, next() * 2000.f - 1000.f, next() * 360.f);
+        text += line;
+    }
+    text += "dirlight dirLight 0 -10 5 0.1 0.2 32 0.3 0.3 1 0.3 0.3 1\npointlight pointLight 0 0 -5 0.5 0.7 32 1 1 1 1 1 1 attached\n";
+
+    const int runs = 10;
+    scene::SceneFile parsed;
+    Clock::time_point start = Clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        parsed.clear();
+        parsed.parseText(text, "benchmark.scene");
+    }
+    double parseTime = secondsSince(start) / runs;
+
+    std::string compiledPath = (std::filesystem::temp_directory_path() / "benchmark.sceneb").string();
+    start = Clock::now();
+    parsed.save(compiledPath, scene::SceneFile::hashText(text));
+    double saveTime = secondsSince(start);
+
+    scene::SceneFile compiled;
+    start = Clock::now();
+    for (int run = 0; run < runs; run++)
+        compiled.load(compiledPath);
+    double loadTime = secondsSince(start) / runs;
+
+    start = Clock::now();
+    uint64_t hash = 0;
+    for (int run = 0; run < runs; run++)
+        hash ^= scene::SceneFile::hashText(text);
+    double hashTime = secondsSince(start) / runs;
+
+    int mismatches = compiled.placements.size() == parsed.placements.size() ? 0 : 1;
+    for (size_t i = 0; i < std::min(compiled.placements.size(), parsed.placements.size()); i++)
+    {
+        if (std::memcmp(&compiled.placements[i], &parsed.placements[i], sizeof(scene::SceneFile::Placement)) != 0)
+            mismatches++;
+    }
+    std::error_code error;
+    uintmax_t compiledBytes = std::filesystem::file_size(compiledPath, error);
+    std::filesystem::remove(compiledPath, error);
+
+    std::cout << "scene.file     " << parsed.placements.size() << " placements of " << parsed.assets.size() << " assets: text "
+              << text.size() / 1024 << " KB parsed in " << parseTime * 1000.0 << " ms, compiled " << compiledBytes / 1024
+              << " KB saved in " << saveTime * 1000.0 << " ms, loaded in " << loadTime * 1000.0 << " ms ("
+              << parseTime / loadTime << "x, " << mismatches << " mismatches), checking the text's hash "
+              << hashTime * 1000.0 << " ms" << (hash ? "" : " ") << std::endl;
+}
+
+// ---------------------------------------------------------------- assets
+
+// getting a mesh's vertices into memory: parsing the obj, reading a flat file, and the archive mapped
+// (stored entries used where they are, lz4 ones unpacked). the files are in the page cache after the first run,
+// so this is the cpu side of loading, not the disk
+static void benchmarkArchive()
+{
+    const char *path = "Models/source/t90broken.obj";
+    tinyobj::attrib_t attributes;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warning, error;
+    Clock::time_point start = Clock::now();
+    if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warning, &error, path) || shapes.empty())
+    {
+        std::cout << "assets.archive couldn't load " << path << std::endl;
+        return;
+    }
+    double parseTime = secondsSince(start);
+
+    // interleaved like Model3D uploads them: position, normal, texcoord
+    std::vector<float> vertices;
+    for (const tinyobj::shape_t &shape : shapes)
+    {
+        for (const tinyobj::index_t &index : shape.mesh.indices)
+        {
+            for (int axis = 0; axis < 3; axis++)
+                vertices.push_back(attributes.vertices[index.vertex_index * 3 + axis]);
+            for (int axis = 0; axis < 3; axis++)
+                vertices.push_back(index.normal_index >= 0 ? attributes.normals[index.normal_index * 3 + axis] : 0.f);
+            for (int axis = 0; axis < 2; axis++)
+                vertices.push_back(index.texcoord_index >= 0 ? attributes.texcoords[index.texcoord_index * 2 + axis] : 0.f);
+        }
+    }
+    const uint8_t *bytes = (const uint8_t *)vertices.data();
+    size_t size = vertices.size() * sizeof(float);
+
+    const int runs = 10;
+    std::vector<uint8_t> compressed;
+    start = Clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        compressed.clear();
+        assets::lz4::compress(bytes, size, compressed);
+    }
+    double compressTime = secondsSince(start) / runs;
+
+    std::vector<uint8_t> unpacked(size);
+    start = Clock::now();
+    for (int run = 0; run < runs; run++)
+        assets::lz4::decompress(compressed.data(), compressed.size(), unpacked.data(), size);
+    double decompressTime = secondsSince(start) / runs;
+    int mismatches = std::memcmp(unpacked.data(), bytes, size) != 0;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string rawPath = (directory / "benchmark.vertices").string();
+    std::string archivePath = (directory / "benchmark.pak").string();
+    {
+        std::ofstream raw(rawPath, std::ios::binary | std::ios::trunc);
+        raw.write((const char *)bytes, size);
+    }
+    assets::ArchiveWriter writer;
+    writer.add("stored", assets::Mesh, bytes, size, false);
+    writer.add("compressed", assets::Mesh, bytes, size, true);
+    writer.write(archivePath);
+
+    // every run touches each page, a mapping that's never read costs nothing
+    const size_t page = 4096;
+    uint64_t checksum = 0;
+    start = Clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        std::ifstream raw(rawPath, std::ios::binary);
+        std::vector<uint8_t> read(size);
+        raw.read((char *)read.data(), size);
+        for (size_t offset = 0; offset < size; offset += page)
+            checksum += read[offset];
+    }
+    double readTime = secondsSince(start) / runs;
+
+    assets::AssetArchive &archive = assets::AssetArchive::get();
+    archive.open(archivePath);
+    const assets::AssetArchive::Entry *entry = archive.find("compressed", assets::Mesh);
+    uint64_t storedOffset = archive.find("stored", assets::Mesh)->offset;
+
+    // mapped fresh each run so the page faults are counted too, it's what the archive does on open
+    start = Clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        assets::MappedFile file;
+        file.open(archivePath);
+        const unsigned char *mapped = file.data() + storedOffset;
+        for (size_t offset = 0; offset < size; offset += page)
+            checksum += mapped[offset];
+        if (run == 0)
+            mismatches += std::memcmp(mapped, bytes, size) != 0;
+    }
+    double mappedTime = secondsSince(start) / runs;
+
+    start = Clock::now();
+    for (int run = 0; run < runs; run++)
+    {
+        std::vector<uint8_t> read(entry->size);
+        archive.unpack(*entry, read.data());
+        checksum += read[0];
+    }
+    double packedTime = secondsSince(start) / runs;
+    archive.close();
+
+    std::error_code removeError;
+    std::filesystem::remove(rawPath, removeError);
+    std::filesystem::remove(archivePath, removeError);
+
+    double megabytes = size / (1024.0 * 1024.0);
+    std::cout << "assets.archive " << vertices.size() / 8 << " vertices (" << size / 1024 << " KB): obj parsed in " << parseTime * 1000.0
+              << " ms, read in " << readTime * 1000.0 << " ms, mapped in " << mappedTime * 1000.0 << " ms, lz4 entry in "
+              << packedTime * 1000.0 << " ms" << (checksum ? "" : " ") << std::endl;
+    std::cout << "               lz4 " << compressed.size() * 100 / size << "% of the size, compresses at " << megabytes / compressTime
+              << " MB/s, decompresses at " << megabytes / decompressTime << " MB/s (" << mismatches << " mismatches)" << std::endl;
+}
+
+// ---------------------------------------------------------------- math
+
+// what one transform, view matrix or drive step costs with euler angles (the old path) and with a quaternion
+// orientation that keeps its basis
+static void benchmarkRotation()
+{
+    using glm::mat4;
+    using glm::vec3;
+
+    const int count = 10000000;
+    uint32_t random = 17;
+    auto next = [&random]()
+    {
+        random = random * 1664525u + 1013904223u;
+        return float(random >> 8) / float(1 << 24);
+    };
+
+    std::vector<vec3> rotations(1024), positions(1024);
+    std::vector<gd::Orientation> orientations(1024);
+    for (size_t i = 0; i < rotations.size(); i++)
+    {
+        rotations[i] = vec3(next() * 360.f - 180.f, next() * 180.f - 90.f, next() * 360.f);
+        positions[i] = vec3(next(), next(), next()) * 100.f;
+        orientations[i].setEuler(rotations[i]);
+    }
+
+    // model transforms: three glm::rotate from degrees against columns straight from the basis
+    float checksum = 0.f;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        const vec3 &rotation = rotations[i & 1023];
+        mat4 transform = glm::translate(mat4(1.f), positions[i & 1023]);
+        transform = glm::scale(transform, vec3(1.f));
+        transform = glm::rotate(transform, glm::radians(rotation.x), vec3(1.f, 0.f, 0.f));
+        transform = glm::rotate(transform, glm::radians(rotation.y), vec3(0.f, 1.f, 0.f));
+        transform = glm::rotate(transform, glm::radians(rotation.z), vec3(0.f, 0.f, 1.f));
+        checksum += transform[0][1];
+    }
+    double eulerTime = secondsSince(start);
+
+    start = Clock::now();
+    for (int i = 0; i < count; i++)
+        checksum += orientations[i & 1023].toTransform(positions[i & 1023], vec3(1.f))[0][1];
+    double basisTime = secondsSince(start);
+
+    // a blended orientation between ticks has no basis yet, it's built from the quaternion
+    start = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        glm::quat blended = gd::Orientation::blend(orientations[i & 1023].value, orientations[(i + 1) & 1023].value, 0.5f);
+        checksum += gd::Orientation(blended).toTransform(positions[i & 1023], vec3(1.f))[0][1];
+    }
+    double blendTime = secondsSince(start);
+
+    // view matrices: direction and right from yaw/pitch trig then lookAt, against the basis as rows
+    start = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        const vec3 &rotation = rotations[i & 1023];
+        const vec3 &position = positions[i & 1023];
+        vec3 direction = glm::normalize(vec3(std::cos(glm::radians(rotation.y)) * std::sin(glm::radians(rotation.x)), std::sin(glm::radians(rotation.y)),
+                                             std::cos(glm::radians(rotation.y)) * std::cos(glm::radians(rotation.x))));
+        vec3 right = glm::normalize(vec3(std::sin(glm::radians(rotation.x) - 3.14f / 2.f), 0.f, std::cos(glm::radians(rotation.x) - 3.14f / 2.f)));
+        vec3 up = glm::normalize(glm::cross(right, direction));
+        checksum += glm::lookAt(position, position + direction, up)[3][2];
+    }
+    double lookAtTime = secondsSince(start);
+
+    start = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        // as Camera::generateViewMatrix builds it
+        const gd::Orientation &orientation = orientations[i & 1023];
+        const vec3 &position = positions[i & 1023];
+        vec3 right = -orientation.getAxis(0), up = orientation.getAxis(1), direction = orientation.getAxis(2);
+        mat4 view(1.f);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            view[axis][0] = right[axis];
+            view[axis][1] = up[axis];
+            view[axis][2] = -direction[axis];
+        }
+        view[3][0] = -glm::dot(right, position);
+        view[3][1] = -glm::dot(up, position);
+        view[3][2] = glm::dot(direction, position);
+        checksum += view[3][2];
+    }
+    double basisViewTime = secondsSince(start);
+
+    // one drive and turn step of the player: sin/cos of the heading against a basis read and a step quaternion
+    vec3 position(0.f);
+    float heading = 0.f;
+    start = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        heading += 0.5f;
+        position.x -= std::sin(glm::radians(heading)) * 0.25f;
+        position.z -= std::cos(glm::radians(heading)) * 0.25f;
+    }
+    double trigDriveTime = secondsSince(start);
+    checksum += position.x;
+
+    gd::Orientation tank = gd::Orientation::fromEuler(vec3(-90.f, 0.f, 0.f));
+    const glm::quat turnStep = glm::angleAxis(glm::radians(0.5f), vec3(0.f, 0.f, 1.f));
+    position = vec3(0.f);
+    start = Clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        tank.rotateLocal(turnStep);
+        position += tank.getAxis(1) * 0.25f;
+    }
+    double basisDriveTime = secondsSince(start);
+    checksum += position.x;
+
+    std::cout << "math.rotation  model transform: euler " << eulerTime * 1e9 / count << " ns, quaternion basis " << basisTime * 1e9 / count
+              << " ns, blended quaternion " << blendTime * 1e9 / count << " ns" << std::endl;
+    std::cout << "math.rotation  view matrix: trig + lookAt " << lookAtTime * 1e9 / count << " ns, basis " << basisViewTime * 1e9 / count
+              << " ns; drive step: trig " << trigDriveTime * 1e9 / count << " ns, quaternion " << basisDriveTime * 1e9 / count
+              << " ns (checksum " << checksum << ")" << std::endl;
+}
+
+// ---------------------------------------------------------------- mesh loading
+
+// the model loader against LoadObj over the same files (the full mesh and every lod next to it), in time and in
+// heap allocations through operator new. LoadObj only parses, the loader also builds the interleaved vertices with
+// tangents and reads the bvh (from ModelCache/ when it's there), and what it keeps counts toward its peak
+static void benchmarkMeshLoad()
+{
+    const std::string path = "Models/source/t90broken.obj";
+
+    std::vector<std::string> paths;
+    for (int lod = 0; lod < model::ModelSource::maxLods; lod++)
+    {
+        std::string lodPath = lod ? model::ModelSource::getLodPath(path, lod) : path;
+        if (!std::ifstream(lodPath))
+            break;
+        paths.push_back(lodPath);
+    }
+
+    // one file at a time like the old loader did, each one's arrays freed before the next
+    Clock::time_point start = Clock::now();
+    profiling::AllocationStats tinyObjStats;
+    {
+        profiling::AllocationScope heap;
+        for (const std::string &filePath : paths)
+        {
+            tinyobj::attrib_t attributes;
+            std::vector<tinyobj::shape_t> shapes;
+            std::vector<tinyobj::material_t> materials;
+            std::string warning, error;
+            if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warning, &error, filePath.c_str()))
+            {
+                std::cout << "mesh.load couldn't load " << filePath << std::endl;
+                return;
+            }
+        }
+        tinyObjStats = heap.get();
+    }
+    double tinyObjTime = secondsSince(start);
+
+    model::ModelSource source(path);
+    source.parts = model::ModelSource::MeshPart;
+    source.useArchive = false;
+    start = Clock::now();
+    profiling::AllocationStats loaderStats;
+    {
+        profiling::AllocationScope heap;
+        source.load();
+        loaderStats = heap.get();
+    }
+    double loaderTime = secondsSince(start);
+
+    size_t keptBytes = source.vertexData.capacity() * sizeof(float) + source.bvh.nodes.capacity() * sizeof(model::BvhNode) +
+                       source.bvh.vertices.capacity() * sizeof(glm::vec3);
+    std::cout << "mesh.load  " << path << " + " << paths.size() - 1 << " lods: LoadObj " << tinyObjTime * 1000 << " ms, "
+              << tinyObjStats.allocations << " allocations, peak " << tinyObjStats.peak / 1024 << " KB; loader " << loaderTime * 1000
+              << " ms, " << loaderStats.allocations << " allocations, peak " << loaderStats.peak / 1024 << " KB (" << keptBytes / 1024
+              << " KB of it kept as vertices and bvh)" << std::endl;
+}
+
+// ---------------------------------------------------------------- rendering
+
+// the ground truth for the culler: which object is in front at each pixel center when every one is drawn with its
+// full mesh (triangles, three vertices each, in object space). -1 where there's nothing
+static std::vector<int> rasterizeNearestObjects(const std::vector<glm::vec3> &triangles, const std::vector<glm::mat4> &transforms,
+                                                const glm::mat4 &viewProjection, int width, int height)
+{
+    std::vector<int> owners(size_t(width) * height, -1);
+    std::vector<float> depths(size_t(width) * height, 0.f); // 1/w, bigger is nearer
+    for (size_t object = 0; object < transforms.size(); object++)
+    {
+        glm::mat4 transform = viewProjection * transforms[object];
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3)
+        {
+            glm::vec3 screen[3];
+            bool behind = false;
+            for (int v = 0; v < 3 && !behind; v++)
+            {
+                glm::vec4 clip = transform * glm::vec4(triangles[t + v], 1.f);
+                behind = clip.w <= 1e-6f;
+                screen[v] = glm::vec3((clip.x / clip.w * 0.5f + 0.5f) * width, (clip.y / clip.w * 0.5f + 0.5f) * height, 1.f / clip.w);
+            }
+            float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[2].x - screen[0].x) * (screen[1].y - screen[0].y);
+            if (behind || area == 0.f)
+                continue;
+
+            int minX = std::max(int(std::ceil(std::min(screen[0].x, std::min(screen[1].x, screen[2].x)) - 0.5f)), 0);
+            int maxX = std::min(int(std::floor(std::max(screen[0].x, std::max(screen[1].x, screen[2].x)) - 0.5f)), width - 1);
+            int minY = std::max(int(std::ceil(std::min(screen[0].y, std::min(screen[1].y, screen[2].y)) - 0.5f)), 0);
+            int maxY = std::min(int(std::floor(std::max(screen[0].y, std::max(screen[1].y, screen[2].y)) - 0.5f)), height - 1);
+            for (int y = minY; y <= maxY; y++)
+            {
+                for (int x = minX; x <= maxX; x++)
+                {
+                    float px = x + 0.5f, py = y + 0.5f, weights[3];
+                    for (int e = 0; e < 3; e++)
+                    {
+                        const glm::vec3 &a = screen[(e + 1) % 3], &b = screen[(e + 2) % 3];
+                        weights[e] = ((b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x)) / area;
+                    }
+                    if (weights[0] < 0.f || weights[1] < 0.f || weights[2] < 0.f)
+                        continue;
+
+                    size_t pixel = size_t(y) * width + x;
+                    float depth = weights[0] * screen[0].z + weights[1] * screen[1].z + weights[2] * screen[2].z;
+                    if (depth > depths[pixel])
+                    {
+                        depths[pixel] = depth;
+                        owners[pixel] = int(object);
+                    }
+                }
+            }
+        }
+    }
+    return owners;
+}
+
+// a low view over a line of tanks parked side by side, a field of them spread out behind. every tank big enough on
+// screen is an occluder (the same triangles Model3D picks) and every box gets tested, one thread against the job
+// system. afterwards each culled tank is looked for in a full detail software render, finding one there is an error
+static void benchmarkOcclusion()
+{
+    using glm::mat4;
+    using glm::vec3;
+
+    const char *path = "Models/source/t90broken.obj";
+    model::ModelSource source(path);
+    source.parts = model::ModelSource::MeshPart;
+    source.useArchive = false;
+    source.load();
+    if (!source.success)
+    {
+        std::cout << "render.occlusion couldn't load " << path << std::endl;
+        return;
+    }
+
+    std::vector<vec3> occluder;
+    source.bvh.getLargestTriangles(source.lodVertexCount.back() / 3, occluder);
+    int vertexCount = int(occluder.size());
+
+    // stood up the way the scene places them
+    const mat4 standUp = glm::rotate(mat4(1.f), glm::radians(-90.f), vec3(1.f, 0.f, 0.f));
+    vec3 localCenter = (source.minBounds + source.maxBounds) * 0.5f, localExtents = (source.maxBounds - source.minBounds) * 0.5f;
+    auto getWorldBounds = [&](const mat4 &transform, vec3 &worldMin, vec3 &worldMax)
+    {
+        vec3 center = vec3(transform * glm::vec4(localCenter, 1.f));
+        vec3 extents = glm::abs(vec3(transform[0])) * localExtents.x + glm::abs(vec3(transform[1])) * localExtents.y + glm::abs(vec3(transform[2])) * localExtents.z;
+        worldMin = center - extents;
+        worldMax = center + extents;
+    };
+    vec3 tankMin, tankMax;
+    getWorldBounds(standUp, tankMin, tankMax);
+    vec3 tankSize = tankMax - tankMin;
+
+    uint32_t random = 2024;
+    auto next = [&random]()
+    {
+        random = random * 1664525u + 1013904223u;
+        return float(random >> 8) / float(1 << 24);
+    };
+
+    // a line of tanks side on in front of the camera hides part of the crowd behind it, out to 15 tank lengths
+    const int tankCount = 400, lineCount = 7;
+    float length = std::max(tankSize.x, tankSize.z);
+    std::vector<mat4> transforms;
+    std::vector<vec3> worldMins(tankCount), worldMaxs(tankCount);
+    for (int i = 0; i < tankCount; i++)
+    {
+        vec3 position(0.f, -tankMin.y, 0.f);
+        float heading = 0.f;
+        if (i < lineCount)
+            position.x = (i - (lineCount - 1) * 0.5f) * tankSize.x * 1.1f;
+        else
+        {
+            float distance = length * (2.f + next() * 13.f);
+            position.x = (next() - 0.5f) * distance;
+            position.z = -distance;
+            heading = next() * 6.2832f;
+        }
+        transforms.push_back(glm::translate(mat4(1.f), position) * glm::rotate(mat4(1.f), heading, vec3(0.f, 1.f, 0.f)) * standUp);
+        getWorldBounds(transforms.back(), worldMins[i], worldMaxs[i]);
+    }
+
+    vec3 eye(0.f, tankSize.y * 0.3f, length * 1.5f);
+    mat4 projection = glm::perspective(glm::radians(60.f), 1.f, 0.1f, 300.f);
+    mat4 viewProjection = projection * glm::lookAt(eye, vec3(0.f, tankSize.y * 0.3f, -length * 20.f), vec3(0.f, 1.f, 0.f));
+
+    const int width = 256, height = 256;
+    std::vector<bool> shown(tankCount, false);
+    for (int owner : rasterizeNearestObjects(source.bvh.vertices, transforms, viewProjection, width, height))
+    {
+        if (owner >= 0)
+            shown[owner] = true;
+    }
+    int hidden = int(std::count(shown.begin(), shown.end(), false));
+
+    std::vector<int> workerCounts{0};
+    if (jobs::JobSystem::defaultWorkerCount() > 0)
+        workerCounts.push_back(jobs::JobSystem::defaultWorkerCount());
+    for (int workers : workerCounts)
+    {
+        jobs::JobSystem system(workers);
+        gd::OcclusionCuller culler(system, width, height);
+
+        const int frames = 200;
+        double rasterTime = 0.0, testTime = 0.0;
+        for (int frame = 0; frame < frames; frame++)
+        {
+            Clock::time_point start = Clock::now();
+            culler.begin(viewProjection, projection);
+            for (size_t i = 0; i < transforms.size(); i++)
+                culler.addOccluder(occluder.data(), vertexCount, transforms[i], worldMins[i], worldMaxs[i]);
+            culler.render();
+            rasterTime += secondsSince(start);
+
+            start = Clock::now();
+            for (size_t i = 0; i < transforms.size(); i++)
+                culler.isVisible(worldMins[i], worldMaxs[i]);
+            testTime += secondsSince(start);
+        }
+
+        const gd::OcclusionCuller::Stats &stats = culler.getStats();
+        std::cout << "render.occlusion workers " << workers << ": raster " << rasterTime * 1000.0 / frames << " ms/frame ("
+                  << stats.occluders << " occluders, " << stats.triangles << " triangles at " << culler.getWidth() << "x" << culler.getHeight()
+                  << "), test " << testTime * 1e9 / frames / transforms.size() << " ns/box, " << stats.occluded << " of "
+                  << stats.tested << " occluded (" << hidden << " hidden in full detail)" << std::endl;
+
+        int wronglyCulled = 0;
+        for (int i = 0; i < tankCount; i++)
+        {
+            if (shown[i] && !culler.isVisible(worldMins[i], worldMaxs[i]))
+                wronglyCulled++;
+        }
+        if (wronglyCulled)
+            std::cout << "render.occlusion ERROR: " << wronglyCulled << " culled tanks show in the full detail render" << std::endl;
+    }
+}
+
+// ---------------------------------------------------------------- main
+
+struct Benchmark
+{
+    const char *name;
+    void (*run)();
+};
+
+static const Benchmark benchmarks[]{
+    {"jobs.spawn", benchmarkJobSpawn},
+    {"jobs.scaling", benchmarkJobScaling},
+    {"terrain.height", benchmarkHeightQueries},
+    {"spatial.aabb", benchmarkAabbTree},
+    {"mesh.bvh", benchmarkMeshBvh},
+    {"mesh.load", benchmarkMeshLoad},
+    {"physics.collision", benchmarkCollision},
+    {"scene.transforms", benchmarkTransforms},
+    {"scene.file", benchmarkSceneFile},
+    {"assets.archive", benchmarkArchive},
+    {"render.occlusion", benchmarkOcclusion},
+    {"math.rotation", benchmarkRotation},
+};
+
+int main(int argc, char **argv)
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+
+    for (const Benchmark &benchmark : benchmarks)
+    {
+        if (std::strncmp(benchmark.name, filter.c_str(), filter.size()) == 0)
+            benchmark.run();
+    }
+    return 0;
+}
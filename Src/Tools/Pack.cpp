@@ -0,0 +1,194 @@
+// bundles what the game loads into one archive (Assets.pak) that it maps at startup instead of opening loose files.
+// meshes go in processed (lods, tangents, bounds and bvh), textures decoded, shaders as they are.
+// build from Src/: g++ -std=c++17 -O2 Tools/Pack.cpp -o Pack -pthread
+// run: ./Pack Assets.pak Scenes/tanks.scene -texture Models/texture/Grass.png -cubemap Models/Skybox/Night -shaders Shaders
+//      -lz4 anywhere compresses the entries it helps. everything a scene places is packed, with its textures
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../stb_image.h"
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "../Extensions/tiny_obj_loader.h"
+
+#include "../Assets/AssetArchive.hpp"
+#include "../Jobs/JobSystem.hpp"
+#include "../Profiling/Profiler.hpp"
+#include "../Scene/SceneFile.hpp"
+
+#include "../Models/ModelSource.cpp"
+
+static bool compress = false;
+static assets::ArchiveWriter writer;
+
+// pixels then the info, the layout ModelSource::loadImage expects
+static void addImage(const std::string &path, const model::ImageData &image, bool flipped)
+{
+    if (!image.bytes || writer.contains(path, assets::Image))
+        return;
+
+    size_t pixelBytes = size_t(image.width) * image.height * image.channels;
+    assets::ImageInfo info{image.width, image.height, image.channels, flipped ? 1u : 0u};
+    std::vector<unsigned char> entry(pixelBytes + sizeof(info));
+    std::memcpy(entry.data(), image.bytes, pixelBytes);
+    std::memcpy(entry.data() + pixelBytes, &info, sizeof(info));
+    writer.add(path, assets::Image, entry.data(), entry.size(), compress);
+    std::cout << "  image " << path << " " << image.width << "x" << image.height << "x" << image.channels << std::endl;
+}
+
+static void addImageFile(const std::string &path, bool flipped)
+{
+    model::ImageData image = model::ModelSource::loadImage(path, flipped);
+    addImage(path, image, flipped);
+    model::ModelSource::freeImage(image);
+}
+
+// every file in the directory, named the way the game spells its paths
+static std::vector<std::string> listFiles(const std::string &directory)
+{
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const auto &file : std::filesystem::directory_iterator(directory, error))
+    {
+        if (file.is_regular_file())
+            files.push_back((std::filesystem::path(directory) / file.path().filename()).generic_string());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static bool isImage(const std::string &path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".jpg" || extension == ".jpeg" || extension == ".png";
+}
+
+// the glsl next to Shader.hpp, not the c++
+static bool isShader(const std::string &path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".vert" || extension == ".frag" || extension == ".geom" || extension == ".glsl";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: Pack out.pak [-lz4] scene.scene ... [-texture image ...] [-cubemap directory ...] [-shaders directory ...]" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::string outPath = argv[1];
+    std::vector<std::string> scenes, textures, cubemaps, shaderDirectories;
+    std::vector<std::string> *list = &scenes;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "-lz4")
+            compress = true;
+        else if (argument == "-texture")
+            list = &textures;
+        else if (argument == "-cubemap")
+            list = &cubemaps;
+        else if (argument == "-shaders")
+            list = &shaderDirectories;
+        else
+            list->push_back(argument);
+    }
+
+    // the models of every scene, each once
+    std::vector<std::unique_ptr<model::ModelSource>> sources;
+    for (const std::string &path : scenes)
+    {
+        scene::SceneFile sceneFile;
+        if (!sceneFile.load(path))
+            return 1;
+
+        std::vector<bool> placed(sceneFile.assets.size(), false);
+        for (const scene::SceneFile::Placement &placement : sceneFile.placements)
+            placed[placement.asset] = true;
+
+        for (size_t i = 0; i < sceneFile.assets.size(); i++)
+        {
+            const scene::SceneFile::Asset &asset = sceneFile.assets[i];
+            bool known = false;
+            for (const auto &source : sources)
+                known = known || source->modelPath == asset.model;
+            if (placed[i] && !known)
+                sources.emplace_back(new model::ModelSource(asset.model, asset.texture, asset.normal));
+        }
+    }
+
+    jobs::JobSystem jobSystem(jobs::JobSystem::defaultWorkerCount());
+    jobSystem.parallelFor(0, sources.size(), 1, [&sources](size_t first, size_t last)
+                          {
+        for (size_t i = first; i < last; i++)
+            sources[i]->load(); });
+
+    std::vector<unsigned char> entry;
+    for (const auto &source : sources)
+    {
+        // the game falls back to the loose files for anything missing here
+        if (!source->success)
+        {
+            std::cout << "  skipping " << source->modelPath << ", it didn't load" << std::endl;
+            continue;
+        }
+        source->writePacked(entry);
+        writer.add(source->modelPath, assets::Mesh, entry.data(), entry.size(), compress);
+        std::cout << "  mesh " << source->modelPath << " " << source->lodVertexCount.size() << " lods, " << entry.size() / 1024 << " KB" << std::endl;
+
+        addImage(source->texturePath, source->texture, true);
+        addImage(source->normalPath, source->normal, true);
+    }
+
+    for (const std::string &path : textures)
+        addImageFile(path, true);
+
+    for (const std::string &directory : cubemaps)
+    {
+        for (const std::string &path : listFiles(directory))
+        {
+            if (isImage(path))
+                addImageFile(path, false);
+        }
+    }
+
+    for (const std::string &directory : shaderDirectories)
+    {
+        for (const std::string &path : listFiles(directory))
+        {
+            if (!isShader(path))
+                continue;
+
+            std::ifstream file(path, std::ios::binary);
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            std::string source = contents.str();
+            writer.add(path, assets::Text, source.data(), source.size(), compress);
+            std::cout << "  shader " << path << std::endl;
+        }
+    }
+
+    uint64_t bytes = writer.write(outPath);
+    if (!bytes)
+    {
+        std::cout << "couldn't write " << outPath << std::endl;
+        return 1;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << outPath << ": " << writer.getEntryCount() << " entries, " << bytes / 1024 << " KB, took " << seconds << " s" << std::endl;
+    return 0;
+}
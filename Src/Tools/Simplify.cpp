@@ -0,0 +1,174 @@
+// builds lower detail versions of obj meshes next to the original (tank.obj -> tank.lod1.obj, tank.lod2.obj, ...)
+// Model3D picks them up automatically and switches between them by on-screen size
+// build from Src/: g++ -std=c++17 -O2 Tools/Simplify.cpp -o Simplify
+// run: ./Simplify Models/source/ozelot.obj Models/source/t90broken.obj
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "../Extensions/tiny_obj_loader.h"
+
+#include "../Models/MeshSimplifier.hpp"
+
+using model::MeshSimplifier;
+
+// fraction of the original triangles each lod keeps
+static const float lodRatios[]{0.5f, 0.25f, 0.1f};
+
+static std::string lodPath(const std::string &path, int lod)
+{
+    size_t dot = path.rfind('.');
+    std::string base = dot == std::string::npos ? path : path.substr(0, dot);
+    return base + ".lod" + std::to_string(lod) + ".obj";
+}
+
+// only writes the positions, uvs and normals the triangles still use
+static bool writeObj(const std::string &path, const tinyobj::attrib_t &attributes, const std::vector<MeshSimplifier::Triangle> &triangles)
+{
+    std::ofstream file(path);
+    if (!file)
+        return false;
+
+    std::vector<int> positionRemap(attributes.vertices.size() / 3, -1);
+    std::vector<int> texcoordRemap(attributes.texcoords.size() / 2, -1);
+    std::vector<int> normalRemap(attributes.normals.size() / 3, -1);
+    int positionCount = 0, texcoordCount = 0, normalCount = 0;
+
+    file << "# generated by Tools/Simplify.cpp, " << triangles.size() << " triangles\n";
+
+    for (const MeshSimplifier::Triangle &triangle : triangles)
+    {
+        for (int corner = 0; corner < 3; corner++)
+        {
+            uint32_t v = triangle.v[corner];
+            if (positionRemap[v] < 0)
+            {
+                positionRemap[v] = ++positionCount;
+                file << "v " << attributes.vertices[v * 3] << " " << attributes.vertices[v * 3 + 1] << " " << attributes.vertices[v * 3 + 2] << "\n";
+            }
+        }
+    }
+
+    for (const MeshSimplifier::Triangle &triangle : triangles)
+    {
+        for (int corner = 0; corner < 3; corner++)
+        {
+            int t = triangle.texcoord[corner];
+            if (t >= 0 && texcoordRemap[t] < 0)
+            {
+                texcoordRemap[t] = ++texcoordCount;
+                file << "vt " << attributes.texcoords[t * 2] << " " << attributes.texcoords[t * 2 + 1] << "\n";
+            }
+        }
+    }
+
+    for (const MeshSimplifier::Triangle &triangle : triangles)
+    {
+        for (int corner = 0; corner < 3; corner++)
+        {
+            int n = triangle.normal[corner];
+            if (n >= 0 && normalRemap[n] < 0)
+            {
+                normalRemap[n] = ++normalCount;
+                file << "vn " << attributes.normals[n * 3] << " " << attributes.normals[n * 3 + 1] << " " << attributes.normals[n * 3 + 2] << "\n";
+            }
+        }
+    }
+
+    for (const MeshSimplifier::Triangle &triangle : triangles)
+    {
+        file << "f";
+        for (int corner = 0; corner < 3; corner++)
+        {
+            file << " " << positionRemap[triangle.v[corner]];
+            int t = triangle.texcoord[corner], n = triangle.normal[corner];
+            if (t >= 0 || n >= 0)
+                file << "/";
+            if (t >= 0)
+                file << texcoordRemap[t];
+            if (n >= 0)
+                file << "/" << normalRemap[n];
+        }
+        file << "\n";
+    }
+
+    return bool(file);
+}
+
+static bool simplifyFile(const std::string &path)
+{
+    tinyobj::attrib_t attributes;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warning, error;
+
+    if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warning, &error, path.c_str()) || shapes.empty())
+    {
+        std::cout << path << ": couldn't load " << error << std::endl;
+        return false;
+    }
+
+    // Model3D only draws the first shape, so that's all the lods need
+    std::vector<MeshSimplifier::Triangle> triangles;
+    const std::vector<tinyobj::index_t> &indices = shapes[0].mesh.indices;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        MeshSimplifier::Triangle triangle;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            triangle.v[corner] = uint32_t(indices[i + corner].vertex_index);
+            triangle.texcoord[corner] = indices[i + corner].texcoord_index;
+            triangle.normal[corner] = indices[i + corner].normal_index;
+        }
+        triangles.push_back(triangle);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MeshSimplifier simplifier(attributes.vertices, triangles);
+    size_t original = triangles.size();
+    std::cout << path << ": " << original << " triangles" << std::endl;
+
+    // each lod continues from the previous one, so they're nested and it's one pass overall
+    int lod = 1;
+    for (float ratio : lodRatios)
+    {
+        simplifier.simplify(size_t(original * ratio));
+
+        std::string outPath = lodPath(path, lod);
+        if (!writeObj(outPath, attributes, simplifier.getTriangles()))
+        {
+            std::cout << "  couldn't write " << outPath << std::endl;
+            return false;
+        }
+
+        std::cout << "  lod" << lod << ": " << simplifier.getTriangleCount() << " triangles ("
+                  << 100.0 * simplifier.getTriangleCount() / original << "%), max error " << simplifier.getMaxError()
+                  << " -> " << outPath << std::endl;
+        lod++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  took " << seconds << " s" << std::endl;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: Simplify model.obj [more.obj ...]" << std::endl;
+        return 1;
+    }
+
+    int failed = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!simplifyFile(argv[i]))
+            failed++;
+    }
+    return failed ? 1 : 0;
+}